@@ -0,0 +1,70 @@
+#ifndef BANDWIDTH_LIMITER_HPP
+#define BANDWIDTH_LIMITER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+namespace procutil {
+
+/**
+ * @brief Token bucket shared by every concurrent fetch and clone of a scan.
+ *
+ * Each transfer charges the bytes it moved and sleeps until the returned
+ * deadline. Charges are scheduled first come, first served against one
+ * aggregate rate, so N workers together stay within the configured limit
+ * and each gets a fair share of it. A rate of zero disables that budget.
+ */
+class BandwidthLimiter {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    BandwidthLimiter(size_t down_kbps, size_t up_kbps, size_t disk_kbps);
+    BandwidthLimiter(const BandwidthLimiter&) = delete;
+    BandwidthLimiter& operator=(const BandwidthLimiter&) = delete;
+
+    /** @brief Whether any aggregate budget is configured. */
+    bool active() const;
+    bool limits_upload() const { return up_.bytes_per_sec > 0; }
+    bool limits_disk() const { return disk_.bytes_per_sec > 0; }
+
+    /**
+     * @brief Charge bytes received by one transfer.
+     *
+     * @return Time until which the caller should sleep.
+     */
+    clock::time_point charge_download(size_t bytes);
+
+    /**
+     * @brief Charge growth of the process-wide upload counter.
+     *
+     * Workers all observe the same counter, so only the increase since the
+     * previous call from any worker is charged.
+     */
+    clock::time_point charge_upload_total(size_t total_bytes);
+
+    /** @brief Charge growth of the process-wide disk I/O counter. */
+    clock::time_point charge_disk_total(size_t total_bytes);
+
+    /** Backlog tolerated before a charge has to wait. */
+    static constexpr std::chrono::milliseconds burst{100};
+
+  private:
+    struct Bucket {
+        double bytes_per_sec = 0.0;
+        clock::time_point next_free{};
+        size_t last_total = 0;
+    };
+
+    clock::time_point reserve(Bucket& bucket, size_t bytes);
+    clock::time_point reserve_total(Bucket& bucket, size_t total_bytes);
+
+    std::mutex mtx_;
+    Bucket down_;
+    Bucket up_;
+    Bucket disk_;
+};
+
+} // namespace procutil
+
+#endif // BANDWIDTH_LIMITER_HPP
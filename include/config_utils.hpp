@@ -1,7 +1,9 @@
 #ifndef CONFIG_UTILS_HPP
 #define CONFIG_UTILS_HPP
+#include <filesystem>
 #include <map>
 #include <string>
+#include <vector>
 #include "repo_options.hpp"
 #include "tui.hpp"
 
@@ -45,6 +47,39 @@ bool load_json_config(const std::string& path, std::map<std::string, std::string
                       std::map<std::string, std::map<std::string, std::string>>& repo_opts,
                       std::string& error);
 
+/**
+ * @brief Load a clone manifest from a YAML file.
+ *
+ * The file holds a `repositories` list whose items have a `url` and
+ * optionally a `path`, `branch` and `depth`. Paths are returned as
+ * written; a missing path becomes the repository name from the URL.
+ *
+ * @param path    Filesystem path to the manifest.
+ * @param entries Receives one entry per listed repository.
+ * @param error   Output string capturing a human-readable error message on
+ *                failure.
+ * @return `true` if the manifest was loaded successfully; `false` otherwise.
+ */
+bool load_yaml_manifest(const std::string& path, std::vector<ManifestEntry>& entries,
+                        std::string& error);
+
+/**
+ * @brief Load a clone manifest from a JSON file.
+ *
+ * Same layout as load_yaml_manifest().
+ */
+bool load_json_manifest(const std::string& path, std::vector<ManifestEntry>& entries,
+                        std::string& error);
+
+/**
+ * @brief Load a clone manifest, choosing the format by file extension.
+ *
+ * `.json` files are read as JSON, anything else as YAML. Relative entry
+ * paths are resolved against @p root.
+ */
+bool load_manifest(const std::string& path, const std::filesystem::path& root,
+                   std::vector<ManifestEntry>& entries, std::string& error);
+
 /**
  * @brief Load a theme definition for the text user interface.
  *
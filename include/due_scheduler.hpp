@@ -0,0 +1,94 @@
+#ifndef DUE_SCHEDULER_HPP
+#define DUE_SCHEDULER_HPP
+
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "repo_state.hpp"
+
+namespace procutil {
+
+/**
+ * @brief Per-repository check intervals learned from how often each
+ *        upstream changes.
+ *
+ * Every repository has an interval of its own between the minimum and
+ * maximum. A check that finds new upstream commits halves it and a check
+ * that finds nothing grows it by half, so busy repositories are polled
+ * often and dormant ones rarely. Due times carry a small random spread and
+ * first checks are spread over the minimum interval, so checks are spaced
+ * out over time rather than arriving as one burst per cycle.
+ */
+class DueScheduler {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    /** @brief What a check learned about the upstream. */
+    enum class Upstream {
+        Changed,   ///< New commits were found
+        Unchanged, ///< The repository was already current
+        Unknown,   ///< The check failed or was skipped
+    };
+
+    DueScheduler(std::chrono::seconds min_interval, std::chrono::seconds max_interval);
+    DueScheduler(const DueScheduler&) = delete;
+    DueScheduler& operator=(const DueScheduler&) = delete;
+
+    /** @brief Change the bounds; learned intervals are clamped to them. */
+    void set_bounds(std::chrono::seconds min_interval, std::chrono::seconds max_interval);
+
+    std::chrono::seconds min_interval();
+    std::chrono::seconds max_interval();
+
+    /**
+     * @brief When @a repo is next due. A repository seen for the first time
+     *        is given a due time within the minimum interval from @a now.
+     */
+    clock::time_point due_at(const std::filesystem::path& repo, clock::time_point now);
+
+    /**
+     * @brief Mark a check of @a repo as started; it is not due again within
+     *        its interval even if the check never reports back.
+     */
+    void started(const std::filesystem::path& repo, clock::time_point now);
+
+    /** @brief Learn from a finished check and set the next due time. */
+    void checked(const std::filesystem::path& repo, Upstream upstream, clock::time_point now);
+
+    /** @brief Do not check @a repo before @a not_before. */
+    void defer(const std::filesystem::path& repo, clock::time_point not_before);
+
+    /** @brief Learned interval of @a repo. */
+    std::chrono::seconds interval(const std::filesystem::path& repo);
+
+    /** @brief Earliest due time among @a repos, max() when there are none. */
+    clock::time_point next_due(const std::vector<std::filesystem::path>& repos,
+                               clock::time_point now);
+
+    /** @brief Forget repositories that are not in @a repos. */
+    void retain(const std::vector<std::filesystem::path>& repos);
+
+  private:
+    struct Entry {
+        clock::duration interval;
+        clock::time_point due;
+    };
+
+    Entry& entry(const std::filesystem::path& repo, clock::time_point now);
+    clock::duration clamp(clock::duration d) const;
+    clock::duration jitter(clock::duration d);
+
+    std::mutex mtx_;
+    std::unordered_map<std::filesystem::path, Entry, PathHash> entries_;
+    clock::duration min_;
+    clock::duration max_;
+    std::minstd_rand rng_;
+};
+
+} // namespace procutil
+
+#endif // DUE_SCHEDULER_HPP
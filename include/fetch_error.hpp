@@ -0,0 +1,63 @@
+#ifndef FETCH_ERROR_HPP
+#define FETCH_ERROR_HPP
+
+#include <chrono>
+#include <string>
+
+namespace git {
+
+/**
+ * @brief Failure category of a fetch.
+ *
+ * Derived from the libgit2 return code and error class and from the HTTP
+ * status in the error message, so that callers do not match strings.
+ */
+enum class FetchError {
+    None,
+    Auth,      ///< Credentials missing or rejected (401/403)
+    RateLimit, ///< Throttled by the remote (429)
+    Timeout,   ///< Network timeout or fetch deadline
+    Dns,       ///< Host name could not be resolved
+    Tls,       ///< Certificate or TLS handshake failure
+    Server,    ///< Remote server error (5xx)
+    NotFound,  ///< Repository or remote does not exist (404)
+    Network,   ///< Connection refused, reset or cut short
+    Cancelled, ///< Aborted because the scan is stopping
+    Other,
+};
+
+/**
+ * @brief Classify a failed libgit2 network operation.
+ *
+ * The return code, the HTTP status and the error class decide first; the
+ * message is only matched against specific phrases when they do not.
+ *
+ * @param code        Return code of the failing call.
+ * @param klass       libgit2 error class.
+ * @param message     libgit2 error message.
+ * @param http_status Optional output receiving the HTTP status, 0 if none.
+ * @return Error category.
+ */
+FetchError classify_fetch_error(int code, int klass, const std::string& message,
+                                int* http_status = nullptr);
+
+/**
+ * @brief Extract a retry delay the server asked for.
+ *
+ * libgit2 does not expose response headers, so the hint is read from
+ * error and sideband text such as "Retry-After: 120" or
+ * "try again in 5 minutes".
+ *
+ * @return Requested delay, or zero when none was given.
+ */
+std::chrono::seconds parse_retry_hint(const std::string& text);
+
+/** @brief Whether a failure of this kind may go away by retrying later. */
+bool is_transient(FetchError kind);
+
+/** @brief Short lower-case name of @a kind for logs and status lines. */
+const char* fetch_error_name(FetchError kind);
+
+} // namespace git
+
+#endif // FETCH_ERROR_HPP
@@ -2,11 +2,28 @@
 #define GIT_UTILS_HPP
 
 #include <git2.h>
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <filesystem>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <ctime>
+#include <vector>
+#include "fetch_error.hpp"
+#include "pack_maintenance.hpp"
+#include "repo_options.hpp"
+#include "string_pool.hpp"
+
+namespace procutil {
+class BandwidthLimiter;
+class TrafficBudget;
+} // namespace procutil
+
+struct Libgit2Options;
 
 namespace git {
 namespace fs = std::filesystem;
@@ -22,8 +39,29 @@ struct GitInitGuard {
     ~GitInitGuard(); ///< Calls `git_libgit2_shutdown()`
 };
 
-void set_libgit_timeout(unsigned int seconds);
 void set_proxy(const std::string& url);
+void set_status_cache(bool enabled);
+
+/**
+ * @brief Bound how long libgit2 waits to connect and for each read or write
+ *        on a remote's socket.
+ *
+ * Connecting and reading the ref advertisement fire no callbacks, so the
+ * per-fetch deadline and cancellation token cannot interrupt a remote that
+ * stops responding there. The socket timeout returns control to them. It is
+ * process-wide and set from the global pull timeout, or two minutes when
+ * there is none. Without libgit2 1.7 this does nothing.
+ */
+void set_server_timeouts(std::chrono::seconds timeout);
+
+/**
+ * @brief Apply process-wide libgit2 tuning: object cache, pack mmap windows,
+ *        strict object checks and fsync.
+ *
+ * Settings left unset revert to libgit2's defaults, so calling this again
+ * after a config reload drops settings that were removed.
+ */
+void apply_libgit2_options(const Libgit2Options& opts);
 
 // RAII wrappers for libgit2 resources
 template <typename T, void (*Free)(T*)> struct GitHandle {
@@ -41,9 +79,217 @@ using remote_ptr = GitHandle<git_remote, git_remote_free>;
 using object_ptr = GitHandle<git_object, git_object_free>;
 using reference_ptr = GitHandle<git_reference, git_reference_free>;
 using status_list_ptr = GitHandle<git_status_list, git_status_list_free>;
+using tree_ptr = GitHandle<git_tree, git_tree_free>;
+using diff_ptr = GitHandle<git_diff, git_diff_free>;
+using odb_ptr = GitHandle<git_odb, git_odb_free>;
+using packbuilder_ptr = GitHandle<git_packbuilder, git_packbuilder_free>;
+using revwalk_ptr = GitHandle<git_revwalk, git_revwalk_free>;
 
 // The utility functions below assume libgit2 is already initialized.
 
+class MirrorCache;
+class RemoteHeadCache;
+
+/**
+ * @brief Settings for the fetch performed by a RepoSession.
+ */
+struct FetchParams {
+    bool use_credentials = false; ///< Use the credential callback
+    size_t down_limit_kbps = 0;   ///< Download rate limit in KiB/s
+    size_t up_limit_kbps = 0;     ///< Upload rate limit in KiB/s
+    size_t disk_limit_kbps = 0;   ///< Disk I/O rate limit in KiB/s
+    procutil::BandwidthLimiter* shared_limiter = nullptr; ///< Aggregate budget of all workers
+    procutil::TrafficBudget* traffic_budget = nullptr;    ///< Receives bytes fetched
+    const std::function<void(int)>* progress_cb = nullptr; ///< Progress in percent
+    bool ls_remote_probe = false; ///< List remote refs first and skip unneeded fetches
+    TagPolicy tags = TagPolicy::All; ///< Tags downloaded with the fetch
+    bool single_branch = false;      ///< Fetch only the requested branch
+    bool prune = false;              ///< Delete remote-tracking refs gone from the remote
+    std::vector<std::string> refspecs; ///< Explicit refspecs, overriding single_branch
+    int depth = 0; ///< Shallow fetch depth in commits, 0 keeps the current history
+    std::chrono::seconds timeout{0}; ///< Limit for a single fetch, 0 for none
+    /// Point past which no fetch may run, e.g. the end of a repo's max runtime
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    const std::atomic<bool>* running = nullptr; ///< Fetches abort once this turns false
+    MirrorCache* mirror = nullptr; ///< Fetch network remotes through shared local mirrors
+    RemoteHeadCache* remote_heads = nullptr; ///< Ref advertisements shared per remote URL
+};
+
+/**
+ * @brief Outcome of the single fetch made for a repository in a cycle.
+ *
+ * The hash check, the updated-since filter and the pull all read from the
+ * same result instead of contacting the remote again.
+ */
+struct FetchResult {
+    bool ok = false;          ///< Fetch completed successfully
+    bool auth_failed = false; ///< Authentication was rejected
+    bool fetch_skipped = false; ///< ls-remote probe showed nothing new to download
+    bool timed_out = false;   ///< Aborted at the fetch deadline
+    bool cancelled = false;   ///< Aborted because the scan is stopping
+    FetchError kind = FetchError::None; ///< Category of the failure
+    int http_status = 0;                ///< HTTP status reported by the remote, 0 if none
+    std::chrono::seconds retry_after{0}; ///< Delay the remote asked for before retrying
+    std::string remote;       ///< Name of the fetched remote
+    std::string branch;       ///< Branch resolved into remote_hash
+    std::vector<std::string> refspecs; ///< Refspecs fetched, empty for the remote's defaults
+    int depth = 0;            ///< Shallow depth requested, 0 for none
+    std::string remote_hash;  ///< Tip of `refs/remotes/<remote>/<branch>`
+    std::time_t remote_commit_time = 0; ///< Commit time of remote_hash
+    std::string error;        ///< libgit2 error message on failure
+    int error_code = 0;       ///< libgit2 return code on failure
+    int error_class = 0;      ///< libgit2 error class on failure
+    unsigned int total_objects = 0;
+    unsigned int received_objects = 0;
+    unsigned int local_objects = 0;
+    unsigned int indexed_deltas = 0;
+    size_t received_bytes = 0;
+};
+
+/**
+ * @brief Metadata of the commit HEAD points to.
+ */
+struct CommitInfo {
+    std::string oid;        ///< Commit the fields describe, empty if HEAD is unresolved
+    InternedString author;  ///< Author name
+    std::string date;       ///< Local commit time as "%Y-%m-%d %H:%M:%S"
+    std::time_t time = 0;   ///< Commit time
+};
+
+/**
+ * @brief Refs a remote advertised on one connection.
+ */
+struct RemoteHeads {
+    bool ok = false;          ///< Connected and listed the refs
+    bool auth_failed = false; ///< Authentication was rejected
+    FetchError kind = FetchError::None; ///< Category of the failure
+    std::chrono::seconds retry_after{0}; ///< Delay the remote asked for before retrying
+    std::string error;        ///< libgit2 error message on failure
+    int error_code = 0;       ///< libgit2 return code on failure
+    std::map<std::string, std::string> refs; ///< Advertised ref name to OID in hex
+};
+
+/**
+ * @brief Repository handle shared by every check made on one repository
+ *        during a scan cycle.
+ *
+ * Opening a repository re-reads its config, HEAD and refs from disk. The
+ * session opens the repository on first use and keeps the handle so that
+ * validation, hash checks, commit metadata lookups and pulls all reuse it.
+ * A failed open is remembered and reported to every later caller.
+ */
+class RepoSession {
+  public:
+    explicit RepoSession(fs::path path);
+    RepoSession(const RepoSession&) = delete;
+    RepoSession& operator=(const RepoSession&) = delete;
+
+    const fs::path& path() const { return path_; }
+
+    /**
+     * @brief Return the opened repository, opening it on first use.
+     *
+     * @param error Optional output string receiving the open error.
+     * @return Repository handle owned by the session or `nullptr` on failure.
+     */
+    git_repository* repo(std::string* error = nullptr);
+
+    std::optional<std::string> local_hash(std::string* error = nullptr);
+    std::optional<std::string> current_branch(std::string* error = nullptr);
+    std::optional<std::string> remote_url(const std::string& remote,
+                                          std::string* error = nullptr);
+    bool remote_accessible(const std::string& remote, const FetchParams& params = {});
+
+    /**
+     * @brief Connect to @a remote and read its ref advertisement.
+     *
+     * No pack is negotiated or downloaded. The credentials setting, deadline,
+     * timeout and cancellation token of @a params apply.
+     */
+    RemoteHeads list_remote(const std::string& remote, const FetchParams& params = {});
+    bool has_uncommitted_changes();
+    std::string last_commit_date();
+    std::string last_commit_author();
+    std::time_t last_commit_time();
+
+    /** @brief Look up author, date and time of the HEAD commit at once. */
+    CommitInfo head_commit_info();
+
+    /** @brief Count packs and estimate loose objects in the object store. */
+    PackStats pack_stats();
+
+    /**
+     * @brief Consolidate the object store when @a policy thresholds are crossed.
+     *
+     * Loose objects beyond `policy.max_loose` are written into one new pack
+     * and their files removed. More than `policy.max_packs` packs not yet
+     * covered by the multi-pack-index trigger rewriting that index, so
+     * lookups stop probing every pack separately. @a stats is refreshed
+     * after any change.
+     *
+     * @return True when the object store was changed.
+     */
+    bool maintain_packs(const PackMaintenance& policy, PackStats& stats,
+                        std::string* error = nullptr);
+
+    /**
+     * @brief Fetch @a remote once and resolve @a branch against it.
+     *
+     * The first call performs the network fetch. Later calls for the same
+     * remote return the recorded result, re-resolving the branch if a
+     * different one is requested. An empty @a branch skips resolution.
+     * A narrow fetch is only reused for requests needing the same refspecs.
+     *
+     * With `params.single_branch` set only `refs/heads/<branch>` is
+     * negotiated instead of the remote's default refspecs; `params.tags`
+     * selects which tags come along.
+     *
+     * With `params.ls_remote_probe` set, the remote's ref advertisement is
+     * checked first and no pack is downloaded when the advertised
+     * `refs/heads/<branch>` already matches the local remote-tracking ref.
+     * With `params.remote_heads` set, that advertisement is read once per
+     * cycle for all repositories of the URL, and is used without the probe
+     * flag whenever more than one repository shares the URL.
+     */
+    const FetchResult& fetch(const std::string& remote, const std::string& branch,
+                             const FetchParams& params = {});
+
+    /** @brief Result of the previous fetch or `nullptr` if none was made. */
+    const FetchResult* last_fetch() const { return fetch_ ? &*fetch_ : nullptr; }
+
+  private:
+    void resolve_remote_branch(FetchResult& result, const std::string& branch);
+
+    fs::path path_;
+    repo_ptr repo_;
+    bool opened_ = false;
+    std::string open_error_;
+    std::optional<FetchResult> fetch_;
+};
+
+/**
+ * @brief HEAD commit metadata per repository, kept across scan cycles.
+ *
+ * Reading HEAD is a single ref lookup, while loading the commit and its
+ * signature is not. The cache re-reads the commit only when a repository's
+ * HEAD OID differs from the one cached.
+ */
+class CommitInfoCache {
+  public:
+    /** @brief Return metadata of @a session's HEAD commit. */
+    CommitInfo get(RepoSession& session);
+
+    /** @brief Number of repositories cached. */
+    size_t size();
+
+    /** @brief Drop entries of repositories not in @a repos. */
+    void retain(const std::vector<fs::path>& repos);
+
+  private:
+    std::mutex mtx_;
+    std::map<fs::path, CommitInfo> entries_;
+};
+
 /**
  * @brief Determine whether the given path is a Git repository.
  *
@@ -105,6 +351,22 @@ std::optional<std::string> get_remote_url(const fs::path& repo, const std::strin
  */
 bool is_github_url(const std::string& url);
 
+/**
+ * @brief Extract the host name from a remote URL.
+ *
+ * @param url Remote URL in URL or scp-like syntax.
+ * @return Lower-case host, or an empty string for local remotes.
+ */
+std::string url_host(const std::string& url);
+
+/**
+ * @brief Normalise a remote URL so that clones of one repository compare equal.
+ *
+ * Scheme and host are lower-cased; trailing slashes and a `.git` suffix
+ * are removed. User names are kept since they select the credentials.
+ */
+std::string normalize_remote_url(const std::string& url);
+
 /**
  * @brief Attempt to connect to the specified remote.
  *
@@ -130,12 +392,32 @@ bool has_uncommitted_changes(const fs::path& repo);
  * @param down_limit_kbps Optional download rate limit in KiB/s.
  * @param up_limit_kbps Optional upload rate limit in KiB/s.
  * @param disk_limit_kbps Optional disk I/O rate limit in KiB/s.
+ * @param depth          Optional history depth for a shallow clone, 0 for full.
+ * @param shared_limiter Optional bandwidth budget shared with other transfers.
+ * @param branch         Optional branch to check out instead of the remote's default.
+ * @param error          Optional output string receiving the libgit2 error message.
  * @return `true` on success, `false` otherwise.
  */
 bool clone_repo(const fs::path& dest, const std::string& url,
                 const std::function<void(int)>* progress_cb = nullptr, bool use_credentials = false,
                 bool* auth_failed = nullptr, size_t down_limit_kbps = 0, size_t up_limit_kbps = 0,
-                size_t disk_limit_kbps = 0);
+                size_t disk_limit_kbps = 0, int depth = 0,
+                procutil::BandwidthLimiter* shared_limiter = nullptr,
+                const std::string& branch = "", std::string* error = nullptr);
+
+/**
+ * @brief Clone a repository under the settings of a fetch.
+ *
+ * Rate limits, the shared limiter, depth, credentials and progress come
+ * from @a params, and received bytes are charged to its traffic budget as
+ * they arrive. The clone aborts once its timeout or deadline passes or the
+ * cancellation token is cleared.
+ *
+ * @param branch Optional branch to check out instead of the remote's default.
+ * @return Outcome of the clone, with failures classified like fetches.
+ */
+FetchResult clone_repo(const fs::path& dest, const std::string& url, const FetchParams& params,
+                       const std::string& branch = "");
 
 /**
  * @brief Perform a fast-forward pull from the specified remote.
@@ -158,6 +440,39 @@ int try_pull(const fs::path& repo, const std::string& remote, std::string& out_p
              size_t disk_limit_kbps = 0, bool force_pull = false,
              const std::string* target_ref = nullptr);
 
+/**
+ * @brief Perform a fast-forward pull using an already opened session.
+ *
+ * Behaves like the path based overload but reuses the session's repository
+ * handle and its fetch result when the remote was already fetched this cycle.
+ * Authentication failures are reported through `session.last_fetch()`.
+ *
+ * With `params.depth` set on a shallow repository, the history is deepened
+ * by doubling the depth, up to a cap, only while the shallow boundary hides
+ * whether the remote tip descends from the local HEAD, or while the target
+ * ref cannot be resolved. It is never unshallowed: a remote that was force
+ * pushed or diverged is reset to its fetched tip.
+ *
+ * The update checks out only the paths that differ between the old and new
+ * trees, refusing to overwrite local modifications unless @a force_pull is
+ * set. A forced pull over a dirty tree falls back to a hard reset.
+ *
+ * @param files_updated Optional output receiving the number of files checked out.
+ */
+int try_pull(RepoSession& session, const std::string& remote, std::string& out_pull_log,
+             const FetchParams& params, bool force_pull = false,
+             const std::string* target_ref = nullptr, size_t* files_updated = nullptr);
+
+/**
+ * @brief Fetch what `try_pull` would fetch, without touching the work tree.
+ *
+ * Lets the network part of a pull run ahead of the checkout. A later
+ * `try_pull` with the same arguments on @a session reuses the result.
+ */
+const FetchResult& fetch_for_pull(RepoSession& session, const std::string& remote,
+                                  const FetchParams& params,
+                                  const std::string* target_ref = nullptr);
+
 constexpr int TRY_PULL_TIMEOUT = 4;
 constexpr int TRY_PULL_RATE_LIMIT = 5;
 
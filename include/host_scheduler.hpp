@@ -0,0 +1,128 @@
+#ifndef HOST_SCHEDULER_HPP
+#define HOST_SCHEDULER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace procutil {
+
+/**
+ * @brief Hands out scan jobs round robin across remote hosts, with an
+ *        adaptive concurrency window per host.
+ *
+ * Each host starts with a small window of parallel jobs. Successful fetches
+ * grow it additively by about one job per window's worth of successes, and
+ * rate limiting, timeouts and connection resets halve it (AIMD). Windows
+ * never exceed the scan concurrency and persist across scans, so a host
+ * keeps its learned capacity from one cycle to the next.
+ *
+ * A job that failed transiently can be parked with a not-before time
+ * instead of blocking a worker; it is queued again once that time passes,
+ * and workers take other jobs meanwhile. Jobs that are not due yet can be
+ * parked from the start, so a scan spreads them over its horizon.
+ */
+class HostScheduler {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    enum class Outcome {
+        Success,   ///< The remote answered normally
+        Congested, ///< Rate limited, timed out or reset by the remote
+        Neutral,   ///< No network signal, e.g. skipped or misconfigured
+    };
+
+    HostScheduler() = default;
+    HostScheduler(const HostScheduler&) = delete;
+    HostScheduler& operator=(const HostScheduler&) = delete;
+
+    /**
+     * @brief Drop queued jobs and start a scan with @a max_window workers.
+     *
+     * Learned windows are kept but clamped to the new maximum. Once nothing
+     * is queued or in flight, parked jobs due after @a horizon are dropped
+     * and the scan ends.
+     */
+    void begin_scan(size_t max_window, clock::time_point horizon = clock::time_point::max());
+
+    /** @brief Queue job @a index for @a host. Jobs of one host run in order. */
+    void add(const std::string& host, size_t index);
+
+    /**
+     * @brief Take the next job whose host has room in its window.
+     *
+     * Hosts are visited round robin so that one busy host cannot starve the
+     * others. Blocks while every host with queued jobs is at its window, and
+     * while jobs are parked or hold a slot, since those may still be queued
+     * again.
+     *
+     * @param index   Receives the job index.
+     * @param host    Receives the job's host.
+     * @param running Scan flag; the call returns false once it clears.
+     * @return False when no jobs remain or the scan is stopping.
+     */
+    bool next(size_t& index, std::string& host, const std::atomic<bool>& running);
+
+    /** @brief Release a job slot and adapt the host's window. */
+    void finish(const std::string& host, Outcome outcome);
+
+    /** @brief Queue job @a index for @a host once @a not_before has passed. */
+    void park(const std::string& host, size_t index, clock::time_point not_before);
+
+    /**
+     * @brief Release the slot of job @a index like finish() and queue the
+     *        job again once @a not_before has passed.
+     */
+    void retry(const std::string& host, size_t index, Outcome outcome,
+               clock::time_point not_before);
+
+    /** @brief Jobs parked by park() or retry() that are not queued again yet. */
+    size_t parked();
+
+    /** @brief Current window of @a host. */
+    double window(const std::string& host);
+
+    static constexpr double initial_window = 2.0;
+
+  private:
+    struct Host {
+        std::deque<size_t> queue;
+        size_t in_flight = 0;
+        double window = initial_window;
+    };
+
+    struct Parked {
+        clock::time_point not_before;
+        std::string host;
+        size_t index;
+        bool operator>(const Parked& other) const { return not_before > other.not_before; }
+    };
+
+    Host& host_entry(const std::string& host);
+    void release(Host& h, Outcome outcome);
+    void enqueue(const std::string& host, size_t index);
+    void queue_due(clock::time_point now);
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::map<std::string, Host> hosts_;
+    std::vector<std::string> order_; ///< Round-robin order of hosts with jobs
+    size_t cursor_ = 0;
+    size_t queued_ = 0;
+    size_t in_flight_ = 0; ///< Slots held across all hosts
+    std::priority_queue<Parked, std::vector<Parked>, std::greater<Parked>> parked_;
+    double max_window_ = 1.0;
+    clock::time_point horizon_ = clock::time_point::max();
+};
+
+} // namespace procutil
+
+#endif // HOST_SCHEDULER_HPP
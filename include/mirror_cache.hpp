@@ -0,0 +1,81 @@
+#ifndef MIRROR_CACHE_HPP
+#define MIRROR_CACHE_HPP
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "git_utils.hpp"
+
+namespace git {
+
+/**
+ * @brief Shared bare mirrors of remote URLs, fetched once per scan cycle.
+ *
+ * Working copies of the same upstream fetch the mirror of its URL over the
+ * network only once per cycle; every working copy then fetches locally from
+ * that mirror. With alternates enabled, working copies also borrow the
+ * mirror's object store, so the local fetch copies no objects either.
+ *
+ * Mirrors are named after the URL's host and repository plus a hash of the
+ * full URL, and persist across runs.
+ */
+class MirrorCache {
+  public:
+    explicit MirrorCache(std::filesystem::path root, bool alternates = false);
+    MirrorCache(const MirrorCache&) = delete;
+    MirrorCache& operator=(const MirrorCache&) = delete;
+
+    /** @brief Start a scan cycle; every mirror is refreshed again on next use. */
+    void begin_cycle();
+
+    /**
+     * @brief Bring the mirror of @a url up to date, once per cycle.
+     *
+     * The first caller for a URL fetches it with @a params' credentials,
+     * limits and deadline; concurrent callers for the same URL wait for that
+     * fetch and share its result. Timed out or cancelled fetches are not
+     * shared, so the next caller tries again.
+     *
+     * @return Outcome of the network fetch into the mirror.
+     */
+    FetchResult refresh(const std::string& url, const FetchParams& params);
+
+    /** @brief Directory of the bare mirror for @a url. */
+    std::filesystem::path path_for(const std::string& url) const;
+
+    /** @brief Whether working copies borrow the mirrors' object stores. */
+    bool alternates() const { return alternates_; }
+
+    /**
+     * @brief Add the mirror of @a url as an object store alternate of @a repo.
+     *
+     * The alternate is written to `objects/info/alternates` and added to
+     * the open repository's object database. Does nothing when it is
+     * already listed.
+     */
+    bool link_alternate(git_repository* repo, const std::string& url,
+                        std::string* error = nullptr);
+
+  private:
+    struct Entry {
+        std::mutex mtx;
+        unsigned cycle = 0;
+        FetchResult result;
+    };
+
+    bool ensure_mirror(const std::filesystem::path& path, const std::string& url,
+                       std::string* error);
+
+    const std::filesystem::path root_;
+    const bool alternates_;
+    std::mutex mtx_;
+    unsigned cycle_ = 1;
+    std::map<std::string, std::shared_ptr<Entry>> entries_;
+};
+
+} // namespace git
+
+#endif // MIRROR_CACHE_HPP
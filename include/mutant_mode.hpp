@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <chrono>
 
+#include "git_utils.hpp"
 #include "options.hpp"
 #include "repo.hpp"
 
@@ -16,6 +17,10 @@ void apply_mutant_mode(Options& opts);
 bool mutant_should_pull(const std::filesystem::path& repo, RepoInfo& ri, const std::string& remote,
                         bool include_private, std::chrono::seconds updated_since);
 
+// Same as above but reuses the session's fetch result for the remote commit time.
+bool mutant_should_pull(git::RepoSession& session, RepoInfo& ri, const std::string& remote,
+                        const git::FetchParams& params, std::chrono::seconds updated_since);
+
 // Record the result of a pull operation and adjust timeouts accordingly.
 void mutant_record_result(const std::filesystem::path& repo, RepoStatus status,
                           std::chrono::seconds duration);
@@ -69,18 +69,37 @@ struct ResourceLimits {
     unsigned int thread_poll_sec = 5;
     size_t concurrency = 1;
     size_t max_threads = 0;
+    size_t fetch_concurrency = 0;    ///< Fetch stage workers, 0 for --concurrency
+    size_t checkout_concurrency = 0; ///< Checkout stage workers, 0 for --concurrency
+    size_t hook_concurrency = 0;     ///< Hook stage workers, 0 for --concurrency
     double cpu_percent_limit = 0.0;
     unsigned long long cpu_core_mask = 0;
     size_t mem_limit = 0;
     size_t download_limit = 0;
     size_t upload_limit = 0;
     size_t disk_limit = 0;
-    size_t total_traffic_limit = 0;
+    size_t total_traffic_limit = 0; ///< Bytes fetched per day
+    size_t cycle_traffic_limit = 0; ///< Bytes fetched per scan cycle
     std::chrono::seconds pull_timeout{0};
     bool skip_timeout = true;
     bool exit_on_timeout = false;
 };
 
+/**
+ * Process-wide libgit2 settings. Unset values keep libgit2's own defaults;
+ * a profile fills in a preset that explicit flags then override.
+ */
+struct Libgit2Options {
+    std::string profile = "default";              ///< default, lean or fast
+    std::optional<size_t> cache_size;             ///< Object cache bytes, 0 disables it
+    std::optional<size_t> mmap_window;            ///< Bytes mapped per pack window
+    std::optional<size_t> mmap_limit;             ///< Bytes mapped across all packs
+    std::optional<size_t> open_packs;             ///< Pack files kept open at once
+    std::optional<bool> strict_object_creation;   ///< Validate objects when writing
+    std::optional<bool> strict_hash_verification; ///< Verify object hashes when reading
+    std::optional<bool> fsync_gitdir;             ///< fsync objects and refs on write
+};
+
 struct Options {
     std::filesystem::path root;
     std::string remote_name = "origin";
@@ -96,6 +115,17 @@ struct Options {
     bool recursive_scan = false;
     bool check_only = false;
     bool hash_check = true;
+    bool ls_remote = false;
+    TagPolicy fetch_tags = TagPolicy::All;
+    bool single_branch = false;
+    bool prune = false;
+    unsigned int fetch_depth = 0;
+    bool status_cache = false;
+    bool pack_maintenance = false;
+    size_t max_packs = 50;
+    size_t max_loose_objects = 6700;
+    std::filesystem::path mirror_cache;
+    bool mirror_alternates = false;
     bool dry_run = false;
     bool force_pull = false;
     LoggingOptions logging;
@@ -104,8 +134,12 @@ struct Options {
     std::filesystem::path credential_file;
     std::string proxy_url;
     int interval = 30;
+    bool adaptive_interval = false;
+    std::chrono::seconds min_interval{0}; ///< 0 until parsed: --interval
+    std::chrono::seconds max_interval{0}; ///< 0 until parsed: 10x --interval
     std::chrono::milliseconds refresh_ms{250};
     ResourceLimits limits;
+    Libgit2Options libgit2;
     size_t max_depth = 0;
     bool cpu_tracker = true;
     bool mem_tracker = true;
@@ -127,6 +161,7 @@ struct Options {
     TuiTheme theme;
     std::vector<std::filesystem::path> include_dirs;
     std::vector<std::filesystem::path> ignore_dirs;
+    std::filesystem::path manifest;
     bool enable_history = false;
     std::string history_file = ".autogitpull.config";
     bool enable_hotkeys = false;
@@ -290,7 +325,8 @@ void parse_logging_and_ui(Options& opts, ArgParser& parser,
                           const std::map<std::string, std::string>& cfg_opts);
 
 /**
- * Parse timing-related options: --interval, --refresh-rate, and poll intervals.
+ * Parse timing-related options: --interval and its adaptive bounds,
+ * --refresh-rate, and poll intervals.
  */
 void parse_timing_options(Options& opts, ArgParser& parser,
                           const std::function<std::string(const std::string&)>& cfg_opt,
@@ -326,6 +362,24 @@ void parse_behavior_flags(Options& opts, ArgParser& parser,
                           const std::function<std::string(const std::string&)>& cfg_opt,
                           const std::map<std::string, std::string>& cfg_opts);
 
+/**
+ * Parse fetch policy options: --fetch-tags, --single-branch, --prune and
+ * --fetch-depth. Throws std::runtime_error on invalid values.
+ */
+void parse_fetch_options(Options& opts, ArgParser& parser,
+                         const std::function<bool(const std::string&)>& cfg_flag,
+                         const std::function<std::string(const std::string&)>& cfg_opt,
+                         const std::map<std::string, std::string>& cfg_opts);
+
+/**
+ * Parse libgit2 tuning options: --git-profile, cache and mmap sizes, strict
+ * checks and fsync. Throws std::runtime_error on invalid values.
+ */
+void parse_libgit2_options(Options& opts, ArgParser& parser,
+                           const std::function<bool(const std::string&)>& cfg_flag,
+                           const std::function<std::string(const std::string&)>& cfg_opt,
+                           const std::map<std::string, std::string>& cfg_opts);
+
 /** Parse root path, remote, pull-ref, and include/ignore directory lists. */
 void parse_root_and_repo_filters(Options& opts, ArgParser& parser,
                                  const std::function<std::string(const std::string&)>& cfg_opt,
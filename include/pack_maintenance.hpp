@@ -0,0 +1,24 @@
+#ifndef PACK_MAINTENANCE_HPP
+#define PACK_MAINTENANCE_HPP
+
+#include <cstddef>
+
+namespace git {
+
+/** @brief Object store counts of a repository. */
+struct PackStats {
+    size_t packs = 0;           ///< Pack files in objects/pack
+    size_t unindexed_packs = 0; ///< Packs newer than the multi-pack-index
+    size_t loose_objects = 0;   ///< Loose objects, estimated from one fan-out directory
+};
+
+/** @brief Thresholds for background pack maintenance. */
+struct PackMaintenance {
+    bool enabled = false;
+    size_t max_packs = 50;   ///< Unindexed packs before the multi-pack-index is rewritten
+    size_t max_loose = 6700; ///< Loose objects before they are packed
+};
+
+} // namespace git
+
+#endif // PACK_MAINTENANCE_HPP
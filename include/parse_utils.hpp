@@ -5,6 +5,7 @@
 #include <string>
 #include <chrono>
 #include "arg_parser.hpp"
+#include "repo_options.hpp"
 
 // Parse an integer flag from the parser.
 // Format: decimal with optional '+' or '-'.
@@ -121,4 +122,9 @@ std::chrono::milliseconds parse_time_ms(const ArgParser& parser, const std::stri
 // Invalid input: parse failure sets ok=false and returns 0ms.
 std::chrono::milliseconds parse_time_ms(const std::string& value, bool& ok);
 
+// Parse a tag download policy.
+// Format: none, auto, or all (case-insensitive).
+// Invalid input: any other value sets ok=false and returns TagPolicy::All.
+TagPolicy parse_tag_policy(const std::string& value, bool& ok);
+
 #endif // PARSE_UTILS_HPP
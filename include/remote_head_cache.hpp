@@ -0,0 +1,62 @@
+#ifndef REMOTE_HEAD_CACHE_HPP
+#define REMOTE_HEAD_CACHE_HPP
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "git_utils.hpp"
+
+namespace git {
+
+/**
+ * @brief Ref advertisements shared by repositories cloned from one URL.
+ *
+ * Forks and duplicate clones of a remote would otherwise each connect to
+ * it in every cycle. Repositories are registered by their remote URL at
+ * the start of a cycle; the first one to ask for a URL's heads connects
+ * and lists them, and every other repository with the same normalised URL
+ * waits for and reuses that listing, including a failure. Listings are
+ * keyed by whether credentials were used and dropped at the next cycle.
+ */
+class RemoteHeadCache {
+  public:
+    /** @brief Forget every listing and registration of the previous cycle. */
+    void begin_cycle();
+
+    /** @brief Register a repository whose remote points at @a url. */
+    void add(const std::string& url);
+
+    /** @brief Whether more than one repository registered @a url. */
+    bool shared(const std::string& url);
+
+    /**
+     * @brief Heads of @a remote of @a session, listed once per cycle per URL.
+     *
+     * The first caller's credentials setting, deadline and token apply to
+     * the listing.
+     *
+     * @return Listing shared with the other repositories of the URL.
+     */
+    std::shared_ptr<const RemoteHeads> get(RepoSession& session, const std::string& remote,
+                                           const FetchParams& params);
+
+    /** @brief Number of URLs listed in this cycle. */
+    size_t size();
+
+  private:
+    struct Entry {
+        std::mutex mtx;
+        std::shared_ptr<const RemoteHeads> heads;
+    };
+
+    std::mutex mtx_;
+    std::map<std::string, size_t> members_;
+    std::map<std::string, std::shared_ptr<Entry>> entries_;
+};
+
+} // namespace git
+
+#endif // REMOTE_HEAD_CACHE_HPP
@@ -1,13 +1,16 @@
 #ifndef REPO_HPP
 #define REPO_HPP
+#include <cstdint>
 #include <filesystem>
 #include <string>
 #include <ctime>
 
+#include "string_pool.hpp"
+
 /**
  * @brief High level status for a repository being monitored.
  */
-enum RepoStatus {
+enum RepoStatus : std::uint8_t {
     RS_PENDING,       ///< Repository has not been processed yet
     RS_CHECKING,      ///< Currently checking remote state
     RS_UP_TO_DATE,    ///< Local repository is up to date
@@ -27,18 +30,23 @@ enum RepoStatus {
 
 /**
  * @brief Runtime information about a repository.
+ *
+ * Records are keyed by the repository's path. Recurring strings are
+ * interned and the small fields sit together at the end, which keeps the
+ * record compact with 100k+ repositories.
  */
 struct RepoInfo {
-    std::filesystem::path path;     ///< Filesystem location of the repository
-    RepoStatus status = RS_PENDING; ///< Current status code
     std::string message;            ///< Human readable status message
-    std::string branch;             ///< Currently checked-out branch
+    InternedString branch;          ///< Currently checked-out branch
     std::string commit;             ///< Short hash of HEAD
     std::string commit_date;        ///< Date of last commit
-    std::string commit_author;      ///< Author of last commit
-    std::time_t commit_time = 0;    ///< Time of last commit
+    InternedString commit_author;   ///< Author of last commit
     std::string last_pull_log;      ///< Result of last pull attempt
+    std::time_t commit_time = 0;    ///< Time of last commit
+    size_t pack_count = 0;          ///< Packs in the object store (pack maintenance only)
+    size_t loose_objects = 0;       ///< Estimated loose objects (pack maintenance only)
     int progress = 0;               ///< Fetch progress percentage
+    RepoStatus status = RS_PENDING; ///< Current status code
     bool auth_failed = false;       ///< Authentication error flag
     bool pulled = false;            ///< Pulled during this session
 };
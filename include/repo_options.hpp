@@ -5,6 +5,14 @@
 #include <chrono>
 #include <cstddef>
 #include <filesystem>
+#include <string>
+
+/** Which tags a fetch downloads alongside the requested branches. */
+enum class TagPolicy {
+    None, ///< Never download tags
+    Auto, ///< Tags pointing at fetched commits (git's default)
+    All   ///< Every tag the remote advertises
+};
 
 struct RepoOptions {
     std::optional<bool> force_pull;
@@ -18,6 +26,18 @@ struct RepoOptions {
     std::optional<std::chrono::seconds> pull_timeout;
     std::optional<std::filesystem::path> post_pull_hook;
     std::optional<std::string> pull_ref;
+    std::optional<TagPolicy> fetch_tags;
+    std::optional<bool> single_branch;
+    std::optional<bool> prune;
+    std::optional<unsigned int> fetch_depth;
+};
+
+/** A repository the clone manifest wants present on disk. */
+struct ManifestEntry {
+    std::string url;            ///< Remote to clone from
+    std::filesystem::path path; ///< Destination of the working copy
+    std::string branch;         ///< Branch to check out, empty for the remote's default
+    unsigned int depth = 0;     ///< Shallow clone depth, 0 for the full history
 };
 
 #endif // REPO_OPTIONS_HPP
@@ -0,0 +1,199 @@
+#ifndef REPO_STATE_HPP
+#define REPO_STATE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "repo.hpp"
+
+/** @brief Hash of a path for unordered containers. */
+struct PathHash {
+    size_t operator()(const std::filesystem::path& p) const {
+        return std::filesystem::hash_value(p);
+    }
+};
+
+/**
+ * @brief Live state of one repository while a scan job works on it.
+ *
+ * Progress and status are atomics, so fetch progress ticks never take a
+ * lock; the message has a mutex of its own. Only the job holding the claim
+ * writes to the slot. The generation counts writes to the repository's
+ * entry in the shared map, so the display knows which entries to copy.
+ */
+class RepoSlot {
+  public:
+    /**
+     * @brief Take the slot for a job and reset its state to checking.
+     *
+     * @return False when another job holds it.
+     */
+    bool claim();
+
+    /**
+     * @brief Give the slot back; its state no longer shows and the map entry
+     *        the job left behind is copied again.
+     */
+    void release() {
+        claimed_.store(false, std::memory_order_release);
+        touch();
+    }
+
+    bool claimed() const { return claimed_.load(std::memory_order_acquire); }
+
+    void set_progress(int pct) { progress_.store(pct, std::memory_order_relaxed); }
+
+    void set_status(RepoStatus status, const std::string& message);
+
+    void set_message(const std::string& message);
+
+    /**
+     * @brief Copy status, message and progress over @a info while the slot
+     *        is claimed.
+     *
+     * @return True when the slot was claimed.
+     */
+    bool overlay(RepoInfo& info) const;
+
+    /** @brief Note a write to the repository's map entry; call it after the write. */
+    void touch() { generation_.fetch_add(1, std::memory_order_release); }
+
+    uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+  private:
+    std::atomic<bool> claimed_{false};
+    std::atomic<uint64_t> generation_{0};
+    std::atomic<int> progress_{0};
+    std::atomic<int> status_{RS_CHECKING};
+    mutable std::mutex message_mtx_;
+    std::string message_;
+};
+
+/** @brief Claim of a RepoSlot, released when the claim goes away. */
+class RepoClaim {
+  public:
+    RepoClaim() = default;
+    explicit RepoClaim(RepoSlot* slot) : slot_(slot) {}
+    RepoClaim(RepoClaim&& other) noexcept : slot_(std::exchange(other.slot_, nullptr)) {}
+    RepoClaim& operator=(RepoClaim&& other) noexcept {
+        if (this != &other) {
+            release();
+            slot_ = std::exchange(other.slot_, nullptr);
+        }
+        return *this;
+    }
+    RepoClaim(const RepoClaim&) = delete;
+    RepoClaim& operator=(const RepoClaim&) = delete;
+    ~RepoClaim() { release(); }
+
+    void release() {
+        if (slot_)
+            slot_->release();
+        slot_ = nullptr;
+    }
+
+    RepoSlot* get() const { return slot_; }
+    RepoSlot* operator->() const { return slot_; }
+    explicit operator bool() const { return slot_ != nullptr; }
+
+  private:
+    RepoSlot* slot_ = nullptr;
+};
+
+/**
+ * @brief Dense table of per-repository live state, one slot per path.
+ *
+ * A repository's RepoInfo in the shared map is written when a job starts
+ * and when it finishes. Everything in between, progress ticks and status
+ * changes, goes to the repository's slot, so the map's lock is held only
+ * for those two writes and for the display's copy of what changed. Whoever
+ * writes an entry touches its slot afterwards, and edits of every entry at
+ * once bump the table's epoch instead; a RepoView copies only what those
+ * marked.
+ *
+ * Slots are never removed and never move, so a slot's index is a stable
+ * repository ID and a job keeps a pointer to its slot. The hashed path
+ * index is only locked exclusively for new paths.
+ */
+class RepoStateTable {
+  public:
+    /** @brief Slot of @a path, added on first use. */
+    RepoSlot& slot(const std::filesystem::path& path);
+
+    /** @brief Stable ID of @a path, the index of its slot, added on first use. */
+    size_t id(const std::filesystem::path& path);
+
+    /** @brief Slot with ID @a id; the ID must come from id(). */
+    RepoSlot& at(size_t id);
+
+    /** @brief Slot of @a path, or nullptr when it has none yet. */
+    RepoSlot* find(const std::filesystem::path& path) const;
+
+    /** @brief Claim the slot of @a path; the claim is empty when it is busy. */
+    RepoClaim claim(const std::filesystem::path& path);
+
+    /** @brief Touch the slot of @a path after writing its map entry. */
+    void touch(const std::filesystem::path& path) { slot(path).touch(); }
+
+    /** @brief Note a write to many map entries, or removed ones. */
+    void touch_all() { epoch_.fetch_add(1, std::memory_order_release); }
+
+    uint64_t epoch() const { return epoch_.load(std::memory_order_acquire); }
+
+    /** @brief Lay every claimed slot over its entry in @a infos. */
+    void overlay(std::map<std::filesystem::path, RepoInfo>& infos) const;
+
+    /** @brief Call @a fn(id, path, slot) for every slot in ID order. */
+    template <class Fn> void for_each(Fn&& fn) const {
+        std::shared_lock<std::shared_mutex> lk(mtx_);
+        for (size_t id = 0; id < slots_.size(); ++id)
+            fn(id, paths_[id], slots_[id]);
+    }
+
+    /** @brief Number of slots. */
+    size_t size() const;
+
+  private:
+    mutable std::shared_mutex mtx_;
+    std::unordered_map<std::filesystem::path, size_t, PathHash> index_;
+    std::deque<RepoSlot> slots_;
+    std::deque<std::filesystem::path> paths_; ///< Path of each slot, by ID
+    std::atomic<uint64_t> epoch_{0};
+};
+
+/**
+ * @brief Copy of the shared RepoInfo map that the display renders from.
+ *
+ * A refresh walks the slots by ID and copies from the map only the entries
+ * whose slot was touched since the last refresh or is claimed, then lays
+ * the claimed slots over them. The whole map is copied, under the map's
+ * lock, on the first refresh and after RepoStateTable::touch_all(), which
+ * config reloads and fixed-cycle scans call.
+ */
+class RepoView {
+  public:
+    /** @brief Bring the copy up to date with @a infos, locking @a mtx only to copy. */
+    void refresh(const RepoStateTable& states,
+                 const std::map<std::filesystem::path, RepoInfo>& infos, std::mutex& mtx);
+
+    const std::map<std::filesystem::path, RepoInfo>& infos() const { return view_; }
+
+  private:
+    std::map<std::filesystem::path, RepoInfo> view_;
+    std::vector<uint64_t> seen_; ///< Slot generation at its last copy, by ID
+    std::vector<std::pair<const std::filesystem::path*, const RepoSlot*>> changed_;
+    uint64_t epoch_ = 0;
+    bool synced_ = false;
+};
+
+#endif // REPO_STATE_HPP
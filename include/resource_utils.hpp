@@ -22,6 +22,12 @@ void set_thread_poll_interval(unsigned int seconds);
 /** @brief Get the resident memory usage of the process in megabytes. */
 std::size_t get_memory_usage_mb();
 
+/** @brief Read the resident memory usage in kilobytes, bypassing the poll interval. */
+std::size_t read_memory_usage_kb();
+
+/** @brief Return memory freed by the heap allocator to the OS where supported. */
+void release_free_memory();
+
 /** @brief Get the virtual memory usage of the process in kilobytes. */
 std::size_t get_virtual_memory_kb();
 
@@ -0,0 +1,64 @@
+#ifndef RETRY_BACKOFF_HPP
+#define RETRY_BACKOFF_HPP
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <random>
+
+namespace procutil {
+
+/**
+ * @brief Per-repository retry timers for transient fetch failures.
+ *
+ * Each consecutive failure doubles the repository's delay, starting at
+ * @a base and capped at @a cap, with random jitter so that repositories
+ * failing together do not retry together. A retry hint from the server
+ * extends the delay when it asks for longer. Success clears the timer.
+ */
+class RetryBackoff {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    explicit RetryBackoff(std::chrono::seconds base = std::chrono::seconds(5),
+                          std::chrono::seconds cap = std::chrono::minutes(15));
+    RetryBackoff(const RetryBackoff&) = delete;
+    RetryBackoff& operator=(const RetryBackoff&) = delete;
+
+    /**
+     * @brief Record a transient failure of @a repo.
+     *
+     * @param hint Delay requested by the server, zero if none.
+     * @param now  Time of the failure.
+     * @return Time before which @a repo should not be retried.
+     */
+    clock::time_point failure(const std::filesystem::path& repo, std::chrono::seconds hint,
+                              clock::time_point now = clock::now());
+
+    /** @brief Forget the failures of @a repo. */
+    void success(const std::filesystem::path& repo);
+
+    /** @brief Time left before @a repo may be retried, zero when it is due. */
+    std::chrono::seconds remaining(const std::filesystem::path& repo,
+                                   clock::time_point now = clock::now());
+
+    /** @brief Consecutive failures recorded for @a repo. */
+    unsigned attempts(const std::filesystem::path& repo);
+
+  private:
+    struct Entry {
+        unsigned attempts = 0;
+        clock::time_point not_before{};
+    };
+
+    const std::chrono::seconds base_;
+    const std::chrono::seconds cap_;
+    std::mutex mtx_;
+    std::map<std::filesystem::path, Entry> entries_;
+    std::minstd_rand rng_{std::random_device{}()};
+};
+
+} // namespace procutil
+
+#endif // RETRY_BACKOFF_HPP
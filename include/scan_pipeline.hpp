@@ -0,0 +1,178 @@
+#ifndef SCAN_PIPELINE_HPP
+#define SCAN_PIPELINE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace procutil {
+
+/**
+ * @brief Blocking FIFO with a fixed capacity, handing work from one scan
+ *        stage to the next.
+ *
+ * A full queue makes the producing stage wait, so a slow stage holds back
+ * the stages feeding it instead of letting work pile up in memory.
+ */
+template <typename T> class BoundedQueue {
+  public:
+    explicit BoundedQueue(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Append @a item, waiting while the queue is full.
+     *
+     * @return False when the queue was closed; @a item is then dropped.
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        not_full_.wait(lk, [this]() { return closed_ || items_.size() < capacity_; });
+        if (closed_)
+            return false;
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest item, waiting while the queue is empty.
+     *
+     * @return False once the queue is closed and drained.
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        not_empty_.wait(lk, [this]() { return closed_ || !items_.empty(); });
+        if (items_.empty())
+            return false;
+        item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /** @brief Refuse further items; queued ones can still be taken. */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return items_.size();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+  private:
+    const size_t capacity_;
+    std::mutex mtx_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
+
+/** @brief Stages a repository passes through during a scan, in order. */
+enum class ScanStage { Probe, Fetch, Checkout, Hook };
+
+/**
+ * @brief Worker counts of the scan stages after the probe, which runs with
+ *        the scan concurrency.
+ *
+ * A stage without workers of its own runs on the thread of the stage before
+ * it, so the defaults handle each repository start to finish on one thread.
+ */
+struct StageLimits {
+    size_t fetch = 0;
+    size_t checkout = 0;
+    size_t hook = 0;
+
+    /** @brief Workers of each stage, in stage order, for @a concurrency. */
+    std::array<size_t, 4> workers(size_t concurrency) const {
+        return {concurrency, fetch, checkout, hook};
+    }
+};
+
+/** @brief Live counters of one scan stage. */
+struct StageStats {
+    std::atomic<size_t> workers{0};        ///< Threads serving the stage
+    std::atomic<size_t> busy{0};           ///< Threads working on a repository
+    std::atomic<size_t> queued{0};         ///< Repositories waiting for the stage
+    std::atomic<size_t> capacity{0};       ///< Bound of the stage's input queue
+    std::atomic<std::uint64_t> busy_ms{0}; ///< Work time summed over threads
+};
+
+/**
+ * @brief Counters of every scan stage, updated by the scanner and read by
+ *        the status display.
+ */
+class PipelineStats {
+  public:
+    static constexpr size_t stage_count = 4;
+
+    StageStats& operator[](ScanStage s) { return stages_[static_cast<size_t>(s)]; }
+
+    static const char* name(ScanStage s) {
+        static const char* names[stage_count] = {"probe", "fetch", "checkout", "hook"};
+        return names[static_cast<size_t>(s)];
+    }
+
+    /** @brief Reset the counters for a scan with the given stage workers. */
+    void begin_scan(const std::array<size_t, stage_count>& workers) {
+        for (size_t i = 0; i < stage_count; ++i) {
+            stages_[i].workers = workers[i];
+            stages_[i].busy = 0;
+            stages_[i].queued = 0;
+            stages_[i].capacity = 0;
+            stages_[i].busy_ms = 0;
+        }
+        started_ms_ = now_ms();
+        active_ = true;
+    }
+
+    void end_scan() { active_ = false; }
+
+    /** @brief Whether a scan is running. */
+    bool active() const { return active_; }
+
+    /**
+     * @brief Share of the stage's thread time spent working since the scan
+     *        started, from 0 to 1.
+     */
+    double utilisation(ScanStage s) {
+        StageStats& st = (*this)[s];
+        std::uint64_t elapsed = now_ms() - started_ms_;
+        if (st.workers == 0 || elapsed == 0)
+            return 0.0;
+        double share =
+            static_cast<double>(st.busy_ms) / (static_cast<double>(elapsed) * st.workers);
+        return std::min(share, 1.0);
+    }
+
+    static std::uint64_t now_ms() {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                              std::chrono::steady_clock::now().time_since_epoch())
+                                              .count());
+    }
+
+  private:
+    std::array<StageStats, stage_count> stages_;
+    std::atomic<std::uint64_t> started_ms_{0};
+    std::atomic<bool> active_{false};
+};
+
+} // namespace procutil
+
+#endif // SCAN_PIPELINE_HPP
@@ -9,43 +9,237 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
 #include <optional>
 
+#include "git_utils.hpp"
+#include "host_scheduler.hpp"
 #include "repo.hpp"
+#include "remote_head_cache.hpp"
 #include "repo_options.hpp"
+#include "repo_state.hpp"
+#include "retry_backoff.hpp"
+#include "scan_pipeline.hpp"
+
+namespace procutil {
+class WorkerPool;
+class DueScheduler;
+} // namespace procutil
 
 std::vector<std::filesystem::path> build_repo_list(const std::vector<std::filesystem::path>& roots,
                                                    bool recursive,
                                                    const std::vector<std::filesystem::path>& ignore,
                                                    size_t max_depth);
 
-void process_repo(const std::filesystem::path& p,
-                  std::map<std::filesystem::path, RepoInfo>& repo_infos,
-                  std::set<std::filesystem::path>& skip_repos, std::mutex& mtx,
-                  std::atomic<bool>& running, std::string& action, std::mutex& action_mtx,
-                  bool include_private, const std::string& remote,
-                  const std::filesystem::path& log_dir, bool check_only, bool hash_check,
-                  size_t down_limit, size_t up_limit, size_t disk_limit, bool silent, bool cli_mode,
-                  bool dry_run, bool force_pull, bool skip_timeout, bool skip_unavailable,
-                  bool skip_accessible_errors, const std::filesystem::path& post_pull_hook,
-                  const std::optional<std::string>& pull_ref, std::chrono::seconds updated_since,
-                  bool show_pull_author, std::chrono::seconds pull_timeout, bool mutant_mode);
+namespace scanner_detail {
+
+/** @brief Settings and shared state of one scan, common to all repositories. */
+struct ScanContext {
+    std::map<std::filesystem::path, RepoInfo>& repo_infos;
+    std::set<std::filesystem::path>& skip_repos;
+    std::mutex& mtx;
+    RepoStateTable& states; ///< Live state of the repositories in flight
+    std::atomic<bool>& running;
+    std::string& action;
+    std::mutex& action_mtx;
+    bool include_private;
+    const std::string& remote;
+    const std::filesystem::path& log_dir;
+    bool hash_check;
+    bool silent;
+    bool cli_mode;
+    bool dry_run;
+    bool skip_unavailable;
+    bool skip_accessible_errors;
+    std::chrono::seconds updated_since;
+    bool show_pull_author;
+    bool mutant_mode;
+    git::CommitInfoCache* commit_info;
+};
+
+/**
+ * @brief One repository on its way through the scan stages.
+ *
+ * The first block is filled in by the caller; the rest is state the stages
+ * hand to each other, including the open session, so consecutive stages
+ * may run on different threads.
+ */
+struct RepoJob {
+    std::filesystem::path path;
+    bool check_only = false;
+    bool force_pull = false;
+    size_t down_limit = 0;
+    size_t up_limit = 0;
+    size_t disk_limit = 0;
+    std::filesystem::path post_pull_hook;
+    std::optional<std::string> pull_ref;
+    std::chrono::seconds pull_timeout{0};
+    git::FetchParams fetch_defaults;
+
+    RepoInfo info;
+    RepoClaim claim; ///< The repository's live state slot, held until the job ends
+    bool prev_pulled = false;
+    bool was_accessible = false;
+    std::unique_ptr<git::RepoSession> session;
+    git::FetchParams fetch_params;
+    std::function<void(int)> progress_cb;
+    std::chrono::steady_clock::duration pull_time{}; ///< Fetch and checkout time of a pull
+};
+
+/** @brief What follows a stage. */
+enum class StageResult {
+    Next,   ///< Hand the job to the next stage
+    Finish, ///< Publish the job's RepoInfo and stop
+    Drop,   ///< Stop without touching the repository's RepoInfo
+};
+
+/**
+ * @brief Check that the repository can be updated: local state and remote access.
+ *
+ * Claims the repository's live state slot; a repository another job holds
+ * is dropped as busy.
+ */
+StageResult probe_repo(ScanContext& ctx, RepoJob& job);
+
+/** @brief Fetch the remote and decide whether the work tree needs updating. */
+StageResult fetch_repo(ScanContext& ctx, RepoJob& job);
+
+/** @brief Update the work tree from the fetched remote. Next means a hook should run. */
+StageResult checkout_repo(ScanContext& ctx, RepoJob& job);
 
+/** @brief Run the repository's post-pull hook. */
+void hook_repo(ScanContext& ctx, RepoJob& job);
+
+/**
+ * @brief Publish the job's RepoInfo and report the update.
+ *
+ * @param fetch_out Optional output receiving the job's fetch result.
+ */
+void finish_repo(ScanContext& ctx, RepoJob& job, git::FetchResult* fetch_out = nullptr);
+
+} // namespace scanner_detail
+
+/**
+ * @brief What scans learn about remote hosts and repositories, carried from
+ *        one scan to the next.
+ *
+ * The event loop owns one and hands it to every scan; a scan without one
+ * starts from nothing and forgets what it learned when it returns.
+ */
+struct ScanState {
+    procutil::HostScheduler hosts;     ///< Adaptive window of each remote host
+    procutil::RetryBackoff backoff;    ///< Retry timers of transiently failed repositories
+    git::CommitInfoCache commit_cache; ///< HEAD metadata, re-read once HEAD moves
+    git::RemoteHeadCache remote_heads; ///< Ref listings shared per URL, cleared each scan
+    std::mutex urls_mtx;               ///< Guards repo_urls
+    /// Remote URL of each repository, refreshed when a probe reads another
+    std::map<std::filesystem::path, std::string> repo_urls;
+    std::mutex maintenance_mtx; ///< Guards maintenance_due and maintained
+    /// Repositories that received objects since their packs were maintained
+    std::set<std::filesystem::path> maintenance_due;
+    /// When each repository's packs were last maintained
+    std::map<std::filesystem::path, std::chrono::steady_clock::time_point> maintained;
+    std::future<void> maintenance; ///< Pack maintenance running on the pool
+
+    ScanState() = default;
+    ScanState(const ScanState&) = delete;
+    ScanState& operator=(const ScanState&) = delete;
+    /** @brief Wait for pack maintenance, which works on this state. */
+    ~ScanState();
+};
+
+/**
+ * @brief Settings of a scan and the longer-lived objects it works with.
+ *
+ * Defaults match the command-line defaults, so callers only set what
+ * differs. The pointers are optional; a scan without them keeps its own
+ * for its duration.
+ */
+struct ScanOptions {
+    bool include_private = false; ///< Use credentials for private remotes
+    std::string remote = "origin";
+    std::filesystem::path log_dir; ///< Pull logs go here; empty for none
+    bool check_only = false;
+    bool hash_check = true;
+    size_t concurrency = 1; ///< Probe workers
+    double cpu_percent_limit = 0.0;
+    size_t mem_limit = 0;  ///< MB the process may use, 0 for no limit
+    size_t down_limit = 0; ///< KB/s shared by all workers
+    size_t up_limit = 0;   ///< KB/s shared by all workers
+    size_t disk_limit = 0; ///< KB/s shared by all workers
+    bool silent = false;
+    bool cli_mode = false;
+    bool dry_run = false;
+    bool force_pull = false;
+    bool skip_timeout = true; ///< Leave timed-out repositories for a later scan
+    bool skip_unavailable = true;
+    bool skip_accessible_errors = false;
+    std::filesystem::path post_pull_hook;
+    std::optional<std::string> pull_ref;
+    std::chrono::seconds updated_since{0};
+    bool show_pull_author = false;
+    std::chrono::seconds pull_timeout{0};
+    bool retry_skipped = false;
+    bool reset_skipped = false;
+    std::map<std::filesystem::path, RepoOptions> repo_settings; ///< Per-repository overrides
+    bool mutant_mode = false;
+    git::FetchParams fetch_defaults;
+    bool need_commit_info = true; ///< Read commit metadata for display or sorting
+    git::PackMaintenance maintenance;
+    std::vector<ManifestEntry> manifest; ///< Repositories cloned when missing
+    procutil::StageLimits stages;        ///< Workers of the stages after the probe
+    /// The loop stops after this scan, so pack maintenance runs before the
+    /// scan returns instead of in the background
+    bool last_scan = false;
+
+    /// Threads of the stage workers, kept large enough for them, the caller
+    /// and pack maintenance while the stages run
+    procutil::WorkerPool* pool = nullptr;
+    procutil::PipelineStats* pipeline_stats = nullptr; ///< Receives each stage's load
+    /// Receives the live state of the repositories in flight; the shared
+    /// map is then only written as jobs start and end
+    RepoStateTable* states = nullptr;
+    /// Gives each repository its own due time and learns from each result
+    procutil::DueScheduler* due = nullptr;
+    ScanState* state = nullptr; ///< Host windows, retry timers and caches of earlier scans
+};
+
+/**
+ * @brief Update every repository in @a all_repos.
+ *
+ * Repositories flow through a pipeline of stages connected by bounded
+ * queues: probe (local checks and remote access), fetch, checkout and the
+ * post-pull hook. The probe stage runs ScanOptions::concurrency workers,
+ * taking repositories round robin across remote hosts;
+ * ScanOptions::stages sets the workers of the other stages. With a due
+ * scheduler only repositories due within its minimum interval are
+ * checked, each when it falls due.
+ */
 void scan_repos(const std::vector<std::filesystem::path>& all_repos,
                 std::map<std::filesystem::path, RepoInfo>& repo_infos,
                 std::set<std::filesystem::path>& skip_repos, std::mutex& mtx,
                 std::atomic<bool>& scanning_flag, std::atomic<bool>& running, std::string& action,
-                std::mutex& action_mtx, bool include_private, const std::string& remote,
-                const std::filesystem::path& log_dir, bool check_only, bool hash_check,
-                size_t concurrency, double cpu_percent_limit, size_t mem_limit, size_t down_limit,
-                size_t up_limit, size_t disk_limit, bool silent, bool cli_mode, bool dry_run,
-                bool force_pull, bool skip_timeout, bool skip_unavailable,
-                bool skip_accessible_errors, const std::filesystem::path& post_pull_hook,
-                const std::optional<std::string>& pull_ref, std::chrono::seconds updated_since,
-                bool show_pull_author, std::chrono::seconds pull_timeout, bool retry_skipped,
-                bool reset_skipped,
-                const std::map<std::filesystem::path, RepoOptions>& repo_settings,
-                bool mutant_mode);
+                std::mutex& action_mtx, const ScanOptions& options);
+
+/**
+ * @brief Clone a manifest repository that is missing on disk.
+ *
+ * The repository's RepoInfo receives the clone's outcome; its progress goes
+ * to its slot in @a states when given. The clone runs under the limits,
+ * timeout, deadline and cancellation token of @a params; their depth is
+ * used when the entry does not set its own. Received bytes count against
+ * the traffic budget of @a params.
+ *
+ * @param result_out Optional output receiving the classified outcome.
+ * @return True when the clone succeeded.
+ */
+bool clone_manifest_repo(const ManifestEntry& entry,
+                         std::map<std::filesystem::path, RepoInfo>& repo_infos, std::mutex& mtx,
+                         std::string& action, std::mutex& action_mtx,
+                         const git::FetchParams& params, bool silent, bool cli_mode,
+                         RepoStateTable* states = nullptr, git::FetchResult* result_out = nullptr);
 
 void run_post_pull_hook(const std::filesystem::path& hook);
 
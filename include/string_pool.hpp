@@ -0,0 +1,60 @@
+#ifndef STRING_POOL_HPP
+#define STRING_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Immutable string shared through a process-wide pool.
+ *
+ * Equal strings are stored once and a handle is a single pointer, so
+ * values that repeat across thousands of repositories, such as branch
+ * names and commit authors, cost one copy in total. Pooled strings are
+ * reference counted and leave the pool with their last handle, so values
+ * of repositories that are gone do not stay behind.
+ */
+class InternedString {
+  public:
+    InternedString() = default;
+    InternedString(const std::string& s); // NOLINT(runtime/explicit)
+    InternedString(const char* s);        // NOLINT(runtime/explicit)
+    InternedString(const InternedString& other) noexcept;
+    InternedString(InternedString&& other) noexcept;
+    InternedString& operator=(const InternedString& other) noexcept;
+    InternedString& operator=(InternedString&& other) noexcept;
+    ~InternedString();
+
+    const std::string& str() const { return entry_ ? entry_->str : empty_; }
+    operator const std::string&() const { return str(); }
+    bool empty() const { return entry_ == nullptr; }
+    size_t size() const { return str().size(); }
+    const char* c_str() const { return str().c_str(); }
+
+    friend bool operator==(const InternedString& a, const InternedString& b) {
+        return a.entry_ == b.entry_;
+    }
+    friend bool operator==(const InternedString& a, const std::string& b) { return a.str() == b; }
+    friend bool operator==(const InternedString& a, const char* b) { return a.str() == b; }
+    friend std::ostream& operator<<(std::ostream& os, const InternedString& s) {
+        return os << s.str();
+    }
+
+    /** @brief Number of distinct strings in the pool. */
+    static size_t pool_size();
+
+    /** @brief Pooled string and the number of handles to it. */
+    struct Entry {
+        std::string str;
+        std::atomic<size_t> refs{0};
+    };
+
+  private:
+    void release() noexcept;
+
+    static const std::string empty_;
+    Entry* entry_ = nullptr; ///< nullptr for the empty string
+};
+
+#endif // STRING_POOL_HPP
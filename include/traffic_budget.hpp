@@ -0,0 +1,58 @@
+#ifndef TRAFFIC_BUDGET_HPP
+#define TRAFFIC_BUDGET_HPP
+
+#include <cstddef>
+#include <ctime>
+#include <mutex>
+
+namespace procutil {
+
+/**
+ * @brief Byte budget for fetch traffic per scan cycle and per calendar day.
+ *
+ * Fetches report the bytes libgit2 received. Once either budget is spent,
+ * the scanner stops starting new fetches and defers the remaining
+ * repositories. The cycle budget refills when the next scan starts (every
+ * poll interval with --adaptive-interval), and the daily budget refills at
+ * local midnight. A limit of zero disables that budget.
+ */
+class TrafficBudget {
+  public:
+    TrafficBudget(size_t cycle_limit_bytes, size_t daily_limit_bytes);
+    TrafficBudget(const TrafficBudget&) = delete;
+    TrafficBudget& operator=(const TrafficBudget&) = delete;
+
+    /** @brief Whether any budget is configured. */
+    bool active() const;
+
+    /** @brief Change the limits, keeping what was used so far. */
+    void set_limits(size_t cycle_limit_bytes, size_t daily_limit_bytes);
+
+    /** @brief Start a new scan cycle, refilling the cycle budget. */
+    void begin_cycle();
+
+    /** @brief Account @a bytes transferred by a fetch. */
+    void add(size_t bytes);
+
+    /** @brief True when the cycle or daily budget is used up. */
+    bool exhausted();
+
+    size_t cycle_used();
+    size_t day_used();
+    size_t cycle_limit() const;
+    size_t daily_limit() const;
+
+  private:
+    void roll_day(std::time_t now);
+
+    mutable std::mutex mtx_;
+    size_t cycle_limit_;
+    size_t daily_limit_;
+    size_t cycle_used_ = 0;
+    size_t day_used_ = 0;
+    int day_key_ = -1;
+};
+
+} // namespace procutil
+
+#endif // TRAFFIC_BUDGET_HPP
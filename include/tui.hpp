@@ -7,6 +7,11 @@
 #include <vector>
 #include "repo.hpp"
 
+namespace procutil {
+class TrafficBudget;
+class PipelineStats;
+}
+
 /**
  * @brief Enable ANSI color sequences on Windows consoles.
  *
@@ -82,10 +87,14 @@ std::string render_header(const std::vector<std::filesystem::path>& all_repos,
  * @param show_affinity  Whether to display CPU affinity information.
  * @param track_vmem     Whether virtual memory usage is tracked.
  * @param colors         Color palette used for formatting.
+ * @param budget         Traffic budget to report, or nullptr when none is set.
+ * @param pipeline       Scan stage counters, shown while a scan runs.
  * @return Colorized statistics string for the TUI footer.
  */
 std::string render_stats(bool track_cpu, bool track_mem, bool track_threads, bool track_net,
-                         bool show_affinity, bool track_vmem, const TuiColors& colors);
+                         bool show_affinity, bool track_vmem, const TuiColors& colors,
+                         procutil::TrafficBudget* budget = nullptr,
+                         procutil::PipelineStats* pipeline = nullptr);
 
 /**
  * @brief Render a single repository entry line.
@@ -118,6 +127,8 @@ std::string render_repo_entry(const std::filesystem::path& p, const RepoInfo& ri
  * @param action      Short description of the current action.
  * @param show_skipped Show entries marked as skipped.
  * @param show_notgit Show entries marked as NotGit.
+ * @param budget      Traffic budget shown next to the network stats.
+ * @param pipeline    Scan stage counters shown while a scan runs.
  */
 void draw_tui(const std::vector<std::filesystem::path>& all_repos,
               const std::map<std::filesystem::path, RepoInfo>& repo_infos, int interval,
@@ -127,6 +138,8 @@ void draw_tui(const std::vector<std::filesystem::path>& all_repos,
               bool show_commit_date, bool show_commit_author, bool session_dates_only,
               bool no_colors, const std::string& custom_color, const TuiTheme& theme,
               const std::string& status_msg, int runtime_sec, bool show_datetime_line,
-              bool show_header, bool show_repo_count, bool censor_names, char censor_char);
+              bool show_header, bool show_repo_count, bool censor_names, char censor_char,
+              procutil::TrafficBudget* budget = nullptr,
+              procutil::PipelineStats* pipeline = nullptr);
 
 #endif // TUI_HPP
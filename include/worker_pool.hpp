@@ -0,0 +1,129 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace procutil {
+
+/**
+ * @brief Long-lived work-stealing thread pool shared by every scan cycle.
+ *
+ * Each worker owns a task deque. Tasks submitted from a worker go to the
+ * back of its own deque and it takes them back LIFO; tasks submitted from
+ * other threads are dealt round robin. An idle worker steals from the front
+ * of the other deques. Tasks are coarse (a repository or a whole scan), so
+ * all deques share one lock.
+ *
+ * Threads live as long as the pool, which keeps the process thread count
+ * and per-thread state stable from one cycle to the next.
+ */
+class WorkerPool {
+  public:
+    /**
+     * @brief Floor on the pool size, held while tasks that wait on each
+     *        other are queued; released when the reservation goes away.
+     */
+    class Reservation {
+      public:
+        Reservation() = default;
+        Reservation(Reservation&& other) noexcept
+            : pool_(std::exchange(other.pool_, nullptr)), threads_(other.threads_) {}
+        Reservation& operator=(Reservation&& other) noexcept {
+            if (this != &other) {
+                release();
+                pool_ = std::exchange(other.pool_, nullptr);
+                threads_ = other.threads_;
+            }
+            return *this;
+        }
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+        ~Reservation() { release(); }
+
+        void release() {
+            if (pool_)
+                pool_->unreserve(threads_);
+            pool_ = nullptr;
+        }
+
+      private:
+        friend class WorkerPool;
+        Reservation(WorkerPool* pool, size_t threads) : pool_(pool), threads_(threads) {}
+
+        WorkerPool* pool_ = nullptr;
+        size_t threads_ = 0;
+    };
+
+    /** @brief Start @a threads workers, at least one. */
+    explicit WorkerPool(size_t threads);
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /** @brief Run every queued task, then join the workers, retired ones included. */
+    ~WorkerPool();
+
+    /**
+     * @brief Grow or shrink the pool to @a threads workers, at least one.
+     *
+     * Removed workers finish their current task; their queued tasks move to
+     * the remaining workers. Resizing never waits for a running task: a
+     * removed worker is joined by a later resize or the destructor once it
+     * has returned. While a reservation is held the pool does not shrink
+     * below it; the requested size applies once it is released.
+     */
+    void resize(size_t threads);
+
+    /**
+     * @brief Grow the pool to at least @a threads workers and keep it there
+     *        until the returned reservation is released.
+     */
+    Reservation reserve(size_t threads);
+
+    /** @brief Number of workers. */
+    size_t size();
+
+    /**
+     * @brief Queue @a task.
+     *
+     * @return Future that becomes ready when the task has run and rethrows
+     *         what it threw.
+     */
+    std::future<void> submit(std::function<void()> task);
+
+  private:
+    struct Worker {
+        std::deque<std::function<void()>> tasks;
+        std::thread thread;
+        bool retire = false;
+        bool exited = false; ///< run() has returned; joining will not block
+    };
+
+    void run(Worker* self);
+    void unreserve(size_t threads);
+    void apply_size();
+    bool take(Worker* self, std::function<void()>& task);
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::unique_ptr<Worker>> retired_; ///< Removed, possibly still in a task
+    std::multiset<size_t> floors_; ///< Sizes held by live reservations
+    size_t requested_ = 1;         ///< Size asked for by the last resize()
+    size_t queued_ = 0;
+    size_t next_ = 0;
+    bool stop_ = false;
+};
+
+} // namespace procutil
+
+#endif // WORKER_POOL_HPP
@@ -38,6 +38,8 @@ int main(int argc, char* argv[]) {
     try {
         Options opts = parse_options(argc, argv); // Parse CLI options.
         git::set_proxy(opts.proxy_url);
+        git::set_server_timeouts(opts.limits.pull_timeout);
+        git::set_status_cache(opts.status_cache);
         apply_mutant_mode(opts);
         if (opts.enable_history) {
             std::string cmd;
@@ -48,8 +50,6 @@ int main(int argc, char* argv[]) {
             }
             append_history(opts.history_file, cmd); // Record invocation.
         }
-        if (opts.limits.pull_timeout.count() > 0)
-            git::set_libgit_timeout(static_cast<unsigned int>(opts.limits.pull_timeout.count()));
         if (opts.show_help) {
             print_help(argv[0]);
             return 0;
@@ -0,0 +1,67 @@
+#include "bandwidth_limiter.hpp"
+
+namespace procutil {
+
+BandwidthLimiter::BandwidthLimiter(size_t down_kbps, size_t up_kbps, size_t disk_kbps) {
+    down_.bytes_per_sec = static_cast<double>(down_kbps) * 1024.0;
+    up_.bytes_per_sec = static_cast<double>(up_kbps) * 1024.0;
+    disk_.bytes_per_sec = static_cast<double>(disk_kbps) * 1024.0;
+}
+
+bool BandwidthLimiter::active() const {
+    return down_.bytes_per_sec > 0 || up_.bytes_per_sec > 0 || disk_.bytes_per_sec > 0;
+}
+
+/**
+ * @brief Book @a bytes on a bucket and return when the caller may continue.
+ *
+ * The bucket keeps the time at which all bytes booked so far will have
+ * drained at the configured rate. Each booking extends that time, so
+ * concurrent callers are served in the order they charged. Idle time is not
+ * banked beyond the burst window.
+ *
+ * @param bucket Bucket to charge, guarded by mtx_.
+ * @param bytes  Bytes moved since the caller's previous charge.
+ * @return Deadline the caller should sleep until.
+ */
+BandwidthLimiter::clock::time_point BandwidthLimiter::reserve(Bucket& bucket, size_t bytes) {
+    auto now = clock::now();
+    if (bucket.bytes_per_sec <= 0 || bytes == 0)
+        return now;
+    if (bucket.next_free < now - burst)
+        bucket.next_free = now - burst;
+    bucket.next_free += std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(bytes) / bucket.bytes_per_sec));
+    return bucket.next_free - burst;
+}
+
+/**
+ * @brief Book the growth of a cumulative counter shared by all workers.
+ *
+ * A counter smaller than the last one seen means its baseline was reset,
+ * in which case the whole value is new traffic.
+ */
+BandwidthLimiter::clock::time_point BandwidthLimiter::reserve_total(Bucket& bucket,
+                                                                    size_t total_bytes) {
+    size_t delta =
+        total_bytes >= bucket.last_total ? total_bytes - bucket.last_total : total_bytes;
+    bucket.last_total = total_bytes;
+    return reserve(bucket, delta);
+}
+
+BandwidthLimiter::clock::time_point BandwidthLimiter::charge_download(size_t bytes) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return reserve(down_, bytes);
+}
+
+BandwidthLimiter::clock::time_point BandwidthLimiter::charge_upload_total(size_t total_bytes) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return reserve_total(up_, total_bytes);
+}
+
+BandwidthLimiter::clock::time_point BandwidthLimiter::charge_disk_total(size_t total_bytes) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return reserve_total(disk_, total_bytes);
+}
+
+} // namespace procutil
@@ -295,6 +295,161 @@ bool load_json_config(const std::string& path, std::map<std::string, std::string
     }
 }
 
+/**
+ * Turn the scalar fields of one manifest item into an entry.
+ */
+static bool make_manifest_entry(const std::map<std::string, std::string>& fields, size_t index,
+                                ManifestEntry& entry, std::string& error) {
+    std::string where = "repositories[" + std::to_string(index) + "]";
+    for (const auto& [key, val] : fields) {
+        if (key == "url") {
+            entry.url = val;
+        } else if (key == "path") {
+            entry.path = val;
+        } else if (key == "branch") {
+            entry.branch = val;
+        } else if (key == "depth") {
+            try {
+                size_t used = 0;
+                unsigned long d = std::stoul(val, &used);
+                if (used != val.size() || val[0] == '-')
+                    throw std::invalid_argument(val);
+                entry.depth = static_cast<unsigned int>(d);
+            } catch (const std::exception&) {
+                error = "Invalid depth in " + where;
+                return false;
+            }
+        } else {
+            error = "Unknown key '" + key + "' in " + where;
+            return false;
+        }
+    }
+    if (entry.url.empty()) {
+        error = "Missing url in " + where;
+        return false;
+    }
+    if (entry.path.empty()) {
+        std::string name = entry.url;
+        while (!name.empty() && (name.back() == '/' || name.back() == '\\'))
+            name.pop_back();
+        name = name.substr(name.find_last_of("/:\\") + 1);
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".git") == 0)
+            name.resize(name.size() - 4);
+        if (name.empty()) {
+            error = "Missing path in " + where;
+            return false;
+        }
+        entry.path = name;
+    }
+    return true;
+}
+
+bool load_yaml_manifest(const std::string& path, std::vector<ManifestEntry>& entries,
+                        std::string& error) {
+#ifdef HAVE_YAMLCPP
+    try {
+        std::ifstream ifs(path);
+        if (!ifs) {
+            error = "Failed to open file";
+            return false;
+        }
+        YAML::Node root = YAML::Load(ifs);
+        if (!root.IsMap() || !root["repositories"].IsSequence()) {
+            error = "Manifest needs a 'repositories' list";
+            return false;
+        }
+        const YAML::Node list = root["repositories"];
+        entries.clear();
+        for (size_t i = 0; i < list.size(); ++i) {
+            const YAML::Node item = list[i];
+            if (!item.IsMap()) {
+                error = "repositories[" + std::to_string(i) + "] must be a map";
+                return false;
+            }
+            std::map<std::string, std::string> fields;
+            for (auto it = item.begin(); it != item.end(); ++it) {
+                std::string key = it->first.as<std::string>();
+                if (!to_string_value(it->second, fields[key])) {
+                    error = "Invalid type for key '" + key + "' in repositories[" +
+                            std::to_string(i) + "]";
+                    return false;
+                }
+            }
+            ManifestEntry entry;
+            if (!make_manifest_entry(fields, i, entry, error))
+                return false;
+            entries.push_back(std::move(entry));
+        }
+        return true;
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+#else
+    (void)path;
+    (void)entries;
+    error = "YAML support not available";
+    return false;
+#endif
+}
+
+bool load_json_manifest(const std::string& path, std::vector<ManifestEntry>& entries,
+                        std::string& error) {
+    try {
+        std::ifstream ifs(path);
+        if (!ifs) {
+            error = "Failed to open file";
+            return false;
+        }
+        nlohmann::json root;
+        ifs >> root;
+        if (!root.is_object() || !root.contains("repositories") ||
+            !root["repositories"].is_array()) {
+            error = "Manifest needs a 'repositories' list";
+            return false;
+        }
+        const auto& list = root["repositories"];
+        entries.clear();
+        for (size_t i = 0; i < list.size(); ++i) {
+            const auto& item = list[i];
+            if (!item.is_object()) {
+                error = "repositories[" + std::to_string(i) + "] must be an object";
+                return false;
+            }
+            std::map<std::string, std::string> fields;
+            for (auto it = item.begin(); it != item.end(); ++it) {
+                if (!to_string_value(it.value(), fields[it.key()])) {
+                    error = "Invalid type for key '" + it.key() + "' in repositories[" +
+                            std::to_string(i) + "]";
+                    return false;
+                }
+            }
+            ManifestEntry entry;
+            if (!make_manifest_entry(fields, i, entry, error))
+                return false;
+            entries.push_back(std::move(entry));
+        }
+        return true;
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+}
+
+bool load_manifest(const std::string& path, const std::filesystem::path& root,
+                   std::vector<ManifestEntry>& entries, std::string& error) {
+    bool ok = std::filesystem::path(path).extension() == ".json"
+                  ? load_json_manifest(path, entries, error)
+                  : load_yaml_manifest(path, entries, error);
+    if (!ok)
+        return false;
+    for (auto& entry : entries) {
+        if (entry.path.is_relative())
+            entry.path = root / entry.path; // same form as the scanned repositories
+    }
+    return true;
+}
+
 static void assign_theme_field(const std::string& key, const std::string& val, TuiTheme& theme) {
     if (key == "reset")
         theme.reset = val;
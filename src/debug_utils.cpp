@@ -21,6 +21,8 @@ void dump_repo_infos(const std::map<std::filesystem::path, RepoInfo>& infos,
         }
         oss << "\n"
             << p.string() << " status=" << static_cast<int>(info.status) << " msg=" << info.message;
+        if (info.pack_count > 0 || info.loose_objects > 0)
+            oss << " packs=" << info.pack_count << " loose=" << info.loose_objects;
     }
     log_debug(oss.str());
 }
@@ -0,0 +1,107 @@
+#include "due_scheduler.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace procutil {
+
+DueScheduler::DueScheduler(std::chrono::seconds min_interval, std::chrono::seconds max_interval)
+    : rng_(std::random_device{}()) {
+    set_bounds(min_interval, max_interval);
+}
+
+void DueScheduler::set_bounds(std::chrono::seconds min_interval,
+                              std::chrono::seconds max_interval) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    min_ = std::max<clock::duration>(min_interval, std::chrono::seconds(1));
+    max_ = std::max<clock::duration>(max_interval, min_);
+    for (auto& [path, e] : entries_)
+        e.interval = clamp(e.interval);
+}
+
+std::chrono::seconds DueScheduler::min_interval() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return std::chrono::duration_cast<std::chrono::seconds>(min_);
+}
+
+std::chrono::seconds DueScheduler::max_interval() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return std::chrono::duration_cast<std::chrono::seconds>(max_);
+}
+
+DueScheduler::clock::duration DueScheduler::clamp(clock::duration d) const {
+    return std::clamp(d, min_, max_);
+}
+
+DueScheduler::clock::duration DueScheduler::jitter(clock::duration d) {
+    // +/-10% keeps repositories that were checked together from staying in step
+    std::uniform_real_distribution<double> spread(0.9, 1.1);
+    return std::chrono::duration_cast<clock::duration>(d * spread(rng_));
+}
+
+DueScheduler::Entry& DueScheduler::entry(const fs::path& repo, clock::time_point now) {
+    auto it = entries_.find(repo);
+    if (it != entries_.end())
+        return it->second;
+    std::uniform_int_distribution<clock::rep> offset(0, min_.count() - 1);
+    return entries_.emplace(repo, Entry{min_, now + clock::duration(offset(rng_))}).first->second;
+}
+
+DueScheduler::clock::time_point DueScheduler::due_at(const fs::path& repo,
+                                                      clock::time_point now) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return entry(repo, now).due;
+}
+
+void DueScheduler::started(const fs::path& repo, clock::time_point now) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    Entry& e = entry(repo, now);
+    e.due = now + e.interval;
+}
+
+void DueScheduler::checked(const fs::path& repo, Upstream upstream, clock::time_point now) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    Entry& e = entry(repo, now);
+    if (upstream == Upstream::Changed)
+        e.interval = clamp(e.interval / 2);
+    else if (upstream == Upstream::Unchanged)
+        e.interval = clamp(e.interval + e.interval / 2);
+    e.due = now + jitter(e.interval);
+}
+
+void DueScheduler::defer(const fs::path& repo, clock::time_point not_before) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    Entry& e = entry(repo, not_before);
+    e.due = std::max(e.due, not_before);
+}
+
+std::chrono::seconds DueScheduler::interval(const fs::path& repo) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto it = entries_.find(repo);
+    clock::duration d = it == entries_.end() ? min_ : it->second.interval;
+    return std::chrono::duration_cast<std::chrono::seconds>(d);
+}
+
+DueScheduler::clock::time_point DueScheduler::next_due(const std::vector<fs::path>& repos,
+                                                        clock::time_point now) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    clock::time_point next = clock::time_point::max();
+    for (const auto& p : repos)
+        next = std::min(next, entry(p, now).due);
+    return next;
+}
+
+void DueScheduler::retain(const std::vector<fs::path>& repos) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    std::unordered_set<fs::path, PathHash> keep(repos.begin(), repos.end());
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (keep.count(it->first))
+            ++it;
+        else
+            it = entries_.erase(it);
+    }
+}
+
+} // namespace procutil
@@ -0,0 +1,172 @@
+#include "fetch_error.hpp"
+
+#include <git2.h>
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+// The GIT_TIMEOUT error code arrived in libgit2 1.7
+#if LIBGIT2_VER_MAJOR > 1 || (LIBGIT2_VER_MAJOR == 1 && LIBGIT2_VER_MINOR >= 7)
+#define AUTOGITPULL_TIMEOUT_CODE 1
+#endif
+
+namespace git {
+
+static std::string to_lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(),
+                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    return s;
+}
+
+/**
+ * @brief Read the number following @a key in @a text.
+ *
+ * Separators such as spaces, colons and equals signs between the key and
+ * the number are skipped.
+ *
+ * @return Parsed value, or -1 when @a key is absent or not followed by digits.
+ */
+static long long number_after(const std::string& text, const std::string& key,
+                              size_t* end = nullptr) {
+    size_t pos = text.find(key);
+    if (pos == std::string::npos)
+        return -1;
+    pos += key.size();
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == ':' || text[pos] == '='))
+        ++pos;
+    size_t start = pos;
+    long long value = 0;
+    while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])) &&
+           pos - start < 9)
+        value = value * 10 + (text[pos++] - '0');
+    if (pos == start)
+        return -1;
+    if (end)
+        *end = pos;
+    return value;
+}
+
+FetchError classify_fetch_error(int code, int klass, const std::string& message,
+                                int* http_status) {
+    std::string msg = to_lower(message);
+    long long status = number_after(msg, "status code");
+    if (status < 0)
+        status = number_after(msg, "http status");
+    if (status < 100 || status > 599)
+        status = 0;
+    if (http_status)
+        *http_status = static_cast<int>(status);
+    auto has = [&](const char* s) { return msg.find(s) != std::string::npos; };
+    if (code == GIT_EAUTH)
+        return FetchError::Auth;
+    if (code == GIT_ECERTIFICATE)
+        return FetchError::Tls;
+#ifdef AUTOGITPULL_TIMEOUT_CODE
+    if (code == GIT_TIMEOUT)
+        return FetchError::Timeout;
+#endif
+    if (status == 429)
+        return FetchError::RateLimit;
+    if (status == 401 || status == 403)
+        return FetchError::Auth;
+    if (status >= 500)
+        return FetchError::Server;
+    if (status == 404 || code == GIT_ENOTFOUND)
+        return FetchError::NotFound;
+    // The error class narrows the kind; its message only tells a timeout
+    // or a failed lookup apart from other failures of that class
+    const bool timed_out = has("timed out") || has("timeout");
+    const bool unresolved = has("failed to resolve") || has("getaddrinfo") ||
+                            has("name or service not known") || has("no such host");
+    if (klass == GIT_ERROR_SSL)
+        return timed_out ? FetchError::Timeout : FetchError::Tls;
+    if (klass == GIT_ERROR_NET || klass == GIT_ERROR_SSH) {
+        if (timed_out)
+            return FetchError::Timeout;
+        if (unresolved)
+            return FetchError::Dns;
+        return FetchError::Network;
+    }
+    // Errors from other classes, such as ones raised by a transport
+    // callback, are recognised by specific phrases only
+    if (has("rate limit") || has("too many requests"))
+        return FetchError::RateLimit;
+    if (timed_out)
+        return FetchError::Timeout;
+    if (unresolved)
+        return FetchError::Dns;
+    if (has("certificate") || has("ssl error") || has("tls handshake"))
+        return FetchError::Tls;
+    if (has("authentication required") || has("authentication failed") ||
+        has("invalid credentials") || has("401 unauthorized") || has("403 forbidden"))
+        return FetchError::Auth;
+    if (has("repository not found") || has("does not appear to be a git repository") ||
+        has("does not exist"))
+        return FetchError::NotFound;
+    if (has("connection") || has("early eof") || has("broken pipe") || has("unreachable"))
+        return FetchError::Network;
+    return FetchError::Other;
+}
+
+std::chrono::seconds parse_retry_hint(const std::string& text) {
+    std::string msg = to_lower(text);
+    for (const char* key : {"retry-after", "retry after", "retry in", "try again in"}) {
+        size_t end = 0;
+        long long value = number_after(msg, key, &end);
+        if (value < 0)
+            continue;
+        while (end < msg.size() && msg[end] == ' ')
+            ++end;
+        char unit = end < msg.size() ? msg[end] : 's';
+        bool millis = msg.compare(end, 2, "ms") == 0;
+        if (unit == 'h')
+            value *= 3600;
+        else if (unit == 'm' && !millis)
+            value *= 60;
+        return std::chrono::seconds(std::min<long long>(value, 24 * 3600));
+    }
+    return std::chrono::seconds(0);
+}
+
+bool is_transient(FetchError kind) {
+    switch (kind) {
+    case FetchError::RateLimit:
+    case FetchError::Timeout:
+    case FetchError::Dns:
+    case FetchError::Server:
+    case FetchError::Network:
+        return true;
+    default:
+        return false;
+    }
+}
+
+const char* fetch_error_name(FetchError kind) {
+    switch (kind) {
+    case FetchError::None:
+        return "none";
+    case FetchError::Auth:
+        return "auth";
+    case FetchError::RateLimit:
+        return "rate limit";
+    case FetchError::Timeout:
+        return "timeout";
+    case FetchError::Dns:
+        return "dns";
+    case FetchError::Tls:
+        return "tls";
+    case FetchError::Server:
+        return "server error";
+    case FetchError::NotFound:
+        return "not found";
+    case FetchError::Network:
+        return "network";
+    case FetchError::Cancelled:
+        return "cancelled";
+    case FetchError::Other:
+        break;
+    }
+    return "other";
+}
+
+} // namespace git
@@ -7,15 +7,36 @@
 #include <ctime>
 #include <algorithm>
 #include <cctype>
+#include <climits>
+#include <iterator>
+#include <set>
+#include <cstddef>
+#include <utility>
 #include <vector>
 #include "resource_utils.hpp"
+#include "bandwidth_limiter.hpp"
+#include "traffic_budget.hpp"
+#include "mirror_cache.hpp"
+#include "remote_head_cache.hpp"
 #include "options.hpp"
 
 using namespace std;
 
+// Shallow fetches (git_fetch_options::depth) and socket timeouts arrived in
+// libgit2 1.7
+#if LIBGIT2_VER_MAJOR > 1 || (LIBGIT2_VER_MAJOR == 1 && LIBGIT2_VER_MINOR >= 7)
+#define AUTOGITPULL_SHALLOW_FETCH 1
+#define AUTOGITPULL_SERVER_TIMEOUT 1
+#endif
+
+// Limiting open pack files arrived in libgit2 1.1
+#if LIBGIT2_VER_MAJOR > 1 || (LIBGIT2_VER_MAJOR == 1 && LIBGIT2_VER_MINOR >= 1)
+#define AUTOGITPULL_MWINDOW_FILE_LIMIT 1
+#endif
+
 namespace git {
 
-static unsigned int g_libgit_timeout = 0;
+static bool g_status_cache = false;
 
 /**
  * @brief Read credentials from a file.
@@ -38,23 +59,16 @@ static bool read_credential_file(const fs::path& path, std::string& user, std::s
 }
 
 /**
- * @brief Configure the global libgit2 network timeout.
+ * @brief Let dirty checks write refreshed stat data back to the index.
  *
- * When supported by the linked libgit2, this sets a timeout applied to
- * network operations initiated by the library.
+ * Files whose stat information is stale but whose content is unchanged are
+ * otherwise re-hashed on every check. Storing the refreshed entries lets
+ * later checks of a clean tree rely on stat data alone.
  *
- * @param seconds Timeout value in seconds.
+ * @param enabled Whether dirty checks may update the index.
  * @return None.
  */
-void set_libgit_timeout(unsigned int seconds) {
-    g_libgit_timeout = seconds;
-#ifdef GIT_OPT_SET_TIMEOUT
-    if (g_libgit_timeout > 0)
-        git_libgit2_opts(GIT_OPT_SET_TIMEOUT, g_libgit_timeout);
-#else
-    (void)g_libgit_timeout;
-#endif
-}
+void set_status_cache(bool enabled) { g_status_cache = enabled; }
 
 void set_proxy(const std::string& url) {
 #ifdef GIT_OPT_SET_PROXY
@@ -64,19 +78,145 @@ void set_proxy(const std::string& url) {
 #endif
 }
 
+/// Socket timeout when no pull timeout is configured; libgit2 waits forever
+static constexpr std::chrono::seconds DEFAULT_SERVER_TIMEOUT{120};
+
+void set_server_timeouts(std::chrono::seconds timeout) {
+#ifdef AUTOGITPULL_SERVER_TIMEOUT
+    if (timeout.count() <= 0)
+        timeout = DEFAULT_SERVER_TIMEOUT;
+    int ms = static_cast<int>(
+        std::min<std::chrono::milliseconds::rep>(timeout.count() * 1000, INT_MAX));
+    git_libgit2_opts(GIT_OPT_SET_SERVER_CONNECT_TIMEOUT, ms);
+    git_libgit2_opts(GIT_OPT_SET_SERVER_TIMEOUT, ms);
+#else
+    (void)timeout;
+#endif
+}
+
+void apply_libgit2_options(const Libgit2Options& opts) {
+    // libgit2's own values, read before the first change
+    struct Defaults {
+        size_t window = 0;
+        size_t limit = 0;
+        size_t files = 0;
+    };
+    static const Defaults defaults = [] {
+        Defaults d;
+        git_libgit2_opts(GIT_OPT_GET_MWINDOW_SIZE, &d.window);
+        git_libgit2_opts(GIT_OPT_GET_MWINDOW_MAPPED_LIMIT, &d.limit);
+#ifdef AUTOGITPULL_MWINDOW_FILE_LIMIT
+        git_libgit2_opts(GIT_OPT_GET_MWINDOW_FILE_LIMIT, &d.files);
+#endif
+        return d;
+    }();
+    constexpr size_t default_cache = 256ull * 1024ull * 1024ull;
+
+    size_t cache = opts.cache_size.value_or(default_cache);
+    git_libgit2_opts(GIT_OPT_ENABLE_CACHING, cache > 0 ? 1 : 0);
+    if (cache > 0)
+        git_libgit2_opts(GIT_OPT_SET_CACHE_MAX_SIZE, static_cast<std::ptrdiff_t>(cache));
+    git_libgit2_opts(GIT_OPT_SET_MWINDOW_SIZE, opts.mmap_window.value_or(defaults.window));
+    git_libgit2_opts(GIT_OPT_SET_MWINDOW_MAPPED_LIMIT, opts.mmap_limit.value_or(defaults.limit));
+#ifdef AUTOGITPULL_MWINDOW_FILE_LIMIT
+    git_libgit2_opts(GIT_OPT_SET_MWINDOW_FILE_LIMIT, opts.open_packs.value_or(defaults.files));
+#endif
+    git_libgit2_opts(GIT_OPT_ENABLE_STRICT_OBJECT_CREATION,
+                     opts.strict_object_creation.value_or(true) ? 1 : 0);
+    git_libgit2_opts(GIT_OPT_ENABLE_STRICT_HASH_VERIFICATION,
+                     opts.strict_hash_verification.value_or(true) ? 1 : 0);
+    git_libgit2_opts(GIT_OPT_ENABLE_FSYNC_GITDIR, opts.fsync_gitdir.value_or(false) ? 1 : 0);
+}
+
 struct ProgressData {
     const std::function<void(int)>* cb;
     std::chrono::steady_clock::time_point start;
     size_t down_limit;
     size_t up_limit;
     size_t disk_limit;
+    procutil::BandwidthLimiter* shared = nullptr; ///< Aggregate budget across workers
+    size_t charged_down = 0;                      ///< Received bytes already charged
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    const std::atomic<bool>* running = nullptr; ///< Cancellation token, null if none
+    bool timed_out = false;                     ///< Deadline passed during the transfer
+    bool cancelled = false;                     ///< Token was cleared during the transfer
+    std::string server_messages;                ///< Sideband text sent by the remote
+    procutil::TrafficBudget* budget = nullptr;  ///< Charged as bytes arrive, null if none
+    size_t received_bytes = 0;                  ///< Bytes received so far
 };
 
+/**
+ * @brief Decide whether a transfer should stop.
+ *
+ * Called from every libgit2 callback of a fetch. A non-zero return makes
+ * libgit2 abort the operation with GIT_EUSER.
+ *
+ * @param pd Transfer state holding the deadline and cancellation token.
+ * @return -1 to abort, 0 to continue.
+ */
+static int check_abort(ProgressData& pd) {
+    if (pd.running && !pd.running->load()) {
+        pd.cancelled = true;
+        return -1;
+    }
+    if (std::chrono::steady_clock::now() >= pd.deadline) {
+        pd.timed_out = true;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Copy the deadline and cancellation token of @a params into @a pd.
+ *
+ * The deadline is the earlier of the absolute deadline and the per-fetch
+ * timeout counted from `pd.start`.
+ */
+static void set_abort(ProgressData& pd, const FetchParams& params) {
+    pd.deadline = params.deadline;
+    if (params.timeout.count() > 0)
+        pd.deadline = std::min(pd.deadline, pd.start + params.timeout);
+    pd.running = params.running;
+}
+
+/**
+ * @brief Connect @a remote for fetching unless the operation should stop.
+ *
+ * libgit2 fires no transfer callback while it connects and reads the ref
+ * advertisement, so the deadline and token are checked around the call and
+ * the socket timeouts from set_server_timeouts() bound a stalled remote.
+ *
+ * @return 0 when connected, GIT_EUSER when aborted, else the libgit2 error.
+ */
+static int connect_remote(git_remote* remote, const git_remote_callbacks* callbacks,
+                          ProgressData& pd) {
+    if (check_abort(pd) != 0)
+        return GIT_EUSER;
+    int err = git_remote_connect(remote, GIT_DIRECTION_FETCH, callbacks, nullptr, nullptr);
+    if (check_abort(pd) != 0) {
+        if (err == 0)
+            git_remote_disconnect(remote);
+        return GIT_EUSER;
+    }
+    return err;
+}
+
+/**
+ * @brief Sleep for throttling without overrunning the transfer deadline.
+ */
+static void throttle_until(const ProgressData& pd, std::chrono::steady_clock::time_point until) {
+    std::this_thread::sleep_until(std::min(until, pd.deadline));
+}
+
 /**
  * @brief Build a transfer progress callback with rate limiting support.
  *
  * The callback reports percentage progress and throttles network and disk
- * usage according to the provided limits.
+ * usage according to the provided per-transfer limits. When a shared
+ * limiter is set, newly moved bytes are also charged to the aggregate
+ * budget and the transfer sleeps until its turn. Transfers with a deadline
+ * or cancellation token are aborted from the callback once either fires.
+ * With a traffic budget, received bytes are charged to it as they arrive.
  *
  * @param cb Optional user callback receiving progress percentage.
  * @param pd Structure tracking rate limits and start time.
@@ -85,12 +225,22 @@ struct ProgressData {
 static git_transfer_progress_cb make_progress_callback(const std::function<void(int)>* cb,
                                                        ProgressData& pd) {
     pd.cb = cb;
-    if (!cb && pd.down_limit == 0 && pd.up_limit == 0 && pd.disk_limit == 0)
+    if (!cb && pd.down_limit == 0 && pd.up_limit == 0 && pd.disk_limit == 0 &&
+        !(pd.shared && pd.shared->active()) && !pd.running && !pd.budget &&
+        pd.deadline == std::chrono::steady_clock::time_point::max())
         return nullptr;
     return [](const git_transfer_progress* stats, void* payload) -> int {
         if (!payload)
             return 0;
         auto* pd = static_cast<ProgressData*>(payload);
+        size_t received = stats->received_bytes;
+        if (received > pd->received_bytes) {
+            if (pd->budget)
+                pd->budget->add(received - pd->received_bytes); // aborted transfers count too
+            pd->received_bytes = received;
+        }
+        if (check_abort(*pd) != 0)
+            return -1;
         if (pd->cb) {
             int pct = 0;
             if (stats->total_objects > 0)
@@ -123,13 +273,42 @@ static git_transfer_progress_cb make_progress_callback(const std::function<void(
         }
         if (expected_ms > elapsed) {
             // Sleep to throttle throughput when exceeding rate limits
-            std::this_thread::sleep_for(
-                std::chrono::milliseconds(static_cast<int>(expected_ms - elapsed)));
+            throttle_until(*pd, std::chrono::steady_clock::now() +
+                                    std::chrono::milliseconds(
+                                        static_cast<int>(expected_ms - elapsed)));
         }
-        return 0;
+        if (pd->shared) {
+            size_t received = stats->received_bytes;
+            auto until = pd->shared->charge_download(
+                received >= pd->charged_down ? received - pd->charged_down : received);
+            pd->charged_down = received;
+            if (pd->shared->limits_upload())
+                until = std::max(until, pd->shared->charge_upload_total(
+                                            procutil::get_network_usage().upload_bytes));
+            if (pd->shared->limits_disk()) {
+                auto du = procutil::get_disk_usage();
+                until =
+                    std::max(until, pd->shared->charge_disk_total(du.read_bytes + du.write_bytes));
+            }
+            throttle_until(*pd, until); // wait for this transfer's share
+        }
+        return check_abort(*pd);
     };
 }
 
+/**
+ * @brief Keep the text a remote sends on the sideband and check for abort.
+ *
+ * Server messages arrive during negotiation, before any pack data. They
+ * are kept because a throttled server may say when to retry.
+ */
+static int collect_sideband(const char* str, int len, void* payload) {
+    auto* pd = static_cast<ProgressData*>(payload);
+    if (str && len > 0 && pd->server_messages.size() < 4096)
+        pd->server_messages.append(str, static_cast<size_t>(len));
+    return check_abort(*pd);
+}
+
 /**
  * @brief libgit2 credential callback implementing precedence rules.
  *
@@ -168,7 +347,6 @@ static std::optional<std::string> safe_getenv(const char* name) {
 
 int credential_cb(git_credential** out, const char* url, const char* username_from_url,
                   unsigned int allowed_types, void* payload) {
-    GitInitGuard guard;
     (void)url;
     const Options* opts = static_cast<const Options*>(payload);
     auto env_user = safe_getenv("GIT_USERNAME");
@@ -220,10 +398,6 @@ int credential_cb(git_credential** out, const char* url, const char* username_fr
  */
 GitInitGuard::GitInitGuard() {
     git_libgit2_init();
-#ifdef GIT_OPT_SET_TIMEOUT
-    if (g_libgit_timeout > 0)
-        git_libgit2_opts(GIT_OPT_SET_TIMEOUT, g_libgit_timeout);
-#endif
 }
 
 /**
@@ -270,22 +444,47 @@ static void set_error(std::string* error) {
         *error = "Unknown libgit2 error";
 }
 
+/**
+ * @brief Create a session for the repository at @a path.
+ *
+ * The repository itself is opened lazily on first use.
+ *
+ * @param path Path to the repository working tree.
+ */
+RepoSession::RepoSession(fs::path path) : path_(std::move(path)) {}
+
+/**
+ * @brief Open the repository once and return the cached handle.
+ *
+ * @param error Optional output string receiving an error description.
+ * @return Repository handle or `nullptr` if it cannot be opened.
+ */
+git_repository* RepoSession::repo(string* error) {
+    if (!opened_) {
+        opened_ = true;
+        git_repository* raw = nullptr;
+        if (git_repository_open(&raw, path_.string().c_str()) != 0)
+            set_error(&open_error_);
+        else
+            repo_.h = raw;
+    }
+    if (!repo_.get() && error)
+        *error = open_error_;
+    return repo_.get();
+}
+
 /**
  * @brief Obtain the commit hash pointed to by HEAD.
  *
- * @param repo  Path to an existing repository.
  * @param error Optional output string receiving an error description.
  * @return Hash string on success or `std::nullopt` on failure.
  */
-optional<string> get_local_hash(const fs::path& repo, string* error) {
-    git_repository* raw = nullptr;
-    if (git_repository_open(&raw, repo.string().c_str()) != 0) {
-        set_error(error);
+optional<string> RepoSession::local_hash(string* error) {
+    git_repository* r = repo(error);
+    if (!r)
         return nullopt;
-    }
-    repo_ptr r(raw);
     git_oid oid;
-    if (git_reference_name_to_id(&oid, r.get(), "HEAD") != 0) {
+    if (git_reference_name_to_id(&oid, r, "HEAD") != 0) {
         set_error(error);
         return nullopt;
     }
@@ -295,19 +494,15 @@ optional<string> get_local_hash(const fs::path& repo, string* error) {
 /**
  * @brief Determine the currently checked-out branch.
  *
- * @param repo  Path to an existing repository.
  * @param error Optional output string receiving an error description.
  * @return Branch name or `std::nullopt` if it cannot be determined.
  */
-optional<string> get_current_branch(const fs::path& repo, string* error) {
-    git_repository* raw = nullptr;
-    if (git_repository_open(&raw, repo.string().c_str()) != 0) {
-        set_error(error);
+optional<string> RepoSession::current_branch(string* error) {
+    git_repository* r = repo(error);
+    if (!r)
         return nullopt;
-    }
-    repo_ptr r(raw);
     git_reference* head = nullptr;
-    if (git_repository_head(&head, r.get()) != 0) {
+    if (git_repository_head(&head, r) != 0) {
         set_error(error);
         return nullopt;
     }
@@ -322,44 +517,328 @@ optional<string> get_current_branch(const fs::path& repo, string* error) {
 }
 
 /**
- * @brief Open a repository and fetch a remote.
+ * @brief Obtain the commit hash pointed to by HEAD.
  *
- * @param repo           Path to repository.
- * @param remote         Name of remote to fetch.
- * @param use_credentials Whether to use credential callback.
- * @param auth_failed    Output flag set when authentication fails.
- * @param error          Optional output string for error details.
- * @return Pointer to opened repository or `nullptr` on failure.
+ * @param repo  Path to an existing repository.
+ * @param error Optional output string receiving an error description.
+ * @return Hash string on success or `std::nullopt` on failure.
  */
-static git_repository* open_and_fetch_remote(const fs::path& repo, const string& remote,
-                                             bool use_credentials, bool* auth_failed,
-                                             string* error) {
-    git_repository* raw_repo = nullptr;
-    if (git_repository_open(&raw_repo, repo.string().c_str()) != 0) {
-        set_error(error);
-        return nullptr;
+optional<string> get_local_hash(const fs::path& repo, string* error) {
+    RepoSession session(repo);
+    return session.local_hash(error);
+}
+
+/**
+ * @brief Determine the currently checked-out branch.
+ *
+ * @param repo  Path to an existing repository.
+ * @param error Optional output string receiving an error description.
+ * @return Branch name or `std::nullopt` if it cannot be determined.
+ */
+optional<string> get_current_branch(const fs::path& repo, string* error) {
+    RepoSession session(repo);
+    return session.current_branch(error);
+}
+
+/**
+ * @brief Record the last libgit2 error in a fetch result.
+ *
+ * @param result Fetch result to update.
+ * @param code   Return code of the failing libgit2 call.
+ * @return None.
+ */
+static void record_fetch_error(FetchResult& result, int code) {
+    result.ok = false;
+    result.error_code = code;
+    const git_error* e = git_error_last();
+    result.error_class = e ? e->klass : 0;
+    result.error = e && e->message ? e->message : "Fetch failed";
+    result.kind =
+        classify_fetch_error(code, result.error_class, result.error, &result.http_status);
+    if (result.kind == FetchError::Auth)
+        result.auth_failed = true;
+}
+
+/**
+ * @brief Resolve the remote-tracking branch after a fetch.
+ *
+ * @param result Fetch result receiving the branch hash and commit time.
+ * @param branch Branch name on the remote.
+ * @return None.
+ */
+void RepoSession::resolve_remote_branch(FetchResult& result, const string& branch) {
+    result.branch = branch;
+    result.remote_hash.clear();
+    result.remote_commit_time = 0;
+    git_oid oid;
+    string refname = string("refs/remotes/") + result.remote + "/" + branch;
+    if (git_reference_name_to_id(&oid, repo(), refname.c_str()) != 0) {
+        set_error(&result.error);
+        return;
+    }
+    result.remote_hash = oid_to_hex(oid);
+    git_commit* commit = nullptr;
+    if (git_commit_lookup(&commit, repo(), &oid) != 0)
+        return;
+    object_ptr cmt(reinterpret_cast<git_object*>(commit));
+    result.remote_commit_time = static_cast<std::time_t>(git_commit_time(commit));
+}
+
+/**
+ * @brief Check whether the remote still advertises the locally tracked tip.
+ *
+ * Connects to the remote and reads its ref advertisement without
+ * downloading a pack. On a mismatch the connection is left open so the
+ * following fetch reuses it.
+ *
+ * @param remote      Looked up remote handle.
+ * @param r           Opened repository.
+ * @param remote_name Name of the remote.
+ * @param branch      Branch to compare.
+ * @param callbacks   Callbacks used for authentication.
+ * @param pd          Deadline and cancellation token of the fetch.
+ * @return True when `refs/heads/<branch>` matches `refs/remotes/<remote>/<branch>`.
+ */
+static bool advertised_tip_unchanged(git_remote* remote, git_repository* r,
+                                     const string& remote_name, const string& branch,
+                                     const git_remote_callbacks* callbacks, ProgressData& pd) {
+    git_oid tracking;
+    string tracking_ref = string("refs/remotes/") + remote_name + "/" + branch;
+    if (git_reference_name_to_id(&tracking, r, tracking_ref.c_str()) != 0)
+        return false;
+    if (connect_remote(remote, callbacks, pd) != 0)
+        return false;
+    const git_remote_head** heads = nullptr;
+    size_t count = 0;
+    if (git_remote_ls(&heads, &count, remote) != 0)
+        return false;
+    string wanted = "refs/heads/" + branch;
+    for (size_t i = 0; i < count; ++i) {
+        if (heads[i]->name && wanted == heads[i]->name) {
+            if (!git_oid_equal(&heads[i]->oid, &tracking))
+                return false;
+            git_remote_disconnect(remote);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Build the refspecs a fetch should negotiate.
+ *
+ * @param remote Name of the remote.
+ * @param branch Branch the caller wants resolved.
+ * @param params Fetch settings.
+ * @return Refspecs to pass to libgit2, empty for the remote's defaults.
+ */
+static std::vector<string> fetch_refspecs(const string& remote, const string& branch,
+                                          const FetchParams& params) {
+    if (!params.refspecs.empty())
+        return params.refspecs;
+    if (!params.single_branch || branch.empty())
+        return {};
+    return {"+refs/heads/" + branch + ":refs/remotes/" + remote + "/" + branch};
+}
+
+/**
+ * @brief Map a tag policy onto libgit2's download_tags setting.
+ */
+static git_remote_autotag_option_t download_tags_for(TagPolicy policy) {
+    switch (policy) {
+    case TagPolicy::None:
+        return GIT_REMOTE_DOWNLOAD_TAGS_NONE;
+    case TagPolicy::Auto:
+        return GIT_REMOTE_DOWNLOAD_TAGS_AUTO;
+    case TagPolicy::All:
+        break;
+    }
+    return GIT_REMOTE_DOWNLOAD_TAGS_ALL;
+}
+
+/**
+ * @brief Fetch a remote once per session and record the outcome.
+ *
+ * Failures are classified into FetchResult::kind and are not retried here;
+ * the scanner schedules retries, honouring any retry hint the remote sent
+ * in its error or sideband messages. The transfer and sideband callbacks abort the fetch once
+ * FetchParams::timeout or FetchParams::deadline passes or the running flag
+ * clears. Subsequent calls for the same remote return the stored result.
+ * When ls-remote probing is enabled and the advertised branch tip equals the
+ * remote-tracking ref, the download is skipped entirely; a RemoteHeadCache
+ * lets repositories cloned from the same URL share that probe. A cached result is
+ * reused when it came from a full fetch or from the same refspecs, and when
+ * no different shallow depth is requested.
+ *
+ * @param remote Name of remote to fetch.
+ * @param branch Branch to resolve after fetching, empty to skip.
+ * @param params Credential, rate limit and progress settings.
+ * @return Result of the fetch, owned by the session.
+ */
+const FetchResult& RepoSession::fetch(const string& remote, const string& branch,
+                                      const FetchParams& params) {
+    std::vector<string> refspecs = fetch_refspecs(remote, branch, params);
+    if (fetch_ && fetch_->remote == remote &&
+        (fetch_->refspecs.empty() || fetch_->refspecs == refspecs) &&
+        (params.depth == 0 || fetch_->depth == params.depth)) {
+        if (fetch_->ok && !branch.empty() && fetch_->branch != branch)
+            resolve_remote_branch(*fetch_, branch);
+        return *fetch_;
+    }
+    fetch_.emplace();
+    FetchResult& result = *fetch_;
+    result.remote = remote;
+    result.refspecs = refspecs;
+    result.depth = params.depth;
+    git_repository* r = repo(&result.error);
+    if (!r) {
+        result.error_code = -1;
+        return result;
     }
     git_remote* raw_remote = nullptr;
-    if (git_remote_lookup(&raw_remote, raw_repo, remote.c_str()) != 0) {
-        set_error(error);
-        git_repository_free(raw_repo);
-        return nullptr;
+    int err = git_remote_lookup(&raw_remote, r, remote.c_str());
+    if (err != 0) {
+        record_fetch_error(result, err);
+        return result;
     }
     remote_ptr remote_handle(raw_remote);
+    const char* upstream_url = git_remote_url(remote_handle.get());
+    // Clones of one URL share a single ref listing per cycle, failures
+    // included. A repository whose remote-tracking ref already matches the
+    // advertised tip has nothing to download.
+    bool listed = false;
+    if (params.remote_heads && !branch.empty() && upstream_url &&
+        (params.ls_remote_probe || params.remote_heads->shared(upstream_url))) {
+        auto heads = params.remote_heads->get(*this, remote, params);
+        if (!heads->ok) {
+            result.auth_failed = heads->auth_failed;
+            result.kind = heads->kind;
+            result.timed_out = heads->kind == FetchError::Timeout;
+            result.retry_after = heads->retry_after;
+            result.error = heads->error;
+            result.error_code = heads->error_code;
+            return result;
+        }
+        listed = true;
+        git_oid tracking;
+        string tracking_ref = "refs/remotes/" + remote + "/" + branch;
+        auto tip = heads->refs.find("refs/heads/" + branch);
+        if (tip != heads->refs.end() &&
+            git_reference_name_to_id(&tracking, r, tracking_ref.c_str()) == 0 &&
+            oid_to_hex(tracking) == tip->second) {
+            result.ok = true;
+            result.fetch_skipped = true;
+            resolve_remote_branch(result, branch);
+            return result;
+        }
+    }
+    // Through a mirror cache the network fetch lands in the shared mirror,
+    // once per cycle for each URL, and this repository then fetches from the
+    // mirror on disk. Shallow repositories keep fetching directly because
+    // the local transport cannot deepen or shorten a history.
+    FetchParams local_params;
+    remote_ptr mirror_handle;
+    std::vector<string> mirror_specs;
+    bool via_mirror = params.mirror && params.depth == 0 && upstream_url &&
+                      !url_host(upstream_url).empty();
+    if (via_mirror) {
+        FetchResult upstream = params.mirror->refresh(upstream_url, params);
+        if (!upstream.ok) {
+            upstream.remote = result.remote;
+            upstream.refspecs = result.refspecs;
+            upstream.depth = result.depth;
+            result = upstream;
+            return result;
+        }
+        // Without the alternate the local fetch just copies the objects
+        if (params.mirror->alternates())
+            params.mirror->link_alternate(r, upstream_url);
+        string mirror_path = params.mirror->path_for(upstream_url).string();
+        git_remote* raw_mirror = nullptr;
+        err = git_remote_create_anonymous(&raw_mirror, r, mirror_path.c_str());
+        if (err != 0) {
+            record_fetch_error(result, err);
+            return result;
+        }
+        mirror_handle.h = raw_mirror;
+        // The transfer is local: it is neither rate limited nor counted
+        // against the traffic budget.
+        local_params = params;
+        local_params.down_limit_kbps = 0;
+        local_params.up_limit_kbps = 0;
+        local_params.shared_limiter = nullptr;
+        local_params.traffic_budget = nullptr;
+        mirror_specs = result.refspecs;
+        if (mirror_specs.empty())
+            mirror_specs = {"+refs/heads/*:refs/remotes/" + remote + "/*"};
+    }
+    const FetchParams& fp = via_mirror ? local_params : params;
+    git_remote* active = via_mirror ? mirror_handle.get() : remote_handle.get();
     git_fetch_options fetch_opts = GIT_FETCH_OPTIONS_INIT;
-    if (use_credentials)
-        fetch_opts.callbacks.credentials = credential_cb; // provide credentials when requested
-    int err = git_remote_fetch(remote_handle.get(), nullptr, &fetch_opts, nullptr);
+    fetch_opts.download_tags = download_tags_for(fp.tags);
+    if (fp.prune)
+        fetch_opts.prune = GIT_FETCH_PRUNE;
+#ifdef AUTOGITPULL_SHALLOW_FETCH
+    fetch_opts.depth = fp.depth;
+#endif
+    git_remote_callbacks callbacks = GIT_REMOTE_CALLBACKS_INIT;
+    ProgressData progress{nullptr, std::chrono::steady_clock::now(), fp.down_limit_kbps,
+                          fp.up_limit_kbps, fp.disk_limit_kbps, fp.shared_limiter};
+    set_abort(progress, fp);
+    progress.budget = fp.traffic_budget;
+    if (fp.up_limit_kbps > 0)
+        procutil::init_network_usage(); // capture initial network usage for rate limiting
+    auto transfer_cb = make_progress_callback(fp.progress_cb, progress);
+    if (transfer_cb) {
+        if (fp.disk_limit_kbps > 0)
+            procutil::init_disk_usage(); // start tracking disk I/O
+        callbacks.payload = &progress;
+        callbacks.transfer_progress = transfer_cb; // enable progress and throttling
+        callbacks.sideband_progress = collect_sideband;
+    }
+    if (fp.use_credentials)
+        callbacks.credentials = credential_cb;
+    fetch_opts.callbacks = callbacks;
+    if (fp.ls_remote_probe && !listed && !branch.empty() &&
+        advertised_tip_unchanged(active, r, remote, branch, &callbacks, progress)) {
+        result.ok = true;
+        result.fetch_skipped = true; // remote tip already present locally
+        resolve_remote_branch(result, branch);
+        return result;
+    }
+    std::vector<char*> specs;
+    for (auto& spec : via_mirror ? mirror_specs : result.refspecs)
+        specs.push_back(spec.data());
+    git_strarray spec_array{specs.data(), specs.size()};
+    const git_strarray* spec_arg = specs.empty() ? nullptr : &spec_array;
+    // The probe may have used up the time; check before connecting again
+    err = check_abort(progress) != 0 ? GIT_EUSER
+                                     : git_remote_fetch(active, spec_arg, &fetch_opts, nullptr);
+    if (const git_indexer_progress* stats = git_remote_stats(active)) {
+        result.total_objects = stats->total_objects;
+        result.received_objects = stats->received_objects;
+        result.local_objects = stats->local_objects;
+        result.indexed_deltas = stats->indexed_deltas;
+        result.received_bytes = stats->received_bytes;
+    }
     if (err != 0) {
-        const git_error* e = git_error_last();
-        if (auth_failed && e && e->message &&
-            std::string(e->message).find("auth") != std::string::npos)
-            *auth_failed = true;
-        git_repository_free(raw_repo);
-        set_error(error);
-        return nullptr;
+        record_fetch_error(result, err);
+        result.timed_out = progress.timed_out || result.kind == FetchError::Timeout;
+        result.cancelled = progress.cancelled;
+        if (result.timed_out) {
+            result.kind = FetchError::Timeout;
+            result.error = "Fetch timed out";
+        } else if (result.cancelled) {
+            result.kind = FetchError::Cancelled;
+            result.error = "Fetch cancelled";
+        }
+        result.retry_after = parse_retry_hint(result.error + "\n" + progress.server_messages);
+        return result;
     }
-    return raw_repo;
+    result.ok = true;
+    if (!branch.empty())
+        resolve_remote_branch(result, branch);
+    return result;
 }
 
 /**
@@ -375,18 +854,18 @@ static git_repository* open_and_fetch_remote(const fs::path& repo, const string&
  */
 optional<string> get_remote_hash(const fs::path& repo, const string& remote, const string& branch,
                                  bool use_credentials, bool* auth_failed, string* error) {
-    git_repository* raw_repo =
-        open_and_fetch_remote(repo, remote, use_credentials, auth_failed, error);
-    if (!raw_repo)
-        return nullopt;
-    repo_ptr r(raw_repo);
-    git_oid oid;
-    string refname = string("refs/remotes/") + remote + "/" + branch;
-    if (git_reference_name_to_id(&oid, r.get(), refname.c_str()) != 0) {
-        set_error(error);
+    RepoSession session(repo);
+    FetchParams params;
+    params.use_credentials = use_credentials;
+    const FetchResult& result = session.fetch(remote, branch, params);
+    if (auth_failed && result.auth_failed)
+        *auth_failed = true;
+    if (!result.ok || result.remote_hash.empty()) {
+        if (error)
+            *error = result.error;
         return nullopt;
     }
-    return oid_to_hex(oid);
+    return result.remote_hash;
 }
 
 /**
@@ -402,40 +881,28 @@ optional<string> get_remote_hash(const fs::path& repo, const string& remote, con
 std::time_t get_remote_commit_time(const fs::path& repo, const std::string& remote,
                                    const std::string& branch, bool use_credentials,
                                    bool* auth_failed) {
-    git_repository* raw_repo =
-        open_and_fetch_remote(repo, remote, use_credentials, auth_failed, nullptr);
-    if (!raw_repo)
-        return 0;
-    repo_ptr r(raw_repo);
-    git_oid oid;
-    std::string refname = std::string("refs/remotes/") + remote + "/" + branch;
-    if (git_reference_name_to_id(&oid, r.get(), refname.c_str()) != 0)
-        return 0;
-    git_commit* commit = nullptr;
-    if (git_commit_lookup(&commit, r.get(), &oid) != 0)
-        return 0;
-    object_ptr cmt(reinterpret_cast<git_object*>(commit));
-    git_time_t t = git_commit_time(commit);
-    return static_cast<std::time_t>(t);
+    RepoSession session(repo);
+    FetchParams params;
+    params.use_credentials = use_credentials;
+    const FetchResult& result = session.fetch(remote, branch, params);
+    if (auth_failed && result.auth_failed)
+        *auth_failed = true;
+    return result.ok ? result.remote_commit_time : 0;
 }
 
 /**
  * @brief Retrieve the configured URL for a remote.
  *
- * @param repo  Path to repository.
  * @param remote Remote name.
- * @param error Optional output string receiving error details.
+ * @param error  Optional output string receiving error details.
  * @return Remote URL or `std::nullopt` on error.
  */
-optional<string> get_remote_url(const fs::path& repo, const string& remote, string* error) {
-    git_repository* raw_repo = nullptr;
-    if (git_repository_open(&raw_repo, repo.string().c_str()) != 0) {
-        set_error(error);
+optional<string> RepoSession::remote_url(const string& remote, string* error) {
+    git_repository* r = repo(error);
+    if (!r)
         return nullopt;
-    }
-    repo_ptr r(raw_repo);
     git_remote* raw_remote = nullptr;
-    if (git_remote_lookup(&raw_remote, r.get(), remote.c_str()) != 0) {
+    if (git_remote_lookup(&raw_remote, r, remote.c_str()) != 0) {
         set_error(error);
         return nullopt;
     }
@@ -448,6 +915,19 @@ optional<string> get_remote_url(const fs::path& repo, const string& remote, stri
     return string(url);
 }
 
+/**
+ * @brief Retrieve the configured URL for a remote.
+ *
+ * @param repo  Path to repository.
+ * @param remote Remote name.
+ * @param error Optional output string receiving error details.
+ * @return Remote URL or `std::nullopt` on error.
+ */
+optional<string> get_remote_url(const fs::path& repo, const string& remote, string* error) {
+    RepoSession session(repo);
+    return session.remote_url(remote, error);
+}
+
 /**
  * @brief Check whether a URL targets GitHub.
  *
@@ -456,30 +936,242 @@ optional<string> get_remote_url(const fs::path& repo, const string& remote, stri
  */
 bool is_github_url(const string& url) { return url.find("github.com") != string::npos; }
 
+/**
+ * @brief Extract the host name from a remote URL.
+ *
+ * Handles `scheme://[user@]host[:port]/path` and scp-like
+ * `[user@]host:path` forms.
+ *
+ * @param url Remote URL.
+ * @return Lower-case host name, empty for local paths and `file://` URLs.
+ */
+string url_host(const string& url) {
+    string host;
+    auto scheme = url.find("://");
+    if (scheme != string::npos) {
+        if (url.compare(0, scheme, "file") == 0)
+            return "";
+        host = url.substr(scheme + 3);
+        host = host.substr(0, host.find('/'));
+        auto at = host.rfind('@');
+        if (at != string::npos)
+            host = host.substr(at + 1);
+        if (!host.empty() && host.front() == '[') {
+            host = host.substr(1, host.find(']') - 1); // IPv6 literal
+        } else {
+            host = host.substr(0, host.find(':'));
+        }
+    } else {
+        auto colon = url.find(':');
+        auto slash = url.find_first_of("/\\");
+        // Local paths, including Windows drive letters, have no host part
+        if (colon == string::npos || colon < 2 || (slash != string::npos && slash < colon))
+            return "";
+        host = url.substr(0, colon);
+        auto at = host.rfind('@');
+        if (at != string::npos)
+            host = host.substr(at + 1);
+    }
+    std::transform(host.begin(), host.end(), host.begin(),
+                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    return host;
+}
+
+/**
+ * @brief Normalise a remote URL for comparisons between clones.
+ *
+ * @param url Remote URL in URL or scp-like syntax.
+ * @return URL with lower-case scheme and host and no `.git` suffix.
+ */
+string normalize_remote_url(const string& url) {
+    string out = url;
+    while (!out.empty() && (out.back() == '/' || out.back() == '\\'))
+        out.pop_back();
+    if (out.size() > 4 && out.compare(out.size() - 4, 4, ".git") == 0)
+        out.resize(out.size() - 4);
+    if (url_host(out).empty())
+        return out; // local paths compare as written
+    // Lower-case everything up to the path, keeping a user name as written
+    size_t scheme = out.find("://");
+    size_t authority = scheme == string::npos ? 0 : scheme + 3;
+    size_t path = scheme == string::npos ? out.find(':') : out.find('/', authority);
+    if (path == string::npos)
+        path = out.size();
+    size_t at = out.rfind('@', path);
+    size_t host = at == string::npos || at < authority ? authority : at + 1;
+    auto lower = [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); };
+    std::transform(out.begin(), out.begin() + authority, out.begin(), lower);
+    std::transform(out.begin() + host, out.begin() + path, out.begin() + host, lower);
+    return out;
+}
+
 /**
  * @brief Test connectivity to a remote.
  *
- * @param repo   Path to repository.
  * @param remote Remote name to check.
+ * @param params Deadline, timeout and cancellation token of the check.
  * @return True if the remote can be connected to.
  */
-bool remote_accessible(const fs::path& repo, const string& remote) {
-    git_repository* raw_repo = nullptr;
-    if (git_repository_open(&raw_repo, repo.string().c_str()) != 0)
+bool RepoSession::remote_accessible(const string& remote, const FetchParams& params) {
+    git_repository* r = repo();
+    if (!r)
         return false;
-    repo_ptr r(raw_repo);
     git_remote* raw_remote = nullptr;
-    if (git_remote_lookup(&raw_remote, r.get(), remote.c_str()) != 0)
+    if (git_remote_lookup(&raw_remote, r, remote.c_str()) != 0)
         return false;
     remote_ptr remote_handle(raw_remote);
-    int err =
-        git_remote_connect(remote_handle.get(), GIT_DIRECTION_FETCH, nullptr, nullptr, nullptr);
+    ProgressData pd{nullptr, std::chrono::steady_clock::now(), 0, 0, 0};
+    set_abort(pd, params);
+    int err = connect_remote(remote_handle.get(), nullptr, pd);
     bool ok = err == 0;
     if (ok)
         git_remote_disconnect(remote_handle.get());
     return ok;
 }
 
+/**
+ * @brief List the refs a remote advertises.
+ *
+ * @param remote Remote name.
+ * @param params Credentials, deadline, timeout and cancellation token.
+ * @return Advertised refs, or the classified connection failure.
+ */
+RemoteHeads RepoSession::list_remote(const string& remote, const FetchParams& params) {
+    RemoteHeads heads;
+    git_repository* r = repo(&heads.error);
+    if (!r) {
+        heads.kind = FetchError::Other;
+        heads.error_code = -1;
+        return heads;
+    }
+    FetchResult failure;
+    git_remote* raw_remote = nullptr;
+    int err = git_remote_lookup(&raw_remote, r, remote.c_str());
+    if (err != 0) {
+        record_fetch_error(failure, err);
+    } else {
+        remote_ptr remote_handle(raw_remote);
+        git_remote_callbacks callbacks = GIT_REMOTE_CALLBACKS_INIT;
+        if (params.use_credentials)
+            callbacks.credentials = credential_cb;
+        ProgressData pd{nullptr, std::chrono::steady_clock::now(), 0, 0, 0};
+        set_abort(pd, params);
+        const git_remote_head** refs = nullptr;
+        size_t count = 0;
+        err = connect_remote(remote_handle.get(), &callbacks, pd);
+        if (err == 0)
+            err = git_remote_ls(&refs, &count, remote_handle.get());
+        if (err != 0) {
+            record_fetch_error(failure, err);
+            if (pd.timed_out) {
+                failure.kind = FetchError::Timeout;
+                failure.error = "Listing remote refs timed out";
+            } else if (pd.cancelled) {
+                failure.kind = FetchError::Cancelled;
+                failure.error = "Listing remote refs cancelled";
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                if (refs[i]->name)
+                    heads.refs[refs[i]->name] = oid_to_hex(refs[i]->oid);
+            }
+            heads.ok = true;
+        }
+        git_remote_disconnect(remote_handle.get());
+    }
+    if (!heads.ok) {
+        heads.auth_failed = failure.auth_failed;
+        heads.kind = failure.kind;
+        heads.error = failure.error;
+        heads.error_code = failure.error_code;
+        heads.retry_after = parse_retry_hint(failure.error);
+    }
+    return heads;
+}
+
+/**
+ * @brief Test connectivity to a remote.
+ *
+ * @param repo   Path to repository.
+ * @param remote Remote name to check.
+ * @return True if the remote can be connected to.
+ */
+bool remote_accessible(const fs::path& repo, const string& remote) {
+    RepoSession session(repo);
+    return session.remote_accessible(remote);
+}
+
+/**
+ * @brief Look up the commit pointed to by HEAD.
+ *
+ * @param r   Opened repository.
+ * @param out Receives the commit, owned by the caller.
+ * @return True when the commit was found.
+ */
+static bool lookup_head_commit(git_repository* r, git_commit** out) {
+    if (!r)
+        return false;
+    git_oid oid;
+    if (git_reference_name_to_id(&oid, r, "HEAD") != 0)
+        return false;
+    return git_commit_lookup(out, r, &oid) == 0;
+}
+
+/**
+ * @brief Diff notification callback aborting at the first change.
+ *
+ * @param payload Pointer to a bool set once a delta is seen.
+ * @return Negative value stopping the diff.
+ */
+static int stop_at_first_delta(const git_diff*, const git_diff_delta*, const char*,
+                               void* payload) {
+    *static_cast<bool*>(payload) = true;
+    return -1; // abort, the caller only needs to know that something changed
+}
+
+/**
+ * @brief Determine whether the repository has uncommitted changes.
+ *
+ * Compares HEAD with the index and then the index with the working tree,
+ * stopping at the first difference. Rename detection is skipped. As with
+ * git status, an untracked directory only counts when it holds a file that
+ * is not ignored. With the status cache enabled, refreshed stat data is
+ * written back to the index.
+ *
+ * @return True if the working tree is dirty.
+ */
+bool RepoSession::has_uncommitted_changes() {
+    git_repository* r = repo();
+    if (!r)
+        return false;
+    bool dirty = false;
+    git_diff_options opts = GIT_DIFF_OPTIONS_INIT;
+    opts.flags = GIT_DIFF_SKIP_BINARY_CHECK;
+    opts.notify_cb = stop_at_first_delta;
+    opts.payload = &dirty;
+
+    git_tree* raw_tree = nullptr;
+    git_commit* head = nullptr;
+    if (lookup_head_commit(r, &head)) {
+        object_ptr head_obj(reinterpret_cast<git_object*>(head));
+        git_commit_tree(&raw_tree, head);
+    }
+    tree_ptr head_tree(raw_tree); // unborn HEAD compares against the empty tree
+    git_diff* raw_diff = nullptr;
+    int err = git_diff_tree_to_index(&raw_diff, r, head_tree.get(), nullptr, &opts);
+    diff_ptr staged(raw_diff);
+    if (dirty || err != 0)
+        return dirty;
+
+    opts.flags |= GIT_DIFF_INCLUDE_UNTRACKED;
+    if (g_status_cache)
+        opts.flags |= GIT_DIFF_UPDATE_INDEX;
+    raw_diff = nullptr;
+    git_diff_index_to_workdir(&raw_diff, r, nullptr, &opts);
+    diff_ptr unstaged(raw_diff);
+    return dirty;
+}
+
 /**
  * @brief Determine whether the repository has uncommitted changes.
  *
@@ -487,18 +1179,75 @@ bool remote_accessible(const fs::path& repo, const string& remote) {
  * @return True if the working tree is dirty.
  */
 bool has_uncommitted_changes(const fs::path& repo) {
+    RepoSession session(repo);
+    return session.has_uncommitted_changes();
+}
+
+/**
+ * @brief Clone a repository under the limits, deadline and token of a fetch.
+ *
+ * Received bytes are charged to the traffic budget of @a params while the
+ * clone runs, and a failure is classified like a failed fetch.
+ *
+ * @param dest   Destination path for clone.
+ * @param url    Remote URL.
+ * @param params Credentials, rate limits, traffic budget, depth, deadline and token.
+ * @param branch Branch to check out, empty for the remote's default.
+ * @return Outcome of the clone; `ok` is set on success.
+ */
+FetchResult clone_repo(const fs::path& dest, const std::string& url, const FetchParams& params,
+                       const std::string& branch) {
+    FetchResult result;
+    result.branch = branch;
+    result.depth = params.depth;
+    git_clone_options opts = GIT_CLONE_OPTIONS_INIT;
+    git_remote_callbacks callbacks = GIT_REMOTE_CALLBACKS_INIT;
+    ProgressData progress{nullptr, std::chrono::steady_clock::now(), params.down_limit_kbps,
+                          params.up_limit_kbps, params.disk_limit_kbps, params.shared_limiter};
+    set_abort(progress, params);
+    progress.budget = params.traffic_budget;
+    if (params.up_limit_kbps > 0)
+        procutil::init_network_usage(); // track upload usage for rate limiting
+    auto transfer_cb = make_progress_callback(params.progress_cb, progress);
+    if (transfer_cb) {
+        if (params.disk_limit_kbps > 0)
+            procutil::init_disk_usage(); // track disk I/O for throttling
+        callbacks.payload = &progress;
+        callbacks.transfer_progress = transfer_cb; // enable progress reporting and limits
+        callbacks.sideband_progress = collect_sideband;
+    }
+    if (params.use_credentials)
+        callbacks.credentials = credential_cb;
+    opts.fetch_opts.callbacks = callbacks;
+#ifdef AUTOGITPULL_SHALLOW_FETCH
+    opts.fetch_opts.depth = params.depth;
+#endif
+    if (!branch.empty())
+        opts.checkout_branch = branch.c_str();
     git_repository* raw_repo = nullptr;
-    if (git_repository_open(&raw_repo, repo.string().c_str()) != 0)
-        return false;
-    repo_ptr r(raw_repo);
-    git_status_options opts = GIT_STATUS_OPTIONS_INIT;
-    opts.show = GIT_STATUS_SHOW_INDEX_AND_WORKDIR;
-    opts.flags = GIT_STATUS_OPT_INCLUDE_UNTRACKED | GIT_STATUS_OPT_RENAMES_HEAD_TO_INDEX;
-    git_status_list* raw_list = nullptr;
-    if (git_status_list_new(&raw_list, r.get(), &opts) != 0)
-        return false;
-    status_list_ptr list(raw_list);
-    return git_status_list_entrycount(list.get()) > 0;
+    int err = check_abort(progress) != 0
+                  ? GIT_EUSER
+                  : git_clone(&raw_repo, url.c_str(), dest.string().c_str(), &opts);
+    result.received_bytes = progress.received_bytes;
+    if (err != 0) {
+        record_fetch_error(result, err);
+        if (result.error.empty() || result.error == "Fetch failed")
+            result.error = "Clone failed";
+        result.timed_out = progress.timed_out || result.kind == FetchError::Timeout;
+        result.cancelled = progress.cancelled;
+        if (progress.timed_out) {
+            result.kind = FetchError::Timeout;
+            result.error = "Clone timed out";
+        } else if (progress.cancelled) {
+            result.kind = FetchError::Cancelled;
+            result.error = "Clone cancelled";
+        }
+        result.retry_after = parse_retry_hint(result.error + "\n" + progress.server_messages);
+        return result;
+    }
+    repo_ptr repo(raw_repo);
+    result.ok = true;
+    return result;
 }
 
 /**
@@ -512,62 +1261,214 @@ bool has_uncommitted_changes(const fs::path& repo) {
  * @param down_limit_kbps Download rate limit in KiB/s.
  * @param up_limit_kbps   Upload rate limit in KiB/s.
  * @param disk_limit_kbps Disk I/O rate limit in KiB/s.
+ * @param depth           History depth to clone, 0 for the full history.
+ * @param shared_limiter  Bandwidth budget shared with other transfers, may be null.
+ * @param branch          Branch to check out, empty for the remote's default.
+ * @param error           Receives the libgit2 error message, may be null.
  * @return True on success, false otherwise.
  */
 bool clone_repo(const fs::path& dest, const std::string& url,
                 const std::function<void(int)>* progress_cb, bool use_credentials,
                 bool* auth_failed, size_t down_limit_kbps, size_t up_limit_kbps,
-                size_t disk_limit_kbps) {
-    git_clone_options opts = GIT_CLONE_OPTIONS_INIT;
-    git_remote_callbacks callbacks = GIT_REMOTE_CALLBACKS_INIT;
-    ProgressData progress{nullptr, std::chrono::steady_clock::now(), down_limit_kbps, up_limit_kbps,
-                          disk_limit_kbps};
-    if (up_limit_kbps > 0)
-        procutil::init_network_usage(); // track upload usage for rate limiting
-    auto transfer_cb = make_progress_callback(progress_cb, progress);
-    if (transfer_cb) {
-        if (disk_limit_kbps > 0)
-            procutil::init_disk_usage(); // track disk I/O for throttling
-        callbacks.payload = &progress;
-        callbacks.transfer_progress = transfer_cb; // enable progress reporting and limits
+                size_t disk_limit_kbps, int depth, procutil::BandwidthLimiter* shared_limiter,
+                const std::string& branch, std::string* error) {
+    FetchParams params;
+    params.progress_cb = progress_cb;
+    params.use_credentials = use_credentials;
+    params.down_limit_kbps = down_limit_kbps;
+    params.up_limit_kbps = up_limit_kbps;
+    params.disk_limit_kbps = disk_limit_kbps;
+    params.depth = depth;
+    params.shared_limiter = shared_limiter;
+    FetchResult result = clone_repo(dest, url, params, branch);
+    if (auth_failed && result.auth_failed)
+        *auth_failed = true;
+    if (error && !result.ok)
+        *error = result.error;
+    return result.ok;
+}
+
+/**
+ * @brief Move HEAD to @a target, checking out only the paths that differ.
+ *
+ * The HEAD tree is diffed against the target tree and only the changed
+ * paths are handed to `git_checkout_tree`, with the HEAD tree as baseline.
+ * Unchanged files are neither rewritten nor re-validated, unlike a hard
+ * reset. The current branch, or the detached HEAD, is then moved.
+ *
+ * @param r      Opened repository.
+ * @param target Commit to update to.
+ * @param force  Overwrite local modifications of the changed paths.
+ * @param files  Receives the number of paths checked out.
+ * @return 0 on success, 3 when local files block the checkout, 2 on error.
+ */
+static int checkout_changed_paths(git_repository* r, const git_oid& target, bool force,
+                                  size_t& files) {
+    files = 0;
+    git_commit* raw_new = nullptr;
+    if (git_commit_lookup(&raw_new, r, &target) != 0)
+        return 2;
+    object_ptr new_commit(reinterpret_cast<git_object*>(raw_new));
+    git_commit* raw_old = nullptr;
+    if (!lookup_head_commit(r, &raw_old))
+        return 2;
+    object_ptr old_commit(reinterpret_cast<git_object*>(raw_old));
+    git_tree* raw_tree = nullptr;
+    if (git_commit_tree(&raw_tree, raw_old) != 0)
+        return 2;
+    tree_ptr old_tree(raw_tree);
+    if (git_commit_tree(&raw_tree, raw_new) != 0)
+        return 2;
+    tree_ptr new_tree(raw_tree);
+    git_diff* raw_diff = nullptr;
+    if (git_diff_tree_to_tree(&raw_diff, r, old_tree.get(), new_tree.get(), nullptr) != 0)
+        return 2;
+    diff_ptr diff(raw_diff);
+    std::vector<char*> paths;
+    for (size_t i = 0, n = git_diff_num_deltas(diff.get()); i < n; ++i) {
+        const git_diff_delta* delta = git_diff_get_delta(diff.get(), i);
+        // Without rename detection old and new paths match; deletions keep the path too
+        paths.push_back(const_cast<char*>(delta->new_file.path));
     }
-    if (use_credentials)
-        callbacks.credentials = credential_cb;
-    opts.fetch_opts.callbacks = callbacks;
-    git_repository* raw_repo = nullptr;
-    int err = git_clone(&raw_repo, url.c_str(), dest.string().c_str(), &opts);
-    if (err != 0) {
-        const git_error* e = git_error_last();
-        if (auth_failed && e && e->message &&
-            std::string(e->message).find("auth") != std::string::npos)
-            *auth_failed = true;
+    if (!paths.empty()) {
+        git_checkout_options co = GIT_CHECKOUT_OPTIONS_INIT;
+        co.checkout_strategy = (force ? GIT_CHECKOUT_FORCE : GIT_CHECKOUT_SAFE) |
+                               GIT_CHECKOUT_DISABLE_PATHSPEC_MATCH;
+        co.baseline = old_tree.get();
+        co.paths.strings = paths.data();
+        co.paths.count = paths.size();
+        int err = git_checkout_tree(r, new_commit.get(), &co);
+        if (err == GIT_ECONFLICT)
+            return 3;
+        if (err != 0)
+            return 2;
+    }
+    files = paths.size();
+    if (git_repository_head_detached(r) == 1)
+        return git_repository_set_head_detached(r, &target) == 0 ? 0 : 2;
+    git_reference* raw_head = nullptr;
+    if (git_repository_head(&raw_head, r) != 0)
+        return 2;
+    reference_ptr head(raw_head);
+    git_reference* raw_moved = nullptr;
+    if (git_reference_set_target(&raw_moved, head.get(), &target, "autogitpull: update") != 0)
+        return 2;
+    reference_ptr moved(raw_moved);
+    return 0;
+}
+
+/// Times a shallow history is doubled while it leaves a question open.
+static constexpr int MAX_DEEPEN_ROUNDS = 4;
+
+/// Depth a shallow history is never deepened beyond; a repository is never
+/// unshallowed, since that downloads the history --fetch-depth avoids.
+static constexpr int MAX_DEEPEN_DEPTH = 1000;
+
+/**
+ * @brief Whether the history of @a tip is cut off by a shallow boundary
+ *        before it reaches @a base.
+ *
+ * Walks the commits of @a tip that @a base does not have. When none of them
+ * is a shallow root, the local history answers whether @a tip descends from
+ * @a base; otherwise fetching deeper might change the answer.
+ */
+static bool ancestry_cut_off(git_repository* r, const git_oid& tip, const git_oid& base) {
+    std::set<string> roots;
+    std::ifstream shallow(fs::path(git_repository_path(r)) / "shallow");
+    for (string line; std::getline(shallow, line);) {
+        if (!line.empty())
+            roots.insert(line);
+    }
+    if (roots.empty())
         return false;
+    git_revwalk* raw_walk = nullptr;
+    if (git_revwalk_new(&raw_walk, r) != 0)
+        return true;
+    revwalk_ptr walk(raw_walk);
+    if (git_revwalk_push(walk.get(), &tip) != 0)
+        return true;
+    git_revwalk_hide(walk.get(), &base);
+    git_oid oid;
+    while (git_revwalk_next(&oid, walk.get()) == 0) {
+        if (roots.count(oid_to_hex(oid)))
+            return true;
     }
-    repo_ptr repo(raw_repo);
-    return true;
+    return false;
+}
+
+/**
+ * @brief Check whether a ref string is a (possibly abbreviated) commit id.
+ */
+static bool looks_like_oid(const string& ref) {
+    if (ref.size() < 4 || ref.size() > GIT_OID_HEXSZ)
+        return false;
+    return std::all_of(ref.begin(), ref.end(),
+                       [](unsigned char ch) { return std::isxdigit(ch) != 0; });
+}
+
+/**
+ * @brief Refspecs fetching only what a pull target ref can resolve to.
+ *
+ * @param remote Name of the remote.
+ * @param ref    Target ref as configured, e.g. `v1.2`, `main` or `refs/tags/v1.2`.
+ * @return Refspecs for the matching branch and tag on the remote.
+ */
+static std::vector<string> target_refspecs(const string& remote, const string& ref) {
+    if (ref.rfind("refs/heads/", 0) == 0)
+        return {"+" + ref + ":refs/remotes/" + remote + "/" + ref.substr(11)};
+    if (ref.rfind("refs/", 0) == 0)
+        return {"+" + ref + ":" + ref};
+    string name = ref;
+    if (name.rfind(remote + "/", 0) == 0)
+        name = name.substr(remote.size() + 1);
+    return {"+refs/heads/" + name + ":refs/remotes/" + remote + "/" + name,
+            "+refs/tags/" + name + ":refs/tags/" + name};
+}
+
+/**
+ * @brief Fetch settings `try_pull` uses for @a target_ref.
+ *
+ * With a single-branch fetch and a named target, only that branch or tag is
+ * fetched; @a narrowed holds the adjusted copy.
+ */
+static const FetchParams& pull_params(const FetchParams& params, const string& remote_name,
+                                      const std::string* target_ref, FetchParams& narrowed) {
+    if (target_ref && !target_ref->empty() && params.single_branch && params.refspecs.empty() &&
+        !looks_like_oid(*target_ref)) {
+        narrowed = params;
+        narrowed.refspecs = target_refspecs(remote_name, *target_ref);
+        return narrowed;
+    }
+    return params;
+}
+
+const FetchResult& fetch_for_pull(RepoSession& session, const string& remote_name,
+                                  const FetchParams& params, const std::string* target_ref) {
+    FetchParams narrowed;
+    string branch;
+    if (!target_ref || target_ref->empty())
+        branch = session.current_branch().value_or("");
+    return session.fetch(remote_name, branch,
+                         pull_params(params, remote_name, target_ref, narrowed));
 }
 
 /**
- * @brief Fast-forward pull from a remote with retry on rate limiting.
+ * @brief Fast-forward pull from a remote.
  *
- * @param repo             Path to repository.
+ * @param session          Session of the repository to update.
  * @param remote_name      Name of remote.
  * @param out_pull_log     Receives textual description of the action.
- * @param progress_cb      Optional progress callback.
- * @param use_credentials  Whether to use credential callback.
- * @param auth_failed      Output flag set if authentication fails.
- * @param down_limit_kbps  Download rate limit in KiB/s.
- * @param up_limit_kbps    Upload rate limit in KiB/s.
- * @param disk_limit_kbps  Disk I/O rate limit in KiB/s.
+ * @param params           Fetch settings used if the remote was not fetched yet.
  * @param force_pull       Ignore local changes and force reset.
+ * @param target_ref       Optional ref to check out instead of the branch.
+ * @param files_updated    Optional output receiving the number of files checked out.
  * @return Status code: 0 success, 2 failure, TRY_PULL_* constants for
  *         specific error cases.
  */
-int try_pull(const fs::path& repo, const string& remote_name, string& out_pull_log,
-             const std::function<void(int)>* progress_cb, bool use_credentials, bool* auth_failed,
-             size_t down_limit_kbps, size_t up_limit_kbps, size_t disk_limit_kbps, bool force_pull,
-             const std::string* target_ref) {
-
+int try_pull(RepoSession& session, const string& remote_name, string& out_pull_log,
+             const FetchParams& params, bool force_pull, const std::string* target_ref,
+             size_t* files_updated) {
+    const std::function<void(int)>* progress_cb = params.progress_cb;
     if (progress_cb)
         (*progress_cb)(0); // begin progress reporting
     auto finalize = [&]() {
@@ -577,18 +1478,16 @@ int try_pull(const fs::path& repo, const string& remote_name, string& out_pull_l
 
     const bool use_target = target_ref && !target_ref->empty();
 
-    git_repository* raw_repo = nullptr;
-
-    if (git_repository_open(&raw_repo, repo.string().c_str()) != 0) {
+    git_repository* r = session.repo();
+    if (!r) {
         out_pull_log = "Failed to open repository";
         finalize();
         return 2;
     }
-    repo_ptr r(raw_repo);
     string branch;
     if (!use_target) {
         string err;
-        auto br = get_current_branch(repo, &err);
+        auto br = session.current_branch(&err);
         if (!br) {
             out_pull_log = err;
             finalize();
@@ -597,91 +1496,50 @@ int try_pull(const fs::path& repo, const string& remote_name, string& out_pull_l
         branch = *br;
     }
     git_remote* raw_remote = nullptr;
-    if (git_remote_lookup(&raw_remote, r.get(), remote_name.c_str()) != 0) {
+    if (git_remote_lookup(&raw_remote, r, remote_name.c_str()) != 0) {
         out_pull_log = "No " + remote_name + " remote";
         finalize();
         return 2;
     }
-    remote_ptr remote_handle(raw_remote);
-    git_fetch_options fetch_opts = GIT_FETCH_OPTIONS_INIT;
-    fetch_opts.download_tags = GIT_REMOTE_DOWNLOAD_TAGS_ALL;
-    git_remote_callbacks callbacks = GIT_REMOTE_CALLBACKS_INIT;
-    ProgressData progress{nullptr, std::chrono::steady_clock::now(), down_limit_kbps, up_limit_kbps,
-                          disk_limit_kbps};
-    if (up_limit_kbps > 0)
-        procutil::init_network_usage(); // capture initial network usage for rate limiting
-    auto transfer_cb = make_progress_callback(progress_cb, progress);
-    if (transfer_cb) {
-        if (disk_limit_kbps > 0)
-            procutil::init_disk_usage(); // start tracking disk I/O
-        callbacks.payload = &progress;
-        callbacks.transfer_progress = transfer_cb; // enable progress and throttling
-    }
-    if (use_credentials)
-        callbacks.credentials = credential_cb;
-    fetch_opts.callbacks = callbacks;
-    int err = git_remote_fetch(remote_handle.get(), nullptr, &fetch_opts, nullptr);
-    if (err != 0) {
-        const git_error* e = git_error_last();
-        if (auth_failed && e && e->message &&
-            std::string(e->message).find("auth") != std::string::npos)
-            *auth_failed = true;
-        std::string msg = "Fetch failed";
-        if (e && e->message)
-            msg = e->message;
-        std::string msg_lower = msg;
-        std::transform(msg_lower.begin(), msg_lower.end(), msg_lower.begin(),
-                       [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
-        bool is_rate_limit = msg_lower.find("rate limit") != std::string::npos ||
-                             msg_lower.find("429") != std::string::npos;
-        if (is_rate_limit) {
-            finalize();
-            std::this_thread::sleep_for(std::chrono::seconds(2)); // back off before retrying
-            err = git_remote_fetch(remote_handle.get(), nullptr, &fetch_opts, nullptr);
-            if (err != 0) {
-                e = git_error_last();
-                msg = "Fetch failed";
-                if (e && e->message)
-                    msg = e->message;
-                msg_lower = msg;
-                std::transform(
-                    msg_lower.begin(), msg_lower.end(), msg_lower.begin(),
-                    [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
-                out_pull_log = msg;
-                finalize();
-                if (msg_lower.find("timed out") != std::string::npos ||
-                    msg_lower.find("timeout") != std::string::npos)
-                    return TRY_PULL_TIMEOUT;
-                if (msg_lower.find("rate limit") != std::string::npos ||
-                    msg_lower.find("429") != std::string::npos)
-                    return TRY_PULL_RATE_LIMIT;
-                return 2;
-            }
-        } else {
-            out_pull_log = msg;
-            finalize();
-            if (msg_lower.find("timed out") != std::string::npos ||
-                msg_lower.find("timeout") != std::string::npos)
-                return TRY_PULL_TIMEOUT;
-            if (msg_lower.find("rate limit") != std::string::npos ||
-                msg_lower.find("429") != std::string::npos)
-                return TRY_PULL_RATE_LIMIT;
-            return 2;
-        }
+    git_remote_free(raw_remote);
+    FetchParams target_params;
+    const FetchParams* fetch_params = &pull_params(params, remote_name, target_ref, target_params);
+    const FetchResult& fetched = session.fetch(remote_name, branch, *fetch_params);
+    if (!fetched.ok) {
+        out_pull_log = fetched.error;
+        finalize();
+        if (fetched.kind == FetchError::Timeout)
+            return TRY_PULL_TIMEOUT;
+        if (fetched.kind == FetchError::RateLimit)
+            return TRY_PULL_RATE_LIMIT;
+        return 2;
     }
     auto perform_reset = [&](const git_oid& oid, const std::string& success_msg) -> int {
         git_object* raw_target = nullptr;
-        if (git_object_lookup(&raw_target, r.get(), &oid, GIT_OBJECT_COMMIT) != 0) {
+        if (git_object_lookup(&raw_target, r, &oid, GIT_OBJECT_COMMIT) != 0) {
             out_pull_log = "Lookup failed";
             finalize();
             return 2;
         }
         object_ptr target(raw_target);
-        if (git_reset(r.get(), target.get(), GIT_RESET_HARD, nullptr) != 0) {
-            out_pull_log = "Reset failed";
-            finalize();
-            return 2;
+        size_t files = 0;
+        if (force_pull && session.has_uncommitted_changes()) {
+            // Discarding local work needs the whole tree reset
+            if (git_reset(r, target.get(), GIT_RESET_HARD, nullptr) != 0) {
+                out_pull_log = "Reset failed";
+                finalize();
+                return 2;
+            }
+        } else {
+            int code = checkout_changed_paths(r, oid, force_pull, files);
+            if (code != 0) {
+                out_pull_log = code == 3 ? "Local changes present" : "Checkout failed";
+                finalize();
+                return code;
+            }
         }
+        if (files_updated)
+            *files_updated = files;
         out_pull_log = success_msg;
         finalize();
         return 0;
@@ -698,7 +1556,7 @@ int try_pull(const fs::path& repo, const string& remote_name, string& out_pull_l
         }
         for (const auto& cand : candidates) {
             git_object* parsed = nullptr;
-            if (git_revparse_single(&parsed, r.get(), cand.c_str()) != 0)
+            if (git_revparse_single(&parsed, r, cand.c_str()) != 0)
                 continue;
             object_ptr parsed_obj(parsed);
             git_object* commit_obj = nullptr;
@@ -714,7 +1572,7 @@ int try_pull(const fs::path& repo, const string& remote_name, string& out_pull_l
         git_oid tmp;
         if (git_oid_fromstrp(&tmp, ref.c_str()) == 0) {
             git_object* commit_obj = nullptr;
-            if (git_object_lookup(&commit_obj, r.get(), &tmp, GIT_OBJECT_COMMIT) == 0) {
+            if (git_object_lookup(&commit_obj, r, &tmp, GIT_OBJECT_COMMIT) == 0) {
                 object_ptr commit(commit_obj);
                 out = tmp;
                 return true;
@@ -723,15 +1581,45 @@ int try_pull(const fs::path& repo, const string& remote_name, string& out_pull_l
         return false;
     };
 
+    // Deepen a shallow history until `resolved` holds, while `undecided`
+    // says more history could still change the outcome. The depth doubles
+    // up to MAX_DEEPEN_DEPTH; the history is never unshallowed.
+    auto deepen_until = [&](const std::function<bool()>& resolved,
+                            const std::function<bool()>& undecided) -> bool {
+        if (resolved())
+            return true;
+#ifdef AUTOGITPULL_SHALLOW_FETCH
+        if (fetch_params->depth <= 0)
+            return false;
+        FetchParams deeper = *fetch_params;
+        deeper.ls_remote_probe = false;
+        for (int round = 0; round < MAX_DEEPEN_ROUNDS; ++round) {
+            if (git_repository_is_shallow(r) != 1 || deeper.depth >= MAX_DEEPEN_DEPTH ||
+                !undecided())
+                return false;
+            deeper.depth = std::min(deeper.depth * 2, MAX_DEEPEN_DEPTH);
+            if (!session.fetch(remote_name, branch, deeper).ok)
+                return false;
+            if (resolved())
+                return true;
+        }
+#else
+        (void)undecided;
+#endif
+        return false;
+    };
+
     if (use_target) {
         git_oid desired_oid;
-        if (!resolve_target_oid(*target_ref, desired_oid)) {
+        // A ref missing from a shallow history may sit below its boundary
+        if (!deepen_until([&] { return resolve_target_oid(*target_ref, desired_oid); },
+                          [] { return true; })) {
             out_pull_log = "Target ref not found";
             finalize();
             return 2;
         }
         git_oid local_oid;
-        if (git_reference_name_to_id(&local_oid, r.get(), "HEAD") != 0) {
+        if (git_reference_name_to_id(&local_oid, r, "HEAD") != 0) {
             out_pull_log = "Local HEAD not found";
             finalize();
             return 2;
@@ -741,7 +1629,7 @@ int try_pull(const fs::path& repo, const string& remote_name, string& out_pull_l
             finalize();
             return 0;
         }
-        if (!force_pull && has_uncommitted_changes(repo)) {
+        if (!force_pull && session.has_uncommitted_changes()) {
             out_pull_log = "Local changes present";
             finalize();
             return 3;
@@ -751,13 +1639,13 @@ int try_pull(const fs::path& repo, const string& remote_name, string& out_pull_l
 
     git_oid remote_oid;
     string refname = string("refs/remotes/") + remote_name + "/" + branch;
-    if (git_reference_name_to_id(&remote_oid, r.get(), refname.c_str()) != 0) {
+    if (git_reference_name_to_id(&remote_oid, r, refname.c_str()) != 0) {
         out_pull_log = "Remote branch not found";
         finalize();
         return 2;
     }
     git_oid local_oid;
-    if (git_reference_name_to_id(&local_oid, r.get(), "HEAD") != 0) {
+    if (git_reference_name_to_id(&local_oid, r, "HEAD") != 0) {
         out_pull_log = "Local HEAD not found";
         finalize();
         return 2;
@@ -767,43 +1655,146 @@ int try_pull(const fs::path& repo, const string& remote_name, string& out_pull_l
         finalize();
         return 0;
     }
-    if (!force_pull && has_uncommitted_changes(repo)) {
+    // A shallow fetch may stop short of HEAD; deepen while the boundary
+    // hides whether the remote descends from it. A remote that was force
+    // pushed or diverged is reset to its fetched tip without deepening to
+    // the full history.
+    bool fast_forward = git_graph_descendant_of(r, &remote_oid, &local_oid) == 1;
+    if (!fast_forward && git_repository_is_shallow(r) == 1) {
+        fast_forward = deepen_until(
+            [&] {
+                return git_reference_name_to_id(&remote_oid, r, refname.c_str()) == 0 &&
+                       git_graph_descendant_of(r, &remote_oid, &local_oid) == 1;
+            },
+            [&] { return ancestry_cut_off(r, remote_oid, local_oid); });
+    }
+    if (!force_pull && session.has_uncommitted_changes()) {
         out_pull_log = "Local changes present";
         finalize();
         return 3;
     }
-    return perform_reset(remote_oid, "Fast-forwarded");
+    return perform_reset(remote_oid, fast_forward ? "Fast-forwarded" : "Reset to remote");
 }
 
 /**
- * @brief Return formatted date of the last commit.
+ * @brief Fast-forward pull from a remote.
+ *
+ * Convenience overload opening a session for @a repo.
  *
  * @param repo Path to repository.
- * @return Timestamp string or empty string on error.
+ * @return Status code as returned by the session overload.
  */
-string get_last_commit_date(const fs::path& repo) {
-    git_repository* raw = nullptr;
-    if (git_repository_open(&raw, repo.string().c_str()) != 0)
-        return "";
-    repo_ptr r(raw);
-    git_oid oid;
-    if (git_reference_name_to_id(&oid, r.get(), "HEAD") != 0)
-        return "";
+int try_pull(const fs::path& repo, const string& remote_name, string& out_pull_log,
+             const std::function<void(int)>* progress_cb, bool use_credentials, bool* auth_failed,
+             size_t down_limit_kbps, size_t up_limit_kbps, size_t disk_limit_kbps, bool force_pull,
+             const std::string* target_ref) {
+    RepoSession session(repo);
+    FetchParams params;
+    params.use_credentials = use_credentials;
+    params.down_limit_kbps = down_limit_kbps;
+    params.up_limit_kbps = up_limit_kbps;
+    params.disk_limit_kbps = disk_limit_kbps;
+    params.progress_cb = progress_cb;
+    int code = try_pull(session, remote_name, out_pull_log, params, force_pull, target_ref);
+    if (auth_failed && session.last_fetch() && session.last_fetch()->auth_failed)
+        *auth_failed = true;
+    return code;
+}
+
+/**
+ * @brief Read author, date and time of the HEAD commit in one lookup.
+ *
+ * @return Commit metadata; fields stay empty when HEAD cannot be resolved.
+ */
+CommitInfo RepoSession::head_commit_info() {
+    CommitInfo info;
     git_commit* commit = nullptr;
-    if (git_commit_lookup(&commit, r.get(), &oid) != 0)
-        return "";
+    if (!lookup_head_commit(repo(), &commit))
+        return info;
     object_ptr cmt(reinterpret_cast<git_object*>(commit));
-    git_time_t t = git_commit_time(commit);
-    std::time_t tt = static_cast<std::time_t>(t);
+    info.oid = oid_to_hex(*git_commit_id(commit));
+    info.time = static_cast<std::time_t>(git_commit_time(commit));
     std::tm tm{};
 #ifdef _WIN32
-    localtime_s(&tm, &tt);
+    localtime_s(&tm, &info.time);
 #else
-    localtime_r(&tt, &tm);
+    localtime_r(&info.time, &tm);
 #endif
     char buf[32];
     std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
-    return string(buf);
+    info.date = buf;
+    const git_signature* sig = git_commit_author(commit);
+    if (sig && sig->name)
+        info.author = sig->name;
+    return info;
+}
+
+/**
+ * @brief Return formatted date of the last commit.
+ *
+ * @return Timestamp string or empty string on error.
+ */
+string RepoSession::last_commit_date() { return head_commit_info().date; }
+
+/**
+ * @brief Obtain the timestamp of the last commit.
+ *
+ * @return time_t of last commit or 0 on error.
+ */
+std::time_t RepoSession::last_commit_time() { return head_commit_info().time; }
+
+/**
+ * @brief Retrieve the author name of the last commit.
+ *
+ * @return Author name or empty string on error.
+ */
+string RepoSession::last_commit_author() { return head_commit_info().author; }
+
+/**
+ * @brief Return cached HEAD metadata, refreshing it when HEAD moved.
+ *
+ * @param session Session of the repository.
+ * @return Metadata of the current HEAD commit.
+ */
+CommitInfo CommitInfoCache::get(RepoSession& session) {
+    git_oid oid;
+    git_repository* r = session.repo();
+    if (!r || git_reference_name_to_id(&oid, r, "HEAD") != 0)
+        return {};
+    string head = oid_to_hex(oid);
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto it = entries_.find(session.path());
+        if (it != entries_.end() && it->second.oid == head)
+            return it->second;
+    }
+    CommitInfo info = session.head_commit_info();
+    std::lock_guard<std::mutex> lk(mtx_);
+    entries_[session.path()] = info;
+    return info;
+}
+
+size_t CommitInfoCache::size() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return entries_.size();
+}
+
+void CommitInfoCache::retain(const std::vector<fs::path>& repos) {
+    std::set<fs::path> keep(repos.begin(), repos.end());
+    std::lock_guard<std::mutex> lk(mtx_);
+    for (auto it = entries_.begin(); it != entries_.end();)
+        it = keep.count(it->first) ? std::next(it) : entries_.erase(it);
+}
+
+/**
+ * @brief Return formatted date of the last commit.
+ *
+ * @param repo Path to repository.
+ * @return Timestamp string or empty string on error.
+ */
+string get_last_commit_date(const fs::path& repo) {
+    RepoSession session(repo);
+    return session.last_commit_date();
 }
 
 /**
@@ -813,19 +1804,8 @@ string get_last_commit_date(const fs::path& repo) {
  * @return time_t of last commit or 0 on error.
  */
 std::time_t get_last_commit_time(const fs::path& repo) {
-    git_repository* raw = nullptr;
-    if (git_repository_open(&raw, repo.string().c_str()) != 0)
-        return 0;
-    repo_ptr r(raw);
-    git_oid oid;
-    if (git_reference_name_to_id(&oid, r.get(), "HEAD") != 0)
-        return 0;
-    git_commit* commit = nullptr;
-    if (git_commit_lookup(&commit, r.get(), &oid) != 0)
-        return 0;
-    object_ptr cmt(reinterpret_cast<git_object*>(commit));
-    git_time_t t = git_commit_time(commit);
-    return static_cast<std::time_t>(t);
+    RepoSession session(repo);
+    return session.last_commit_time();
 }
 
 /**
@@ -835,21 +1815,8 @@ std::time_t get_last_commit_time(const fs::path& repo) {
  * @return Author name or empty string on error.
  */
 string get_last_commit_author(const fs::path& repo) {
-    git_repository* raw = nullptr;
-    if (git_repository_open(&raw, repo.string().c_str()) != 0)
-        return "";
-    repo_ptr r(raw);
-    git_oid oid;
-    if (git_reference_name_to_id(&oid, r.get(), "HEAD") != 0)
-        return "";
-    git_commit* commit = nullptr;
-    if (git_commit_lookup(&commit, r.get(), &oid) != 0)
-        return "";
-    object_ptr cmt(reinterpret_cast<git_object*>(commit));
-    const git_signature* sig = git_commit_author(commit);
-    if (!sig || !sig->name)
-        return "";
-    return string(sig->name);
+    RepoSession session(repo);
+    return session.last_commit_author();
 }
 
 } // namespace git
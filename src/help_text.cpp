@@ -19,10 +19,18 @@ void print_help(const char* prog) {
         {"--include-private", "-p", "", "Include private repositories", "Basics"},
         {"--root", "-o", "<path>", "Root folder of repositories", "Basics"},
         {"--interval", "-i", "<N[s|m|h|d|w|M|Y]>", "Delay between scans", "Basics"},
+        {"--adaptive-interval", "", "",
+         "Check each repo on its own learned interval, in scans of --min-interval", "Basics"},
+        {"--min-interval", "", "<N[s|m|h|d|w|M|Y]>", "Shortest interval of --adaptive-interval",
+         "Basics"},
+        {"--max-interval", "", "<N[s|m|h|d|w|M|Y]>", "Longest interval of --adaptive-interval",
+         "Basics"},
         {"--refresh-rate", "-r", "<ms|s|m>", "TUI refresh rate", "Basics"},
         {"--recursive", "-e", "", "Scan subdirectories recursively", "Basics"},
         {"--max-depth", "-D", "<n>", "Limit recursive scan depth", "Basics"},
         {"--include-dir", "", "<dir>", "Additional directory to scan (repeatable)", "Basics"},
+        {"--manifest", "", "<file>", "Clone the repositories listed in a YAML/JSON manifest",
+         "Basics"},
         {"--ignore", "-I", "<dir>", "Directory to ignore (repeatable)", "Ignores"},
         {"--single-run", "-u", "", "Run a single scan cycle and exit", "Basics"},
         {"--single-repo", "-S", "", "Only monitor the specified root repo", "Basics"},
@@ -30,7 +38,8 @@ void print_help(const char* prog) {
          "Basics"},
         {"--wait-empty", "-W", "[n]", "Keep retrying when no repos are found (optional limit)",
          "Basics"},
-        {"--dont-skip-timeouts", "", "", "Retry repositories that timeout", "Basics"},
+        {"--dont-skip-timeouts", "", "", "Retry timed-out repositories within the same scan",
+         "Basics"},
         {"--dont-skip-unavailable", "", "", "Retry repos missing or invalid on first pass",
          "Basics"},
         {"--retry-skipped", "", "", "Retry repositories skipped previously", "Basics"},
@@ -84,6 +93,23 @@ void print_help(const char* prog) {
         {"--censor-char", "", "<ch>", "Character for name masking", "Display"},
         {"--check-only", "-x", "", "Only check for updates", "Actions"},
         {"--no-hash-check", "-N", "", "Always pull without hash check", "Actions"},
+        {"--ls-remote", "", "", "Skip the fetch when the remote branch tip is unchanged",
+         "Actions"},
+        {"--fetch-tags", "", "<none|auto|all>", "Tags downloaded with each fetch", "Actions"},
+        {"--single-branch", "", "", "Fetch only the tracked branch or pull ref", "Actions"},
+        {"--prune", "", "", "Delete remote-tracking refs removed on the remote", "Actions"},
+        {"--fetch-depth", "", "<n>", "Keep shallow histories of n commits (0 = full)", "Actions"},
+        {"--pack-maintenance", "", "",
+         "Consolidate packs of fetched repositories in the background", "Actions"},
+        {"--max-packs", "", "<n>", "Unindexed packs before a multi-pack-index is written",
+         "Actions"},
+        {"--max-loose-objects", "", "<n>", "Loose objects before they are packed", "Actions"},
+        {"--mirror-cache", "", "<dir>", "Fetch each remote once per scan into shared mirrors",
+         "Actions"},
+        {"--mirror-alternates", "", "", "Borrow objects from the mirrors instead of copying",
+         "Actions"},
+        {"--status-cache", "", "", "Store refreshed stat data in the index on dirty checks",
+         "Actions"},
         {"--dry-run", "", "", "Simulate pulls without network operations", "Actions"},
         {"--force-pull", "-f", "", "Reset repos to remote, losing uncommitted work", "Actions"},
         {"--discard-dirty", "", "", "Alias for --force-pull; same data loss", "Actions"},
@@ -138,6 +164,9 @@ void print_help(const char* prog) {
         {"--threads", "-t", "<n>", "Alias for --concurrency", "Concurrency"},
         {"--single-thread", "-q", "", "Run using a single worker thread", "Concurrency"},
         {"--max-threads", "-M", "<n>", "Cap the scanning worker threads", "Concurrency"},
+        {"--fetch-concurrency", "", "<n>", "Workers fetching from remotes", "Concurrency"},
+        {"--checkout-concurrency", "", "<n>", "Workers updating work trees", "Concurrency"},
+        {"--hook-concurrency", "", "<n>", "Workers running post-pull hooks", "Concurrency"},
         {"--cpu-poll", "", "<N[s|m|h|d|w|M|Y]>", "CPU usage polling interval", "Tracking"},
         {"--mem-poll", "", "<N[s|m|h|d|w|M|Y]>", "Memory usage polling interval", "Tracking"},
         {"--thread-poll", "", "<N[s|m|h|d|w|M|Y]>", "Thread count polling interval", "Tracking"},
@@ -151,9 +180,26 @@ void print_help(const char* prog) {
         {"--download-limit", "", "<KB/MB>", "Limit total download rate", "Resource limits"},
         {"--upload-limit", "", "<KB/MB>", "Limit total upload rate", "Resource limits"},
         {"--show-commit-date", "-T", "", "Display last commit time", "Display"},
-        {"--disk-limit", "", "<KB/MB>", "Limit disk throughput", "Resource limits"},
-        {"--total-traffic-limit", "", "<KB/MB/GB>", "Stop after this much traffic",
+        {"--disk-limit", "", "<KB/MB>", "Limit total disk throughput", "Resource limits"},
+        {"--total-traffic-limit", "", "<KB/MB/GB>", "Daily fetch traffic budget",
+         "Resource limits"},
+        {"--cycle-traffic-limit", "", "<KB/MB/GB>", "Fetch traffic budget per scan",
+         "Resource limits"},
+        {"--git-profile", "", "<default|lean|fast>", "Preset for the libgit2 settings below",
+         "Resource limits"},
+        {"--git-cache-size", "", "<KB/MB/GB>", "libgit2 object cache size (0 = off)",
+         "Resource limits"},
+        {"--git-mmap-window", "", "<KB/MB/GB>", "Bytes mapped per pack window",
+         "Resource limits"},
+        {"--git-mmap-limit", "", "<KB/MB/GB>", "Bytes mapped across all packs",
+         "Resource limits"},
+        {"--git-open-packs", "", "<n>", "Pack files kept open at once (0 = no limit)",
+         "Resource limits"},
+        {"--no-strict-objects", "", "", "Skip validating objects libgit2 writes",
+         "Resource limits"},
+        {"--no-hash-verify", "", "", "Skip verifying hashes of objects libgit2 reads",
          "Resource limits"},
+        {"--git-fsync", "", "", "fsync objects and refs libgit2 writes", "Resource limits"},
         {"--show-commit-author", "-U", "", "Display last commit author", "Display"},
         {"--hide-date-time", "", "", "Hide date/time line in TUI", "Display"},
         {"--hide-header", "-H", "", "Hide status header", "Display"},
@@ -172,7 +218,8 @@ void print_help(const char* prog) {
         {"--wait-empty", "0"},     {"--row-order", "updated"},
         {"--pull-timeout", "0"},   {"--respawn-delay", "1000ms"},
         {"--respawn-limit", "0"},  {"--dont-skip-unavailable", "skip"},
-        {"--reset-skipped", "off"}};
+        {"--reset-skipped", "off"}, {"--min-interval", "interval"},
+        {"--max-interval", "10x interval"}};
 
     std::map<std::string, std::vector<const OptionInfo*>> groups;
     size_t width = 0;
@@ -0,0 +1,138 @@
+#include "host_scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace procutil {
+
+HostScheduler::Host& HostScheduler::host_entry(const std::string& host) {
+    auto [it, inserted] = hosts_.try_emplace(host);
+    if (inserted)
+        it->second.window = std::min(initial_window, max_window_);
+    return it->second;
+}
+
+void HostScheduler::begin_scan(size_t max_window, clock::time_point horizon) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    max_window_ = static_cast<double>(std::max<size_t>(1, max_window));
+    horizon_ = horizon;
+    for (auto& [name, h] : hosts_) {
+        h.queue.clear();
+        h.in_flight = 0;
+        h.window = std::min(h.window, max_window_);
+    }
+    order_.clear();
+    cursor_ = 0;
+    queued_ = 0;
+    in_flight_ = 0;
+    parked_ = {};
+}
+
+void HostScheduler::enqueue(const std::string& host, size_t index) {
+    Host& h = host_entry(host);
+    if (h.queue.empty() && std::find(order_.begin(), order_.end(), host) == order_.end())
+        order_.push_back(host);
+    h.queue.push_back(index);
+    ++queued_;
+}
+
+void HostScheduler::add(const std::string& host, size_t index) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    enqueue(host, index);
+}
+
+void HostScheduler::queue_due(clock::time_point now) {
+    while (!parked_.empty() && parked_.top().not_before <= now) {
+        enqueue(parked_.top().host, parked_.top().index);
+        parked_.pop();
+    }
+}
+
+bool HostScheduler::next(size_t& index, std::string& host, const std::atomic<bool>& running) {
+    std::unique_lock<std::mutex> lk(mtx_);
+    while (running) {
+        queue_due(clock::now());
+        if (queued_ == 0 && in_flight_ == 0 &&
+            (parked_.empty() || parked_.top().not_before > horizon_))
+            return false;
+        for (size_t i = 0; i < order_.size() && queued_ > 0; ++i) {
+            size_t pos = (cursor_ + i) % order_.size();
+            Host& h = hosts_[order_[pos]];
+            if (h.queue.empty() || static_cast<double>(h.in_flight) + 1.0 > h.window)
+                continue;
+            index = h.queue.front();
+            h.queue.pop_front();
+            ++h.in_flight;
+            ++in_flight_;
+            --queued_;
+            host = order_[pos];
+            cursor_ = pos + 1; // next pick starts with the following host
+            return true;
+        }
+        // Every host with work is at its window, or the remaining jobs are
+        // parked or in flight; wait for a slot or the next parked job. The
+        // timeout re-checks the running flag during shutdown.
+        auto wake = clock::now() + std::chrono::milliseconds(100);
+        if (!parked_.empty())
+            wake = std::min(wake, parked_.top().not_before);
+        cv_.wait_until(lk, wake);
+    }
+    return false;
+}
+
+void HostScheduler::release(Host& h, Outcome outcome) {
+    if (h.in_flight > 0) {
+        --h.in_flight;
+        --in_flight_;
+    }
+    switch (outcome) {
+    case Outcome::Success:
+        h.window = std::min(max_window_, h.window + 1.0 / h.window);
+        break;
+    case Outcome::Congested:
+        h.window = std::max(1.0, h.window / 2.0);
+        break;
+    case Outcome::Neutral:
+        break;
+    }
+}
+
+void HostScheduler::finish(const std::string& host, Outcome outcome) {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        release(host_entry(host), outcome);
+    }
+    cv_.notify_all();
+}
+
+void HostScheduler::park(const std::string& host, size_t index, clock::time_point not_before) {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        parked_.push(Parked{not_before, host, index});
+    }
+    cv_.notify_all();
+}
+
+void HostScheduler::retry(const std::string& host, size_t index, Outcome outcome,
+                          clock::time_point not_before) {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        // Parked in the same step the slot is released, so no worker sees
+        // the scan as finished in between
+        release(host_entry(host), outcome);
+        parked_.push(Parked{not_before, host, index});
+    }
+    cv_.notify_all();
+}
+
+size_t HostScheduler::parked() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return parked_.size();
+}
+
+double HostScheduler::window(const std::string& host) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return host_entry(host).window;
+}
+
+} // namespace procutil
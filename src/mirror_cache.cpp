@@ -0,0 +1,179 @@
+#include "mirror_cache.hpp"
+
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+namespace git {
+
+/**
+ * @brief Copy the last libgit2 error message into @a error.
+ */
+static void last_error(std::string* error) {
+    if (!error)
+        return;
+    const git_error* e = git_error_last();
+    *error = e && e->message ? e->message : "Unknown libgit2 error";
+}
+
+MirrorCache::MirrorCache(std::filesystem::path root, bool alternates)
+    : root_(std::move(root)), alternates_(alternates) {}
+
+void MirrorCache::begin_cycle() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    ++cycle_;
+}
+
+std::filesystem::path MirrorCache::path_for(const std::string& url) const {
+    // FNV-1a keeps directory names stable across builds and platforms
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : url) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    std::string repo = url;
+    while (!repo.empty() && (repo.back() == '/' || repo.back() == '\\'))
+        repo.pop_back();
+    repo = repo.substr(repo.find_last_of("/:\\") + 1);
+    if (repo.size() > 4 && repo.compare(repo.size() - 4, 4, ".git") == 0)
+        repo.resize(repo.size() - 4);
+    std::string name = url_host(url) + "_" + repo;
+    for (char& c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '.' && c != '_')
+            c = '_';
+    }
+    static const char* hex = "0123456789abcdef";
+    name += '-';
+    for (int shift = 60; shift >= 0; shift -= 4)
+        name += hex[(hash >> shift) & 0xf];
+    return root_ / (name + ".git");
+}
+
+/**
+ * @brief Create the bare mirror at @a path, or point its origin at @a url.
+ */
+bool MirrorCache::ensure_mirror(const std::filesystem::path& path, const std::string& url,
+                                std::string* error) {
+    git_repository* raw = nullptr;
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) {
+        if (git_repository_open_bare(&raw, path.string().c_str()) != 0) {
+            last_error(error);
+            return false;
+        }
+    } else {
+        std::filesystem::create_directories(root_, ec);
+        if (git_repository_init(&raw, path.string().c_str(), 1) != 0) {
+            last_error(error);
+            return false;
+        }
+    }
+    repo_ptr repo(raw);
+    git_remote* remote = nullptr;
+    if (git_remote_lookup(&remote, repo.get(), "origin") == 0) {
+        remote_ptr existing(remote);
+        const char* current = git_remote_url(existing.get());
+        if (current && url == current)
+            return true;
+        if (git_remote_set_url(repo.get(), "origin", url.c_str()) != 0) {
+            last_error(error);
+            return false;
+        }
+        return true;
+    }
+    if (git_remote_create(&remote, repo.get(), "origin", url.c_str()) != 0) {
+        last_error(error);
+        return false;
+    }
+    remote_ptr created(remote);
+    return true;
+}
+
+FetchResult MirrorCache::refresh(const std::string& url, const FetchParams& params) {
+    std::shared_ptr<Entry> entry;
+    unsigned cycle = 0;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto& slot = entries_[url];
+        if (!slot)
+            slot = std::make_shared<Entry>();
+        entry = slot;
+        cycle = cycle_;
+    }
+    std::lock_guard<std::mutex> lk(entry->mtx); // callers for one URL queue here
+    if (entry->cycle == cycle)
+        return entry->result;
+
+    FetchResult result;
+    std::filesystem::path path = path_for(url);
+    if (!ensure_mirror(path, url, &result.error)) {
+        result.remote = "origin";
+        result.kind = FetchError::Other;
+        entry->result = result;
+        entry->cycle = cycle;
+        return result;
+    }
+    // A mirror keeps every branch and tag at full depth
+    FetchParams mirror_params = params;
+    mirror_params.mirror = nullptr;
+    mirror_params.refspecs = {"+refs/heads/*:refs/heads/*"};
+    mirror_params.tags = TagPolicy::All;
+    mirror_params.single_branch = false;
+    mirror_params.prune = true;
+    mirror_params.depth = 0;
+    mirror_params.ls_remote_probe = false;
+    {
+        RepoSession session(path);
+        result = session.fetch("origin", "", mirror_params);
+    }
+    if (result.kind != FetchError::Timeout && result.kind != FetchError::Cancelled) {
+        entry->result = result;
+        entry->cycle = cycle;
+    }
+    return result;
+}
+
+bool MirrorCache::link_alternate(git_repository* repo, const std::string& url,
+                                 std::string* error) {
+    std::filesystem::path mirror_objects = path_for(url) / "objects";
+    std::filesystem::path info =
+        std::filesystem::path(git_repository_commondir(repo)) / "objects" / "info";
+    std::filesystem::path file = info / "alternates";
+    std::string wanted = mirror_objects.generic_string();
+    std::string listed;
+    {
+        std::ifstream in(file);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line == wanted)
+                return true;
+            listed += line + '\n';
+        }
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(info, ec);
+    {
+        std::ofstream out(file, std::ios::trunc);
+        if (!(out << listed << wanted << '\n')) {
+            if (error)
+                *error = "Cannot write " + file.string();
+            return false;
+        }
+    }
+    // The repository is already open; make the new store visible to it now
+    git_odb* raw = nullptr;
+    if (git_repository_odb(&raw, repo) != 0) {
+        last_error(error);
+        return false;
+    }
+    odb_ptr odb(raw);
+    if (git_odb_add_disk_alternate(odb.get(), wanted.c_str()) != 0) {
+        last_error(error);
+        return false;
+    }
+    return true;
+}
+
+} // namespace git
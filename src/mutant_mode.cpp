@@ -74,10 +74,21 @@ void apply_mutant_mode(Options& opts) {
 
 bool mutant_should_pull(const fs::path& repo, RepoInfo& ri, const std::string& remote,
                         bool include_private, std::chrono::seconds updated_since) {
-    std::time_t ct =
-        git::get_remote_commit_time(repo, remote, ri.branch, include_private, &ri.auth_failed);
+    git::RepoSession session(repo);
+    git::FetchParams params;
+    params.use_credentials = include_private;
+    return mutant_should_pull(session, ri, remote, params, updated_since);
+}
+
+bool mutant_should_pull(git::RepoSession& session, RepoInfo& ri, const std::string& remote,
+                        const git::FetchParams& params, std::chrono::seconds updated_since) {
+    const fs::path& repo = session.path();
+    const git::FetchResult& fetched = session.fetch(remote, ri.branch, params);
+    if (fetched.auth_failed)
+        ri.auth_failed = true;
+    std::time_t ct = fetched.ok ? fetched.remote_commit_time : 0;
     if (ct == 0)
-        ct = git::get_last_commit_time(repo);
+        ct = session.last_commit_time();
     std::time_t now = std::time(nullptr);
     if (updated_since.count() > 0 && (ct == 0 || now - ct > updated_since.count())) {
         ri.status = RS_SKIPPED;
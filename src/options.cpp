@@ -35,6 +35,9 @@ Options parse_options(int argc, char* argv[]) {
                                       "--remote",
                                       "--pull-ref",
                                       "--interval",
+                                      "--adaptive-interval",
+                                      "--min-interval",
+                                      "--max-interval",
                                       "--refresh-rate",
                                       "--cpu-poll",
                                       "--mem-poll",
@@ -47,8 +50,30 @@ Options parse_options(int argc, char* argv[]) {
                                       "--proxy",
                                       "--max-log-size",
                                       "--concurrency",
+                                      "--fetch-concurrency",
+                                      "--checkout-concurrency",
+                                      "--hook-concurrency",
                                       "--check-only",
                                       "--no-hash-check",
+                                      "--ls-remote",
+                                      "--fetch-tags",
+                                      "--single-branch",
+                                      "--prune",
+                                      "--fetch-depth",
+                                      "--pack-maintenance",
+                                      "--max-packs",
+                                      "--max-loose-objects",
+                                      "--mirror-cache",
+                                      "--mirror-alternates",
+                                      "--git-profile",
+                                      "--git-cache-size",
+                                      "--git-mmap-window",
+                                      "--git-mmap-limit",
+                                      "--git-open-packs",
+                                      "--no-strict-objects",
+                                      "--no-hash-verify",
+                                      "--git-fsync",
+                                      "--status-cache",
                                       "--dry-run",
                                       "--log-level",
                                       "--verbose",
@@ -68,6 +93,7 @@ Options parse_options(int argc, char* argv[]) {
                                       "--disk-limit",
                                       "--cpu-limit",
                                       "--total-traffic-limit",
+                                      "--cycle-traffic-limit",
                                       "--max-depth",
                                       "--cli",
                                       "--single-run",
@@ -78,6 +104,7 @@ Options parse_options(int argc, char* argv[]) {
                                       "--config-json",
                                       "--ignore",
                                       "--include-dir",
+                                      "--manifest",
                                       "--force-pull",
                                       "--exclude",
                                       "--discard-dirty",
@@ -248,6 +275,8 @@ Options parse_options(int argc, char* argv[]) {
     bool ok2 = false; // secondary parse success flag for sub-parses
     opts.cli = parser.has_flag("--cli") || cfg_flag("--cli");
     opts.single_run = parser.has_flag("--single-run") || cfg_flag("--single-run");
+    opts.adaptive_interval =
+        parser.has_flag("--adaptive-interval") || cfg_flag("--adaptive-interval");
     opts.single_repo = parser.has_flag("--single-repo") || cfg_flag("--single-repo");
     if (opts.single_run)
         opts.cli = true;
@@ -377,7 +406,11 @@ Options parse_options(int argc, char* argv[]) {
     opts.ignore_lock = parser.has_flag("--ignore-lock") || cfg_flag("--ignore-lock");
     opts.check_only = parser.has_flag("--check-only") || cfg_flag("--check-only");
     opts.hash_check = !(parser.has_flag("--no-hash-check") || cfg_flag("--no-hash-check"));
+    opts.ls_remote = parser.has_flag("--ls-remote") || cfg_flag("--ls-remote");
+    parse_fetch_options(opts, parser, cfg_flag, cfg_opt, cfg_opts);
+    parse_libgit2_options(opts, parser, cfg_flag, cfg_opt, cfg_opts);
     opts.dry_run = parser.has_flag("--dry-run") || cfg_flag("--dry-run");
+    opts.status_cache = parser.has_flag("--status-cache") || cfg_flag("--status-cache");
     opts.force_pull = parser.has_flag("--force-pull") || parser.has_flag("--discard-dirty") ||
                       cfg_flag("--force-pull") || cfg_flag("--discard-dirty");
     if (parser.has_flag("--verbose") || cfg_flag("--verbose"))
@@ -0,0 +1,82 @@
+// options_fetch.cpp
+//
+// Fetch policy parsing: which refs and tags a fetch negotiates, how deep
+// the history is kept, whether stale remote-tracking refs are pruned, when
+// the packs fetches leave behind are consolidated and whether fetches go
+// through a shared mirror cache.
+
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+#include "arg_parser.hpp"
+#include "options.hpp"
+#include "parse_utils.hpp"
+
+/**
+ * Parse fetch policy flags from CLI and config.
+ *
+ * CLI values of --fetch-tags, --fetch-depth and the pack maintenance
+ * thresholds take precedence over the config file. Throws
+ * std::runtime_error on invalid values.
+ */
+void parse_fetch_options(Options& opts, ArgParser& parser,
+                         const std::function<bool(const std::string&)>& cfg_flag,
+                         const std::function<std::string(const std::string&)>& cfg_opt,
+                         const std::map<std::string, std::string>& cfg_opts) {
+    bool ok = false;
+    if (parser.has_flag("--fetch-tags") || cfg_opts.count("--fetch-tags")) {
+        std::string val = parser.get_option("--fetch-tags");
+        if (val.empty())
+            val = cfg_opt("--fetch-tags");
+        opts.fetch_tags = parse_tag_policy(val, ok);
+        if (!ok)
+            throw std::runtime_error("Invalid value for --fetch-tags");
+    }
+    opts.single_branch = parser.has_flag("--single-branch") || cfg_flag("--single-branch");
+    opts.prune = parser.has_flag("--prune") || cfg_flag("--prune");
+    if (cfg_opts.count("--fetch-depth")) {
+        opts.fetch_depth = parse_uint(cfg_opt("--fetch-depth"), 0, INT_MAX, ok);
+        if (!ok)
+            throw std::runtime_error("Invalid value for --fetch-depth");
+    }
+    if (parser.has_flag("--fetch-depth")) {
+        opts.fetch_depth = parse_uint(parser, "--fetch-depth", 0, INT_MAX, ok);
+        if (!ok)
+            throw std::runtime_error("Invalid value for --fetch-depth");
+    }
+    opts.pack_maintenance =
+        parser.has_flag("--pack-maintenance") || cfg_flag("--pack-maintenance");
+    if (cfg_opts.count("--max-packs")) {
+        opts.max_packs = parse_size_t(cfg_opt("--max-packs"), 0, SIZE_MAX, ok);
+        if (!ok)
+            throw std::runtime_error("Invalid value for --max-packs");
+    }
+    if (parser.has_flag("--max-packs")) {
+        opts.max_packs = parse_size_t(parser, "--max-packs", 0, SIZE_MAX, ok);
+        if (!ok)
+            throw std::runtime_error("Invalid value for --max-packs");
+    }
+    if (cfg_opts.count("--max-loose-objects")) {
+        opts.max_loose_objects = parse_size_t(cfg_opt("--max-loose-objects"), 0, SIZE_MAX, ok);
+        if (!ok)
+            throw std::runtime_error("Invalid value for --max-loose-objects");
+    }
+    if (parser.has_flag("--max-loose-objects")) {
+        opts.max_loose_objects = parse_size_t(parser, "--max-loose-objects", 0, SIZE_MAX, ok);
+        if (!ok)
+            throw std::runtime_error("Invalid value for --max-loose-objects");
+    }
+    if (parser.has_flag("--mirror-cache") || cfg_opts.count("--mirror-cache")) {
+        std::string val = parser.get_option("--mirror-cache");
+        if (val.empty())
+            val = cfg_opt("--mirror-cache");
+        if (val.empty())
+            throw std::runtime_error("--mirror-cache requires a path");
+        opts.mirror_cache = val;
+    }
+    opts.mirror_alternates =
+        parser.has_flag("--mirror-alternates") || cfg_flag("--mirror-alternates");
+}
@@ -0,0 +1,101 @@
+// options_libgit2.cpp
+//
+// libgit2 tuning parsing: object cache, pack mmap windows, strict object
+// checks and fsync, as a named profile plus per-setting overrides.
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+#include "arg_parser.hpp"
+#include "options.hpp"
+#include "parse_utils.hpp"
+
+/**
+ * Fill @a git with the preset of @a profile.
+ *
+ * `lean` bounds what each process keeps mapped and cached, for hosts with
+ * many repositories and little memory. `fast` grows the object cache and
+ * skips re-validating objects. Returns false for unknown names.
+ */
+static bool apply_profile(const std::string& profile, Libgit2Options& git) {
+    constexpr size_t MiB = 1024ull * 1024ull;
+    git = Libgit2Options{};
+    git.profile = profile;
+    if (profile == "default")
+        return true;
+    if (profile == "lean") {
+        git.cache_size = 32 * MiB;
+        git.mmap_window = 32 * MiB;
+        git.mmap_limit = 256 * MiB;
+        git.open_packs = 128;
+        return true;
+    }
+    if (profile == "fast") {
+        git.cache_size = 512 * MiB;
+        git.strict_object_creation = false;
+        git.strict_hash_verification = false;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Parse libgit2 tuning flags from CLI and config.
+ *
+ * The profile is applied first; CLI values of the individual settings take
+ * precedence over config values, which take precedence over the profile.
+ * Throws std::runtime_error on invalid values.
+ */
+void parse_libgit2_options(Options& opts, ArgParser& parser,
+                           const std::function<bool(const std::string&)>& cfg_flag,
+                           const std::function<std::string(const std::string&)>& cfg_opt,
+                           const std::map<std::string, std::string>& cfg_opts) {
+    bool ok = false;
+    std::string profile = "default";
+    if (cfg_opts.count("--git-profile"))
+        profile = cfg_opt("--git-profile");
+    if (parser.has_flag("--git-profile"))
+        profile = parser.get_option("--git-profile");
+    if (!apply_profile(profile, opts.libgit2))
+        throw std::runtime_error("Invalid value for --git-profile");
+
+    struct ByteSetting {
+        const char* flag;
+        std::optional<size_t> Libgit2Options::*member;
+    };
+    const ByteSetting sizes[] = {
+        {"--git-cache-size", &Libgit2Options::cache_size},
+        {"--git-mmap-window", &Libgit2Options::mmap_window},
+        {"--git-mmap-limit", &Libgit2Options::mmap_limit},
+    };
+    for (const auto& s : sizes) {
+        if (cfg_opts.count(s.flag)) {
+            opts.libgit2.*(s.member) = parse_bytes(cfg_opt(s.flag), 0, SIZE_MAX, ok);
+            if (!ok)
+                throw std::runtime_error(std::string("Invalid value for ") + s.flag);
+        }
+        if (parser.has_flag(s.flag)) {
+            opts.libgit2.*(s.member) = parse_bytes(parser.get_option(s.flag), 0, SIZE_MAX, ok);
+            if (!ok)
+                throw std::runtime_error(std::string("Invalid value for ") + s.flag);
+        }
+    }
+    if (cfg_opts.count("--git-open-packs")) {
+        opts.libgit2.open_packs = parse_size_t(cfg_opt("--git-open-packs"), 0, SIZE_MAX, ok);
+        if (!ok)
+            throw std::runtime_error("Invalid value for --git-open-packs");
+    }
+    if (parser.has_flag("--git-open-packs")) {
+        opts.libgit2.open_packs = parse_size_t(parser, "--git-open-packs", 0, SIZE_MAX, ok);
+        if (!ok)
+            throw std::runtime_error("Invalid value for --git-open-packs");
+    }
+    if (parser.has_flag("--no-strict-objects") || cfg_flag("--no-strict-objects"))
+        opts.libgit2.strict_object_creation = false;
+    if (parser.has_flag("--no-hash-verify") || cfg_flag("--no-hash-verify"))
+        opts.libgit2.strict_hash_verification = false;
+    if (parser.has_flag("--git-fsync") || cfg_flag("--git-fsync"))
+        opts.libgit2.fsync_gitdir = true;
+}
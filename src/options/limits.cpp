@@ -14,8 +14,9 @@
 /**
  * Parse resource limit flags from CLI and config, writing to opts.limits.
  *
- * Handles CPU percent/cores, memory/download/upload/disk/traffic caps, and
- * max-depth. Throws std::runtime_error on invalid values.
+ * Handles CPU percent/cores, memory/download/upload/disk/traffic caps, the
+ * scan stage worker counts and max-depth. Throws std::runtime_error on
+ * invalid values.
  */
 void parse_limits(Options& opts, ArgParser& parser,
                   const std::function<std::string(const std::string&)>& cfg_opt,
@@ -59,6 +60,7 @@ void parse_limits(Options& opts, ArgParser& parser,
         {"--upload-limit", &ResourceLimits::upload_limit, 1024ull},
         {"--disk-limit", &ResourceLimits::disk_limit, 1024ull},
         {"--total-traffic-limit", &ResourceLimits::total_traffic_limit, 1},
+        {"--cycle-traffic-limit", &ResourceLimits::cycle_traffic_limit, 1},
     };
     for (const auto& lim : limits) {
         if (cfg_opts.count(lim.flag)) {
@@ -74,6 +76,27 @@ void parse_limits(Options& opts, ArgParser& parser,
             opts.limits.*(lim.member) = bytes / lim.divisor;
         }
     }
+    struct StageLimit {
+        const char* flag;
+        size_t ResourceLimits::*member;
+    };
+    const StageLimit stages[] = {
+        {"--fetch-concurrency", &ResourceLimits::fetch_concurrency},
+        {"--checkout-concurrency", &ResourceLimits::checkout_concurrency},
+        {"--hook-concurrency", &ResourceLimits::hook_concurrency},
+    };
+    for (const auto& stage : stages) {
+        if (cfg_opts.count(stage.flag)) {
+            opts.limits.*(stage.member) = parse_size_t(cfg_opt(stage.flag), 0, SIZE_MAX, ok);
+            if (!ok)
+                throw std::runtime_error(std::string("Invalid value for ") + stage.flag);
+        }
+        if (parser.has_flag(stage.flag)) {
+            opts.limits.*(stage.member) = parse_size_t(parser, stage.flag, 0, SIZE_MAX, ok);
+            if (!ok)
+                throw std::runtime_error(std::string("Invalid value for ") + stage.flag);
+        }
+    }
     if (cfg_opts.count("--max-depth")) {
         opts.max_depth = parse_size_t(cfg_opt("--max-depth"), 0, SIZE_MAX, ok);
         if (!ok)
@@ -1,6 +1,7 @@
 // options_repo_args.cpp
 //
-// Parse root path, remote/pull-ref, and include/ignore lists.
+// Parse root path, remote/pull-ref, include/ignore lists and the clone
+// manifest.
 
 #include <filesystem>
 #include <map>
@@ -44,4 +45,12 @@ void parse_root_and_repo_filters(Options& opts, ArgParser& parser,
         opts.include_dirs.push_back(val);
     for (const auto& val : parser.get_all_options("--ignore"))
         opts.ignore_dirs.push_back(val);
+    if (parser.has_flag("--manifest") || cfg_opts.count("--manifest")) {
+        std::string val = parser.get_option("--manifest");
+        if (val.empty())
+            val = cfg_opt("--manifest");
+        if (val.empty())
+            throw std::runtime_error("--manifest requires a file");
+        opts.manifest = val;
+    }
 }
@@ -86,6 +86,22 @@ void parse_repo_settings(Options& opts,
                 throw std::runtime_error("Invalid per-repo pull-ref");
             ro.pull_ref = val;
         }
+        if (values.count("--fetch-tags")) {
+            TagPolicy policy = parse_tag_policy(ropt("--fetch-tags"), ok);
+            if (!ok)
+                throw std::runtime_error("Invalid per-repo fetch-tags");
+            ro.fetch_tags = policy;
+        }
+        if (values.count("--single-branch"))
+            ro.single_branch = rflag("--single-branch");
+        if (values.count("--prune"))
+            ro.prune = rflag("--prune");
+        if (values.count("--fetch-depth")) {
+            unsigned int depth = parse_uint(ropt("--fetch-depth"), 0, INT_MAX, ok);
+            if (!ok)
+                throw std::runtime_error("Invalid per-repo fetch-depth");
+            ro.fetch_depth = depth;
+        }
         opts.repo_settings[fs::path(repo)] = ro;
     }
 }
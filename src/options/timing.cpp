@@ -4,6 +4,7 @@
 
 #include <map>
 #include <string>
+#include <algorithm>
 #include <climits>
 
 #include "options.hpp"
@@ -26,6 +27,40 @@ void parse_timing_options(Options& opts, ArgParser& parser,
             throw std::runtime_error("Invalid value for --interval");
         opts.interval = static_cast<int>(dur.count());
     }
+    if (cfg_opts.count("--min-interval")) {
+        auto dur = parse_duration(cfg_opt("--min-interval"), ok);
+        if (!ok || dur.count() < 1 || dur.count() > INT_MAX)
+            throw std::runtime_error("Invalid value for --min-interval");
+        opts.min_interval = dur;
+    }
+    if (parser.has_flag("--min-interval")) {
+        auto dur = parse_duration(parser, "--min-interval", ok);
+        if (!ok || dur.count() < 1 || dur.count() > INT_MAX)
+            throw std::runtime_error("Invalid value for --min-interval");
+        opts.min_interval = dur;
+    }
+    if (cfg_opts.count("--max-interval")) {
+        auto dur = parse_duration(cfg_opt("--max-interval"), ok);
+        if (!ok || dur.count() < 1 || dur.count() > INT_MAX)
+            throw std::runtime_error("Invalid value for --max-interval");
+        opts.max_interval = dur;
+    }
+    if (parser.has_flag("--max-interval")) {
+        auto dur = parse_duration(parser, "--max-interval", ok);
+        if (!ok || dur.count() < 1 || dur.count() > INT_MAX)
+            throw std::runtime_error("Invalid value for --max-interval");
+        opts.max_interval = dur;
+    }
+    // Unset bounds of --adaptive-interval follow --interval
+    std::chrono::seconds interval(opts.interval);
+    if (opts.min_interval.count() == 0)
+        opts.min_interval = opts.max_interval.count() > 0
+                                ? std::min(interval, opts.max_interval)
+                                : interval;
+    if (opts.max_interval.count() == 0)
+        opts.max_interval = std::max(opts.min_interval, 10 * interval);
+    if (opts.max_interval < opts.min_interval)
+        throw std::runtime_error("--max-interval must not be below --min-interval");
     if (cfg_opts.count("--refresh-rate")) {
         opts.refresh_ms = parse_time_ms(cfg_opt("--refresh-rate"), ok);
         if (!ok || opts.refresh_ms.count() < 1)
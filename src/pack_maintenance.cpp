@@ -0,0 +1,149 @@
+#include "pack_maintenance.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "git_utils.hpp"
+
+// Writing a multi-pack-index arrived in libgit2 1.2
+#if LIBGIT2_VER_MAJOR > 1 || (LIBGIT2_VER_MAJOR == 1 && LIBGIT2_VER_MINOR >= 2)
+#define AUTOGITPULL_MIDX 1
+#endif
+
+namespace git {
+
+/**
+ * @brief Copy the last libgit2 error message into @a error.
+ */
+static void last_error(std::string* error) {
+    if (!error)
+        return;
+    const git_error* e = git_error_last();
+    *error = e && e->message ? e->message : "Unknown libgit2 error";
+}
+
+/**
+ * @brief Count packs and estimate loose objects in the object store.
+ *
+ * Loose objects are estimated the way `git gc --auto` does it: the entries
+ * of one fan-out directory times 256. Packs written after the
+ * multi-pack-index are counted as unindexed.
+ */
+PackStats RepoSession::pack_stats() {
+    PackStats stats;
+    git_repository* r = repo();
+    if (!r)
+        return stats;
+    fs::path objects = fs::path(git_repository_commondir(r)) / "objects";
+    std::error_code midx_ec;
+    auto midx_time = fs::last_write_time(objects / "pack" / "multi-pack-index", midx_ec);
+    std::error_code ec;
+    for (fs::directory_iterator it(objects / "pack", ec), end; !ec && it != end;
+         it.increment(ec)) {
+        if (it->path().extension() != ".pack")
+            continue;
+        ++stats.packs;
+        std::error_code tec;
+        if (midx_ec || fs::last_write_time(it->path(), tec) > midx_time)
+            ++stats.unindexed_packs;
+    }
+    size_t sample = 0;
+    std::error_code lec;
+    for (fs::directory_iterator it(objects / "17", lec), end; !lec && it != end;
+         it.increment(lec))
+        ++sample;
+    stats.loose_objects = sample * 256;
+    return stats;
+}
+
+/**
+ * @brief Write every loose object of @a r into a single new pack.
+ *
+ * The loose files are removed only after the pack and its index are in
+ * place, so each object stays readable throughout.
+ */
+static bool pack_loose_objects(git_repository* r, const fs::path& objects, std::string* error) {
+    git_packbuilder* raw = nullptr;
+    if (git_packbuilder_new(&raw, r) != 0) {
+        last_error(error);
+        return false;
+    }
+    packbuilder_ptr pb(raw);
+    git_packbuilder_set_threads(pb.get(), 1); // stay in the background
+    auto is_hex = [](const std::string& s) {
+        return std::all_of(s.begin(), s.end(), [](unsigned char c) { return std::isxdigit(c); });
+    };
+    std::vector<fs::path> loose;
+    std::error_code ec;
+    for (fs::directory_iterator dir(objects, ec), end; !ec && dir != end; dir.increment(ec)) {
+        std::string fan = dir->path().filename().string();
+        std::error_code fec;
+        if (fan.size() != 2 || !is_hex(fan) || !dir->is_directory(fec))
+            continue;
+        for (fs::directory_iterator f(dir->path(), fec); !fec && f != end; f.increment(fec)) {
+            std::string rest = f->path().filename().string();
+            git_oid oid;
+            if (rest.size() != GIT_OID_HEXSZ - 2 || !is_hex(rest) ||
+                git_oid_fromstr(&oid, (fan + rest).c_str()) != 0)
+                continue;
+            if (git_packbuilder_insert(pb.get(), &oid, nullptr) != 0) {
+                last_error(error);
+                return false;
+            }
+            loose.push_back(f->path());
+        }
+    }
+    if (loose.empty())
+        return true;
+    if (git_packbuilder_write(pb.get(), nullptr, 0, nullptr, nullptr) != 0) {
+        last_error(error);
+        return false;
+    }
+    for (const auto& f : loose) {
+        std::error_code rec;
+        fs::remove(f, rec);
+    }
+    return true;
+}
+
+bool RepoSession::maintain_packs(const PackMaintenance& policy, PackStats& stats,
+                                 std::string* error) {
+    git_repository* r = repo();
+    if (!r) {
+        if (error)
+            *error = open_error_;
+        return false;
+    }
+    bool changed = false;
+    if (policy.max_loose > 0 && stats.loose_objects > policy.max_loose) {
+        fs::path objects = fs::path(git_repository_commondir(r)) / "objects";
+        if (!pack_loose_objects(r, objects, error))
+            return false;
+        changed = true;
+        stats = pack_stats();
+    }
+#ifdef AUTOGITPULL_MIDX
+    if (policy.max_packs > 0 && stats.unindexed_packs > policy.max_packs) {
+        git_odb* raw = nullptr;
+        if (git_repository_odb(&raw, r) != 0) {
+            last_error(error);
+            return false;
+        }
+        odb_ptr odb(raw);
+        // Pick up the pack written above before indexing
+        if (git_odb_refresh(odb.get()) != 0 || git_odb_write_multi_pack_index(odb.get()) != 0) {
+            last_error(error);
+            return false;
+        }
+        changed = true;
+        stats = pack_stats();
+    }
+#endif
+    return changed;
+}
+
+} // namespace git
@@ -280,3 +280,18 @@ size_t parse_bytes(const ArgParser& parser, const std::string& flag, bool& ok) {
     }
     return parse_bytes(parser.get_option(flag), 0, SIZE_MAX, ok);
 }
+
+TagPolicy parse_tag_policy(const std::string& value, bool& ok) {
+    std::string v;
+    for (char c : value)
+        v += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    ok = true;
+    if (v == "none")
+        return TagPolicy::None;
+    if (v == "auto")
+        return TagPolicy::Auto;
+    if (v == "all")
+        return TagPolicy::All;
+    ok = false;
+    return TagPolicy::All;
+}
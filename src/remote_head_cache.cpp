@@ -0,0 +1,49 @@
+#include "remote_head_cache.hpp"
+
+namespace git {
+
+void RemoteHeadCache::begin_cycle() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    members_.clear();
+    entries_.clear();
+}
+
+void RemoteHeadCache::add(const std::string& url) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    ++members_[normalize_remote_url(url)];
+}
+
+bool RemoteHeadCache::shared(const std::string& url) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto it = members_.find(normalize_remote_url(url));
+    return it != members_.end() && it->second > 1;
+}
+
+std::shared_ptr<const RemoteHeads> RemoteHeadCache::get(RepoSession& session,
+                                                        const std::string& remote,
+                                                        const FetchParams& params) {
+    std::string url = session.remote_url(remote).value_or("");
+    if (url.empty())
+        return std::make_shared<const RemoteHeads>(session.list_remote(remote, params));
+    std::string key = (params.use_credentials ? "+" : "-") + normalize_remote_url(url);
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto& slot = entries_[key];
+        if (!slot)
+            slot = std::make_shared<Entry>();
+        entry = slot;
+    }
+    std::lock_guard<std::mutex> lk(entry->mtx); // other clones of the URL queue here
+    if (!entry->heads)
+        entry->heads =
+            std::make_shared<const RemoteHeads>(session.list_remote(remote, params));
+    return entry->heads;
+}
+
+size_t RemoteHeadCache::size() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return entries_.size();
+}
+
+} // namespace git
@@ -0,0 +1,133 @@
+#include "repo_state.hpp"
+
+#include <limits>
+
+namespace fs = std::filesystem;
+
+bool RepoSlot::claim() {
+    if (claimed_.exchange(true, std::memory_order_acq_rel))
+        return false;
+    progress_.store(0, std::memory_order_relaxed);
+    set_status(RS_CHECKING, "");
+    return true;
+}
+
+void RepoSlot::set_status(RepoStatus status, const std::string& message) {
+    std::lock_guard<std::mutex> lk(message_mtx_);
+    status_.store(status, std::memory_order_relaxed);
+    message_ = message;
+}
+
+void RepoSlot::set_message(const std::string& message) {
+    std::lock_guard<std::mutex> lk(message_mtx_);
+    message_ = message;
+}
+
+bool RepoSlot::overlay(RepoInfo& info) const {
+    if (!claimed())
+        return false;
+    {
+        std::lock_guard<std::mutex> lk(message_mtx_);
+        info.status = static_cast<RepoStatus>(status_.load(std::memory_order_relaxed));
+        info.message = message_;
+    }
+    info.progress = progress_.load(std::memory_order_relaxed);
+    return true;
+}
+
+size_t RepoStateTable::id(const fs::path& path) {
+    {
+        std::shared_lock<std::shared_mutex> lk(mtx_);
+        auto it = index_.find(path);
+        if (it != index_.end())
+            return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lk(mtx_);
+    auto [it, added] = index_.emplace(path, slots_.size());
+    if (added) {
+        slots_.emplace_back();
+        paths_.push_back(path);
+    }
+    return it->second;
+}
+
+RepoSlot& RepoStateTable::at(size_t id) {
+    std::shared_lock<std::shared_mutex> lk(mtx_);
+    return slots_[id];
+}
+
+RepoSlot& RepoStateTable::slot(const fs::path& path) { return at(id(path)); }
+
+RepoSlot* RepoStateTable::find(const fs::path& path) const {
+    std::shared_lock<std::shared_mutex> lk(mtx_);
+    auto it = index_.find(path);
+    if (it == index_.end())
+        return nullptr;
+    // Slots are only appended, so the pointer outlives the lock
+    return const_cast<RepoSlot*>(&slots_[it->second]);
+}
+
+RepoClaim RepoStateTable::claim(const fs::path& path) {
+    RepoSlot& s = slot(path);
+    if (!s.claim())
+        return RepoClaim();
+    return RepoClaim(&s);
+}
+
+void RepoStateTable::overlay(std::map<fs::path, RepoInfo>& infos) const {
+    std::shared_lock<std::shared_mutex> lk(mtx_);
+    for (const auto& [path, idx] : index_) {
+        const RepoSlot& s = slots_[idx];
+        if (!s.claimed())
+            continue;
+        auto it = infos.find(path);
+        if (it != infos.end())
+            s.overlay(it->second);
+    }
+}
+
+size_t RepoStateTable::size() const {
+    std::shared_lock<std::shared_mutex> lk(mtx_);
+    return slots_.size();
+}
+
+void RepoView::refresh(const RepoStateTable& states, const std::map<fs::path, RepoInfo>& infos,
+                       std::mutex& mtx) {
+    // Generations and the epoch are read before the map, so a write that
+    // lands during the copy is copied again next time
+    uint64_t epoch = states.epoch();
+    bool full = !synced_ || epoch != epoch_;
+    epoch_ = epoch;
+    synced_ = true;
+    changed_.clear();
+    states.for_each([&](size_t id, const fs::path& path, const RepoSlot& slot) {
+        if (id == seen_.size())
+            seen_.push_back(std::numeric_limits<uint64_t>::max());
+        uint64_t gen = slot.generation();
+        if (full || gen != seen_[id] || slot.claimed()) {
+            seen_[id] = gen;
+            // Slots and their paths never move, so the pointers stay valid
+            changed_.emplace_back(&path, &slot);
+        }
+    });
+    if (full) {
+        std::lock_guard<std::mutex> lk(mtx);
+        view_ = infos;
+    } else if (!changed_.empty()) {
+        std::lock_guard<std::mutex> lk(mtx);
+        for (const auto& [path, slot] : changed_) {
+            auto it = infos.find(*path);
+            if (it != infos.end())
+                view_[*path] = it->second;
+            else
+                view_.erase(*path);
+        }
+    }
+    for (const auto& [path, slot] : changed_) {
+        if (!slot->claimed())
+            continue;
+        auto it = view_.find(*path);
+        if (it != view_.end())
+            slot->overlay(it->second);
+    }
+}
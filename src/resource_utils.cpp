@@ -8,12 +8,16 @@
 #include <filesystem>
 #include <system_error>
 #include <cstdint>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 #ifdef __linux__
 #include <sched.h>
 #include <unistd.h>
 #include <sys/resource.h>
 #elif defined(_WIN32)
 #include <windows.h>
+#include <malloc.h>
 #include <psapi.h>
 #include <tlhelp32.h>
 #include <winternl.h>
@@ -370,30 +374,18 @@ double get_cpu_percent() {
 }
 
 /**
- * @brief Return resident memory usage in megabytes.
- *
- * The value is cached for @c mem_poll_interval to avoid hitting the OS on every
- * call.
+ * @brief Read resident memory usage in kilobytes from the OS.
  */
-std::size_t get_memory_usage_mb() {
-    auto now = std::chrono::steady_clock::now();
-    if (now - prev_mem_time < mem_poll_interval)
-        return last_mem_usage; // Respect polling interval.
-    prev_mem_time = now;
+std::size_t read_memory_usage_kb() {
 #ifdef __linux__
     // Parse VmRSS from /proc/self/status (value reported in kB).
-    std::size_t rss_kb = read_status_value("VmRSS:");
-    if (rss_kb > 0)
-        last_mem_usage = rss_kb / 1024;
-    else
-        last_mem_usage = 0;
+    return read_status_value("VmRSS:");
 #elif defined(_WIN32)
     // Windows: use GetProcessMemoryInfo to get working set size.
     PROCESS_MEMORY_COUNTERS pmc;
     if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
-        last_mem_usage = static_cast<std::size_t>(pmc.WorkingSetSize / (1024 * 1024));
-    else
-        last_mem_usage = 0;
+        return static_cast<std::size_t>(pmc.WorkingSetSize / 1024);
+    return 0;
 #elif defined(__APPLE__)
     // macOS: query Mach task info for resident size.
     mach_msg_type_number_t count = 0;
@@ -408,15 +400,42 @@ std::size_t get_memory_usage_mb() {
 #endif
     if (task_info(mach_task_self(), flavor, reinterpret_cast<task_info_t>(&info), &count) ==
         KERN_SUCCESS)
-        last_mem_usage = static_cast<std::size_t>(info.resident_size / (1024 * 1024));
-    else
-        last_mem_usage = 0;
+        return static_cast<std::size_t>(info.resident_size / 1024);
+    return 0;
 #else
-    last_mem_usage = 0;
+    return 0;
 #endif
+}
+
+/**
+ * @brief Return resident memory usage in megabytes.
+ *
+ * The value is cached for @c mem_poll_interval to avoid hitting the OS on every
+ * call.
+ */
+std::size_t get_memory_usage_mb() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - prev_mem_time < mem_poll_interval)
+        return last_mem_usage; // Respect polling interval.
+    prev_mem_time = now;
+    last_mem_usage = read_memory_usage_kb() / 1024;
     return last_mem_usage;
 }
 
+/**
+ * @brief Hand heap pages freed by the allocator back to the OS.
+ *
+ * glibc keeps freed memory in its arenas, so RSS stays at the peak of the
+ * last scan. Other allocators return memory on their own.
+ */
+void release_free_memory() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#elif defined(_WIN32)
+    _heapmin();
+#endif
+}
+
 /**
  * @brief Return virtual memory usage in kilobytes.
  */
@@ -0,0 +1,48 @@
+#include "retry_backoff.hpp"
+
+#include <algorithm>
+
+namespace procutil {
+
+RetryBackoff::RetryBackoff(std::chrono::seconds base, std::chrono::seconds cap)
+    : base_(base), cap_(cap) {}
+
+RetryBackoff::clock::time_point RetryBackoff::failure(const std::filesystem::path& repo,
+                                                      std::chrono::seconds hint,
+                                                      clock::time_point now) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    Entry& e = entries_[repo];
+    ++e.attempts;
+    auto delay = base_;
+    for (unsigned i = 1; i < e.attempts && delay < cap_; ++i)
+        delay *= 2;
+    delay = std::min(delay, cap_);
+    // Equal jitter: keep half the delay and randomise the other half
+    std::uniform_int_distribution<long long> dist(0, delay.count() / 2);
+    delay = delay - delay / 2 + std::chrono::seconds(dist(rng_));
+    delay = std::max(delay, hint); // the server knows best when it will recover
+    e.not_before = now + delay;
+    return e.not_before;
+}
+
+void RetryBackoff::success(const std::filesystem::path& repo) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    entries_.erase(repo);
+}
+
+std::chrono::seconds RetryBackoff::remaining(const std::filesystem::path& repo,
+                                             clock::time_point now) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto it = entries_.find(repo);
+    if (it == entries_.end() || it->second.not_before <= now)
+        return std::chrono::seconds(0);
+    return std::chrono::ceil<std::chrono::seconds>(it->second.not_before - now);
+}
+
+unsigned RetryBackoff::attempts(const std::filesystem::path& repo) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto it = entries_.find(repo);
+    return it == entries_.end() ? 0 : it->second.attempts;
+}
+
+} // namespace procutil
@@ -0,0 +1,90 @@
+#include "scanner.hpp"
+
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <system_error>
+
+#include "git_utils.hpp"
+#include "logger.hpp"
+
+namespace fs = std::filesystem;
+
+bool clone_manifest_repo(const ManifestEntry& entry, std::map<fs::path, RepoInfo>& repo_infos,
+                         std::mutex& mtx, std::string& action, std::mutex& action_mtx,
+                         const git::FetchParams& params, bool silent, bool cli_mode,
+                         RepoStateTable* states, git::FetchResult* result_out) {
+    const fs::path& p = entry.path;
+    {
+        std::lock_guard<std::mutex> lk(action_mtx);
+        action = "Cloning " + p.filename().string();
+    }
+    RepoStateTable local_states;
+    RepoClaim live = (states ? *states : local_states).claim(p);
+    if (live)
+        live->set_status(RS_PULLING, "Cloning...");
+    if (logger_initialized())
+        log_info("Cloning " + entry.url + " into " + p.string());
+    std::function<void(int)> progress_cb = [slot = live.get()](int pct) {
+        if (slot)
+            slot->set_progress(pct);
+    };
+    std::error_code ec;
+    fs::create_directories(p.parent_path(), ec);
+    git::FetchParams clone_params = params;
+    clone_params.progress_cb = &progress_cb;
+    if (entry.depth > 0)
+        clone_params.depth = static_cast<int>(entry.depth);
+    git::FetchResult result = git::clone_repo(p, entry.url, clone_params, entry.branch);
+    bool ok = result.ok;
+    RepoInfo ri;
+    ri.auth_failed = result.auth_failed;
+    if (ok) {
+        git::RepoSession session(p);
+        ri.status = RS_PULL_OK;
+        ri.message = "Cloned";
+        ri.pulled = true;
+        ri.progress = 100;
+        ri.branch = session.current_branch().value_or("");
+        ri.commit = session.local_hash().value_or("");
+        if (ri.commit.size() > 7)
+            ri.commit = ri.commit.substr(0, 7);
+        if (logger_initialized())
+            log_info(p.string() + " cloned");
+        if (cli_mode && !silent)
+            std::cout << "Cloned " << p.filename().string() << std::endl;
+    } else {
+        if (result.kind == git::FetchError::Timeout)
+            ri.status = RS_TIMEOUT;
+        else if (result.kind == git::FetchError::RateLimit)
+            ri.status = RS_RATE_LIMIT;
+        else
+            ri.status = RS_ERROR;
+        ri.message = "Clone failed: " + result.error;
+        if (result.kind != git::FetchError::None && result.kind != git::FetchError::Other)
+            ri.message += std::string(" (") + git::fetch_error_name(result.kind) + ")";
+        if (logger_initialized())
+            log_error(p.string() + " clone failed: " + result.error);
+    }
+    {
+        // A reload may have dropped the manifest entry while it cloned
+        std::lock_guard<std::mutex> lk(mtx);
+        auto it = repo_infos.find(p);
+        if (it != repo_infos.end()) {
+            size_t packs = it->second.pack_count;
+            size_t loose = it->second.loose_objects;
+            it->second = ri;
+            it->second.pack_count = packs;
+            it->second.loose_objects = loose;
+        }
+    }
+    if (states)
+        states->touch(p);
+    live.release();
+    if (result_out)
+        *result_out = std::move(result);
+    return ok;
+}
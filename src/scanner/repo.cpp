@@ -7,11 +7,11 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <set>
 #include <string>
-#include <thread>
 
 #include "debug_utils.hpp"
 #include "git_utils.hpp"
@@ -25,7 +25,8 @@
 namespace fs = std::filesystem;
 
 static bool validate_repo(const fs::path& p, RepoInfo& ri, std::set<fs::path>& skip_repos,
-                          bool include_private, bool prev_pulled, const std::string& remote) {
+                          bool include_private, bool prev_pulled, const std::string& remote,
+                          git::RepoSession& session, const git::FetchParams& fetch_params) {
     if (!fs::exists(p)) {
         ri.status = RS_ERROR;
         ri.message = "Missing";
@@ -49,10 +50,10 @@ static bool validate_repo(const fs::path& p, RepoInfo& ri, std::set<fs::path>& s
             log_debug(p.string() + " tagged: not a git repo");
         return false;
     }
-    ri.commit = git::get_local_hash(p).value_or("");
+    ri.commit = session.local_hash().value_or("");
     if (ri.commit.size() > 7)
         ri.commit = ri.commit.substr(0, 7);
-    std::string remote_url = git::get_remote_url(p, remote).value_or("");
+    std::string remote_url = session.remote_url(remote).value_or("");
     if (!include_private) {
         if (!git::is_github_url(remote_url)) {
             ri.status = RS_SKIPPED;
@@ -61,7 +62,12 @@ static bool validate_repo(const fs::path& p, RepoInfo& ri, std::set<fs::path>& s
                 log_debug(p.string() + " skipped: non-GitHub repo");
             return false;
         }
-        if (!git::remote_accessible(p, remote)) {
+        // The probe asks whether the repo is public, so no credentials
+        git::FetchParams probe = fetch_params;
+        probe.use_credentials = false;
+        bool accessible = probe.remote_heads ? probe.remote_heads->get(session, remote, probe)->ok
+                                             : session.remote_accessible(remote, probe);
+        if (!accessible) {
             if (prev_pulled) {
                 ri.status = RS_TEMPFAIL;
                 ri.message = "Temporarily inaccessible";
@@ -76,7 +82,7 @@ static bool validate_repo(const fs::path& p, RepoInfo& ri, std::set<fs::path>& s
             return false;
         }
     }
-    ri.branch = git::get_current_branch(p).value_or("");
+    ri.branch = session.current_branch().value_or("");
     if (ri.branch.empty() || ri.branch == "HEAD") {
         ri.status = RS_HEAD_PROBLEM;
         ri.message = "Detached HEAD or branch error";
@@ -87,22 +93,29 @@ static bool validate_repo(const fs::path& p, RepoInfo& ri, std::set<fs::path>& s
 }
 
 static bool determine_pull_action(const fs::path& p, RepoInfo& ri, bool check_only, bool hash_check,
-                                  bool include_private, std::set<fs::path>& skip_repos,
+                                  std::set<fs::path>& skip_repos,
                                   bool was_accessible, bool skip_unavailable,
-                                  bool skip_accessible_errors, const std::string& remote) {
+                                  bool skip_accessible_errors, const std::string& remote,
+                                  git::RepoSession& session,
+                                  const git::FetchParams& fetch_params) {
     if (hash_check) {
-        std::string local = git::get_local_hash(p).value_or("");
-        bool auth_fail = false;
-        std::string remote_hash =
-            git::get_remote_hash(p, remote, ri.branch, include_private, &auth_fail).value_or("");
-        ri.auth_failed = auth_fail;
+        std::string local = session.local_hash().value_or("");
+        const git::FetchResult& fetched = session.fetch(remote, ri.branch, fetch_params);
+        ri.auth_failed = fetched.auth_failed;
+        std::string remote_hash = fetched.ok ? fetched.remote_hash : "";
+        if (fetched.kind == git::FetchError::Timeout || fetched.kind == git::FetchError::RateLimit) {
+            bool timeout = fetched.kind == git::FetchError::Timeout;
+            ri.status = timeout ? RS_TIMEOUT : RS_RATE_LIMIT;
+            ri.message = timeout ? "Fetch timed out" : "Rate limited";
+            return false;
+        }
         if (local.empty() || remote_hash.empty()) {
             ri.status = RS_ERROR;
             ri.message = "Error getting hashes or remote";
+            if (fetched.kind != git::FetchError::None && fetched.kind != git::FetchError::Other)
+                ri.message += std::string(" (") + git::fetch_error_name(fetched.kind) + ")";
             if ((skip_unavailable && !was_accessible) || skip_accessible_errors)
                 skip_repos.insert(p);
-            else
-                std::this_thread::sleep_for(std::chrono::seconds(1));
             return false;
         }
         if (local == remote_hash) {
@@ -116,7 +129,7 @@ static bool determine_pull_action(const fs::path& p, RepoInfo& ri, bool check_on
     if (check_only) {
         ri.status = RS_REMOTE_AHEAD;
         ri.message = hash_check ? "Remote ahead" : "Update possible";
-        ri.commit = git::get_local_hash(p).value_or("");
+        ri.commit = session.local_hash().value_or("");
         if (ri.commit.size() > 7)
             ri.commit = ri.commit.substr(0, 7);
         if (logger_initialized())
@@ -130,146 +143,199 @@ static bool determine_pull_action(const fs::path& p, RepoInfo& ri, bool check_on
     return true;
 }
 
-namespace scanner_detail { void execute_pull(
-    const fs::path& p, RepoInfo& ri, std::map<fs::path, RepoInfo>& repo_infos,
-    std::set<fs::path>& skip_repos, std::mutex& mtx, std::string& action,
-    std::mutex& action_mtx, const fs::path& log_dir, bool include_private,
-    const std::string& remote, size_t down_limit, size_t up_limit, size_t disk_limit,
-    bool force_pull, bool was_accessible, bool /*skip_timeout*/, bool skip_unavailable,
-    bool skip_accessible_errors, bool cli_mode, bool silent, const fs::path& post_pull_hook,
-    const std::optional<std::string>& pull_ref, std::chrono::seconds pull_timeout);
-} // namespace scanner_detail
+namespace scanner_detail {
 
-void process_repo(const fs::path& p, std::map<fs::path, RepoInfo>& repo_infos,
-                  std::set<fs::path>& skip_repos, std::mutex& mtx, std::atomic<bool>& running,
-                  std::string& action, std::mutex& action_mtx, bool include_private,
-                  const std::string& remote, const fs::path& log_dir, bool check_only,
-                  bool hash_check, size_t down_limit, size_t up_limit, size_t disk_limit,
-                  bool silent, bool cli_mode, bool dry_run, bool force_pull, bool skip_timeout,
-                  bool skip_unavailable, bool skip_accessible_errors,
-                  const fs::path& post_pull_hook, const std::optional<std::string>& pull_ref,
-                  std::chrono::seconds updated_since, bool show_pull_author,
-                  std::chrono::seconds pull_timeout, bool mutant_mode) {
-    if (!running)
-        return;
+void execute_pull(const fs::path& p, RepoInfo& ri, RepoSlot* live, std::set<fs::path>& skip_repos,
+                  std::string& action, std::mutex& action_mtx, const fs::path& log_dir,
+                  const std::string& remote, bool force_pull, bool was_accessible,
+                  bool skip_unavailable, bool skip_accessible_errors, bool cli_mode, bool silent,
+                  const std::optional<std::string>& pull_ref, git::RepoSession& session,
+                  const git::FetchParams& fetch_params, git::CommitInfoCache* commit_info);
+
+/**
+ * @brief Record a filesystem error raised while handling a repository.
+ */
+static StageResult stage_failed(ScanContext& ctx, RepoJob& job, const fs::filesystem_error& e) {
+    job.info.status = RS_ERROR;
+    job.info.message = e.what();
+    if ((ctx.skip_unavailable && !job.was_accessible) || ctx.skip_accessible_errors)
+        ctx.skip_repos.insert(job.path);
+    if (logger_initialized())
+        log_error(job.path.string() + " error: " + job.info.message);
+    return StageResult::Finish;
+}
+
+StageResult probe_repo(ScanContext& ctx, RepoJob& job) {
+    const fs::path& p = job.path;
+    if (!ctx.running)
+        return StageResult::Drop;
     if (logger_initialized())
         log_debug("Checking repo " + p.string());
-    {
-        std::lock_guard<std::mutex> lk(mtx);
-        auto it = repo_infos.find(p);
-        if (it != repo_infos.end()) {
-            if (it->second.status == RS_NOT_GIT)
-                return;
-            if (it->second.status == RS_PULLING || it->second.status == RS_CHECKING) {
-                if (!silent)
-                    std::cerr << "Skipping " << p << " - busy\n";
-                if (logger_initialized())
-                    log_debug("Skipping " + p.string() + " - busy");
-                return;
-            }
-        }
-    }
-    RepoInfo ri;
-    ri.path = p;
+    RepoInfo& ri = job.info;
     ri.auth_failed = false;
-    bool prev_pulled = false;
-    bool was_accessible = false;
     RepoStatus prev_status = RS_PENDING;
     {
-        std::lock_guard<std::mutex> lk(mtx);
-        auto it = repo_infos.find(p);
-        if (it != repo_infos.end()) {
-            prev_pulled = it->second.pulled;
+        std::lock_guard<std::mutex> lk(ctx.mtx);
+        auto it = ctx.repo_infos.find(p);
+        if (it != ctx.repo_infos.end()) {
+            if (it->second.status == RS_NOT_GIT)
+                return StageResult::Drop;
+            job.prev_pulled = it->second.pulled;
             ri.pulled = it->second.pulled;
             prev_status = it->second.status;
             if (it->second.status != RS_ERROR && it->second.status != RS_SKIPPED)
-                was_accessible = true;
+                job.was_accessible = true;
         }
     }
-    std::chrono::seconds effective_timeout = pull_timeout;
-    if (prev_status == RS_RATE_LIMIT) {
-        std::this_thread::sleep_for(std::chrono::seconds(5));
-    } else if (prev_status == RS_TIMEOUT) {
-        std::this_thread::sleep_for(std::chrono::seconds(5));
+    job.claim = ctx.states.claim(p);
+    if (!job.claim) {
+        if (!ctx.silent)
+            std::cerr << "Skipping " << p << " - busy\n";
+        if (logger_initialized())
+            log_debug("Skipping " + p.string() + " - busy");
+        return StageResult::Drop;
+    }
+    // The scanner's backoff timers space out retries; a repo that timed
+    // out last time only gets more time.
+    std::chrono::seconds effective_timeout = job.pull_timeout;
+    if (prev_status == RS_TIMEOUT) {
         if (effective_timeout.count() > 0)
             effective_timeout += std::chrono::seconds(5);
         else
             effective_timeout = std::chrono::seconds(5);
     }
     {
-        std::lock_guard<std::mutex> lk(action_mtx);
-        action = "Checking " + p.filename().string();
+        std::lock_guard<std::mutex> lk(ctx.action_mtx);
+        ctx.action = "Checking " + p.filename().string();
     }
+    job.progress_cb = [slot = job.claim.get()](int pct) { slot->set_progress(pct); };
+    job.fetch_params = job.fetch_defaults;
+    job.fetch_params.use_credentials = ctx.include_private;
+    job.fetch_params.down_limit_kbps = job.down_limit;
+    job.fetch_params.up_limit_kbps = job.up_limit;
+    job.fetch_params.disk_limit_kbps = job.disk_limit;
+    job.fetch_params.progress_cb = &job.progress_cb;
+    job.fetch_params.timeout = effective_timeout;
+    job.fetch_params.running = &ctx.running;
+    job.session = std::make_unique<git::RepoSession>(p);
+    git::RepoSession& session = *job.session;
     try {
-        if (!validate_repo(p, ri, skip_repos, include_private, prev_pulled, remote)) {
-            std::lock_guard<std::mutex> lk(mtx);
-            repo_infos[p] = ri;
-            return;
+        if (!validate_repo(p, ri, ctx.skip_repos, ctx.include_private, job.prev_pulled,
+                           ctx.remote, session, job.fetch_params))
+            return StageResult::Finish;
+        if (ctx.commit_info) {
+            git::CommitInfo head = ctx.commit_info->get(session);
+            ri.commit_author = head.author;
+            ri.commit_date = head.date;
+            ri.commit_time = head.time;
         }
-        ri.commit_author = git::get_last_commit_author(p);
-        ri.commit_date = git::get_last_commit_date(p);
-        ri.commit_time = git::get_last_commit_time(p);
-        if (updated_since.count() > 0) {
-            if (mutant_mode) {
-                if (!mutant_should_pull(p, ri, remote, include_private, updated_since)) {
-                    std::lock_guard<std::mutex> lk(mtx);
-                    repo_infos[p] = ri;
-                    return;
-                }
+    } catch (const fs::filesystem_error& e) {
+        return stage_failed(ctx, job, e);
+    }
+    return StageResult::Next;
+}
+
+StageResult fetch_repo(ScanContext& ctx, RepoJob& job) {
+    const fs::path& p = job.path;
+    RepoInfo& ri = job.info;
+    git::RepoSession& session = *job.session;
+    try {
+        if (ctx.updated_since.count() > 0) {
+            if (ctx.mutant_mode) {
+                if (!mutant_should_pull(session, ri, ctx.remote, job.fetch_params,
+                                        ctx.updated_since))
+                    return StageResult::Finish;
             } else {
-                std::time_t ct =
-                    git::get_remote_commit_time(p, remote, ri.branch, include_private, nullptr);
+                const git::FetchResult& fetched =
+                    session.fetch(ctx.remote, ri.branch, job.fetch_params);
+                std::time_t ct = fetched.ok ? fetched.remote_commit_time : 0;
                 if (ct == 0)
-                    ct = git::get_last_commit_time(p);
+                    ct = ctx.commit_info ? ri.commit_time : session.last_commit_time();
                 std::time_t now = std::time(nullptr);
-                if (ct == 0 || now - ct > updated_since.count()) {
+                if (ct == 0 || now - ct > ctx.updated_since.count()) {
                     ri.status = RS_SKIPPED;
                     ri.message = "Older than limit";
-                    std::lock_guard<std::mutex> lk(mtx);
-                    repo_infos[p] = ri;
-                    return;
+                    return StageResult::Finish;
                 }
             }
         }
 
-        bool do_pull =
-            determine_pull_action(p, ri, check_only, hash_check, include_private, skip_repos,
-                                  was_accessible, skip_unavailable, skip_accessible_errors, remote);
-        if (do_pull) {
-            if (dry_run) {
-                ri.status = RS_REMOTE_AHEAD;
-                ri.message = "Dry run";
-                ri.commit = git::get_local_hash(p).value_or("");
-                if (ri.commit.size() > 7)
-                    ri.commit = ri.commit.substr(0, 7);
-            } else {
-                auto start_time = std::chrono::steady_clock::now();
-                scanner_detail::execute_pull(p, ri, repo_infos, skip_repos, mtx, action, action_mtx, log_dir,
-                             include_private, remote, down_limit, up_limit, disk_limit, force_pull,
-                             was_accessible, skip_timeout, skip_unavailable, skip_accessible_errors,
-                             cli_mode, silent, post_pull_hook, pull_ref, effective_timeout);
-                auto end_time = std::chrono::steady_clock::now();
-                if (mutant_mode)
-                    mutant_record_result(
-                        p, ri.status,
-                        std::chrono::duration_cast<std::chrono::seconds>(end_time - start_time));
-            }
+        if (!determine_pull_action(p, ri, job.check_only, ctx.hash_check, ctx.skip_repos,
+                                   job.was_accessible, ctx.skip_unavailable,
+                                   ctx.skip_accessible_errors, ctx.remote, session,
+                                   job.fetch_params))
+            return StageResult::Finish;
+        if (ctx.dry_run) {
+            ri.status = RS_REMOTE_AHEAD;
+            ri.message = "Dry run";
+            ri.commit = session.local_hash().value_or("");
+            if (ri.commit.size() > 7)
+                ri.commit = ri.commit.substr(0, 7);
+            return StageResult::Finish;
         }
+        // Download now so the checkout stage only works on the disk. A
+        // failed fetch is reported by the checkout like before.
+        auto start_time = std::chrono::steady_clock::now();
+        const std::string* target = job.pull_ref && !job.pull_ref->empty() ? &*job.pull_ref
+                                                                            : nullptr;
+        git::fetch_for_pull(session, ctx.remote, job.fetch_params, target);
+        job.pull_time += std::chrono::steady_clock::now() - start_time;
     } catch (const fs::filesystem_error& e) {
-        ri.status = RS_ERROR;
-        ri.message = e.what();
-        if ((skip_unavailable && !was_accessible) || skip_accessible_errors)
-            skip_repos.insert(p);
-        else
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-        if (logger_initialized())
-            log_error(p.string() + " error: " + ri.message);
+        return stage_failed(ctx, job, e);
+    }
+    return StageResult::Next;
+}
+
+StageResult checkout_repo(ScanContext& ctx, RepoJob& job) {
+    RepoInfo& ri = job.info;
+    try {
+        auto start_time = std::chrono::steady_clock::now();
+        execute_pull(job.path, ri, job.claim.get(), ctx.skip_repos, ctx.action, ctx.action_mtx,
+                     ctx.log_dir, ctx.remote, job.force_pull, job.was_accessible,
+                     ctx.skip_unavailable, ctx.skip_accessible_errors, ctx.cli_mode, ctx.silent,
+                     job.pull_ref, *job.session, job.fetch_params, ctx.commit_info);
+        job.pull_time += std::chrono::steady_clock::now() - start_time;
+        if (ctx.mutant_mode)
+            mutant_record_result(
+                job.path, ri.status,
+                std::chrono::duration_cast<std::chrono::seconds>(job.pull_time));
+    } catch (const fs::filesystem_error& e) {
+        return stage_failed(ctx, job, e);
+    }
+    if (ri.pulled && !job.post_pull_hook.empty())
+        return StageResult::Next;
+    return StageResult::Finish;
+}
+
+void hook_repo(ScanContext& ctx, RepoJob& job) {
+    {
+        std::lock_guard<std::mutex> lk(ctx.action_mtx);
+        ctx.action = "Running hook for " + job.path.filename().string();
     }
+    run_post_pull_hook(job.post_pull_hook);
+}
+
+void finish_repo(ScanContext& ctx, RepoJob& job, git::FetchResult* fetch_out) {
+    const fs::path& p = job.path;
+    const RepoInfo& ri = job.info;
+    if (fetch_out && job.session)
+        if (const git::FetchResult* fetched = job.session->last_fetch())
+            *fetch_out = *fetched;
     {
-        std::lock_guard<std::mutex> lk(mtx);
-        repo_infos[p] = ri;
+        // A reload or rescan may have dropped the repository meanwhile, and
+        // pack counts are maintenance's to write, not the probe's copy
+        std::lock_guard<std::mutex> lk(ctx.mtx);
+        auto it = ctx.repo_infos.find(p);
+        if (it != ctx.repo_infos.end()) {
+            size_t packs = it->second.pack_count;
+            size_t loose = it->second.loose_objects;
+            it->second = ri;
+            it->second.pack_count = packs;
+            it->second.loose_objects = loose;
+        }
     }
-    if (cli_mode && !silent && ri.pulled && !prev_pulled) {
+    job.claim.release();
+    if (ctx.cli_mode && !ctx.silent && ri.pulled && !job.prev_pulled) {
         std::time_t now = std::time(nullptr);
         char buf[32];
 #ifdef _WIN32
@@ -284,7 +350,7 @@ void process_repo(const fs::path& p, std::map<fs::path, RepoInfo>& repo_infos,
             std::cout << " at " << ri.commit_date;
         else
             std::cout << " at " << buf;
-        if (show_pull_author && !ri.commit_author.empty())
+        if (ctx.show_pull_author && !ri.commit_author.empty())
             std::cout << " by " << ri.commit_author;
         if (!ri.commit.empty())
             std::cout << ", commit " << ri.commit;
@@ -293,3 +359,5 @@ void process_repo(const fs::path& p, std::map<fs::path, RepoInfo>& repo_infos,
     if (logger_initialized())
         log_debug(p.string() + " -> " + ri.message);
 }
+
+} // namespace scanner_detail
@@ -1,125 +1,719 @@
 #include "scanner.hpp"
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <set>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include "bandwidth_limiter.hpp"
 #include "debug_utils.hpp"
+#include "due_scheduler.hpp"
 #include "ui_loop.hpp"
 #include "git_utils.hpp"
+#include "host_scheduler.hpp"
+#include "retry_backoff.hpp"
 #include "logger.hpp"
 #include "resource_utils.hpp"
 #include "thread_compat.hpp"
+#include "traffic_budget.hpp"
+#include "mirror_cache.hpp"
+#include "scan_pipeline.hpp"
+#include "repo_state.hpp"
+#include "worker_pool.hpp"
 
 namespace fs = std::filesystem;
 
+/** @brief Whether a failure of this kind suggests the host is overloaded. */
+static bool congests_host(git::FetchError kind) {
+    switch (kind) {
+    case git::FetchError::RateLimit:
+    case git::FetchError::Timeout:
+    case git::FetchError::Server:
+    case git::FetchError::Network:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// Least time between two maintenance runs on one repository
+constexpr std::chrono::hours pack_maintenance_interval{1};
+
+/**
+ * @brief Consolidate the packs of the repositories that fetched objects.
+ *
+ * Works through the due repositories of @a state one at a time and stops as
+ * soon as a scan starts or the loop stops; the rest wait for the next run.
+ * A repository is maintained at most once per pack_maintenance_interval,
+ * and not while a scan job holds its slot in @a states.
+ */
+static void maintain_due_packs(ScanState& state, const git::PackMaintenance& policy,
+                               std::map<fs::path, RepoInfo>& repo_infos, std::mutex& mtx,
+                               RepoStateTable* states, const std::atomic<bool>& scanning,
+                               const std::atomic<bool>& running) {
+    std::vector<fs::path> due;
+    {
+        std::lock_guard<std::mutex> lk(state.maintenance_mtx);
+        auto now = std::chrono::steady_clock::now();
+        for (const auto& p : state.maintenance_due) {
+            auto last = state.maintained.find(p);
+            if (last == state.maintained.end() || now - last->second >= pack_maintenance_interval)
+                due.push_back(p);
+        }
+    }
+    for (const auto& p : due) {
+        if (!running || scanning)
+            break;
+        RepoClaim claim;
+        if (states) {
+            claim = states->claim(p);
+            if (!claim)
+                continue; // a scan job has it; try again next time
+        }
+        RepoStatus status = RS_PENDING;
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            auto it = repo_infos.find(p);
+            if (it == repo_infos.end() || it->second.status == RS_NOT_GIT)
+                continue;
+            status = it->second.status;
+        }
+        if (claim)
+            claim->set_status(status, "Maintaining packs");
+        git::RepoSession session(p);
+        git::PackStats stats = session.pack_stats();
+        std::string err;
+        if (session.maintain_packs(policy, stats, &err)) {
+            if (logger_initialized())
+                log_info(p.string() + " packs consolidated, now " + std::to_string(stats.packs) +
+                         " packs");
+        } else if (!err.empty() && logger_initialized()) {
+            log_warning(p.string() + " pack maintenance failed: " + err);
+        }
+        {
+            // A reload or rescan may have dropped the repository meanwhile
+            std::lock_guard<std::mutex> lk(mtx);
+            auto it = repo_infos.find(p);
+            if (it != repo_infos.end()) {
+                it->second.pack_count = stats.packs;
+                it->second.loose_objects = stats.loose_objects;
+            }
+        }
+        std::lock_guard<std::mutex> lk(state.maintenance_mtx);
+        state.maintenance_due.erase(p);
+        state.maintained[p] = std::chrono::steady_clock::now();
+    }
+}
+
+/**
+ * @brief Read the remote URL of each of @a repos, @a threads at a time.
+ *
+ * The caller works through the list as well. With @a pool the others run
+ * on it, which is kept large enough for them, the caller and pack
+ * maintenance still finishing from the previous scan.
+ *
+ * @return URL of each repository by index, empty when it has none.
+ */
+static std::vector<std::string> read_remote_urls(const std::vector<fs::path>& repos,
+                                                 const std::string& remote, size_t threads,
+                                                 procutil::WorkerPool* pool) {
+    std::vector<std::string> urls(repos.size());
+    std::atomic<size_t> next{0};
+    auto reader = [&]() {
+        for (size_t k = next++; k < repos.size(); k = next++)
+            urls[k] = git::get_remote_url(repos[k], remote).value_or("");
+    };
+    threads = std::clamp<size_t>(threads, 1, repos.size());
+    if (pool) {
+        procutil::WorkerPool::Reservation hold = pool->reserve(threads + 1);
+        std::vector<std::future<void>> done;
+        done.reserve(threads - 1);
+        for (size_t t = 1; t < threads; ++t)
+            done.push_back(pool->submit(reader));
+        reader();
+        for (auto& d : done)
+            d.wait();
+    } else {
+        std::vector<th_compat::jthread> helpers;
+        helpers.reserve(threads - 1);
+        for (size_t t = 1; t < threads; ++t)
+            helpers.emplace_back(reader);
+        reader();
+        for (auto& h : helpers) {
+            if (h.joinable())
+                h.join();
+        }
+    }
+    return urls;
+}
+
 void scan_repos(const std::vector<fs::path>& all_repos, std::map<fs::path, RepoInfo>& repo_infos,
                 std::set<fs::path>& skip_repos, std::mutex& mtx, std::atomic<bool>& scanning_flag,
                 std::atomic<bool>& running, std::string& action, std::mutex& action_mtx,
-                bool include_private, const std::string& remote, const fs::path& log_dir,
-                bool check_only, bool hash_check, size_t concurrency, double cpu_percent_limit,
-                size_t mem_limit, size_t down_limit, size_t up_limit, size_t disk_limit,
-                bool silent, bool cli_mode, bool dry_run, bool force_pull, bool skip_timeout,
-                bool skip_unavailable, bool skip_accessible_errors, const fs::path& post_pull_hook,
-                const std::optional<std::string>& pull_ref, std::chrono::seconds updated_since,
-                bool show_pull_author, std::chrono::seconds pull_timeout, bool retry_skipped,
-                bool reset_skipped,
-                const std::map<std::filesystem::path, RepoOptions>& repo_settings,
-                bool mutant_mode) {
-    git::GitInitGuard guard;
+                const ScanOptions& options) {
+    size_t concurrency = options.concurrency;
+    procutil::WorkerPool* pool = options.pool;
+    RepoStateTable* states = options.states;
+    procutil::DueScheduler* due = options.due;
+    ScanState* state = options.state;
     static size_t last_mem = 0;
     size_t mem_before = procutil::get_memory_usage_mb();
     size_t virt_before = procutil::get_virtual_memory_kb();
 
+    std::vector<fs::path> reset; // entries a scheduled scan resets
     {
         std::lock_guard<std::mutex> lk(mtx);
         for (auto& [p, info] : repo_infos) {
             if (skip_repos.count(p)) {
-                if (reset_skipped && info.status != RS_NOT_GIT) {
+                if (options.reset_skipped && info.status != RS_NOT_GIT) {
                     info.status = RS_PENDING;
                     info.message = "Pending...";
                     info.progress = 0;
+                    if (due)
+                        reset.push_back(p);
                 }
-                if (!retry_skipped)
+                if (!options.retry_skipped)
                     continue;
             }
-            if (info.status != RS_NOT_GIT) {
+            // Scheduled repositories keep their last result until their
+            // check starts
+            if (info.status != RS_NOT_GIT && !due) {
                 info.status = RS_PENDING;
                 info.message = "Pending...";
                 info.progress = 0;
             }
         }
-        if (retry_skipped)
+        if (options.retry_skipped)
             skip_repos.clear();
     }
+    // A fixed-cycle scan resets every entry, so the display copies the
+    // whole map once; a scheduled scan only marks the few it reset
+    if (states && !due)
+        states->touch_all();
+    else if (states)
+        for (const auto& p : reset)
+            states->touch(p);
 
     if (concurrency == 0)
         concurrency = 1;
     concurrency = std::min(concurrency, all_repos.size());
+    std::array<size_t, procutil::PipelineStats::stage_count> workers =
+        options.stages.workers(concurrency);
+    for (auto& n : workers)
+        n = std::min(n, all_repos.size());
+    procutil::PipelineStats local_stats;
+    procutil::PipelineStats& stats = options.pipeline_stats ? *options.pipeline_stats : local_stats;
+    stats.begin_scan(workers);
     if (logger_initialized())
         log_debug("Scanning repositories");
 
-    std::atomic<size_t> next_index{0};
-    auto worker = [&]() {
-        try {
-            while (running) {
-                size_t idx = next_index.fetch_add(1);
-                if (idx >= all_repos.size())
-                    break;
-                const auto& p = all_repos[idx];
-                if (!retry_skipped && skip_repos.count(p))
-                    continue;
-                RepoOptions ro;
-                {
-                    std::lock_guard<std::mutex> lk(mtx);
-                    auto it_ro = repo_settings.find(p);
-                    if (it_ro != repo_settings.end())
-                        ro = it_ro->second;
+    // Global limits are one budget shared by all workers; per-repo limits
+    // stay caps on that repository's own transfers.
+    procutil::BandwidthLimiter limiter(options.down_limit, options.up_limit, options.disk_limit);
+    if (options.up_limit > 0)
+        procutil::init_network_usage();
+    if (options.disk_limit > 0)
+        procutil::init_disk_usage();
+    procutil::TrafficBudget* budget = options.fetch_defaults.traffic_budget;
+    // Scheduled scans are short; the caller refills the cycle budget once
+    // per poll interval instead
+    if (budget && !due)
+        budget->begin_cycle();
+    if (options.fetch_defaults.mirror)
+        options.fetch_defaults.mirror->begin_cycle();
+    std::atomic<bool> budget_logged{false};
+
+    // Jobs are interleaved across remote hosts, each with its own adaptive
+    // window. Remote URLs are looked up once per repository and remembered.
+    // Repositories that failed transiently wait out their backoff timer.
+    std::unique_ptr<ScanState> local_state;
+    if (!state) {
+        local_state = std::make_unique<ScanState>();
+        state = local_state.get();
+    }
+    procutil::HostScheduler& hosts = state->hosts;
+    procutil::RetryBackoff& backoff = state->backoff;
+    auto& repo_urls = state->repo_urls;
+    // Commit metadata is only read when something displays or sorts by it,
+    // and then only again once HEAD moves.
+    git::CommitInfoCache& commit_cache = state->commit_cache;
+    git::CommitInfoCache* commit_info = options.need_commit_info ? &commit_cache : nullptr;
+    // Repositories sharing a remote URL connect to it once per cycle
+    git::RemoteHeadCache& remote_heads = state->remote_heads;
+    remote_heads.begin_cycle();
+    // Manifest repositories missing on disk are cloned by the same workers,
+    // under the same host windows and bandwidth limits as pulls.
+    std::map<fs::path, const ManifestEntry*> missing;
+    for (const auto& entry : options.manifest) {
+        if (!git::is_git_repo(entry.path))
+            missing[entry.path] = &entry;
+    }
+    // With a due scheduler only repositories due within the horizon are
+    // checked, each at its own due time. Workers stay on while checks are
+    // in flight, so a slow repository never holds back the others.
+    const auto scan_start = std::chrono::steady_clock::now();
+    const auto horizon = due ? scan_start + due->min_interval()
+                             : std::chrono::steady_clock::time_point::max();
+    hosts.begin_scan(std::max(concurrency, workers[1]), horizon);
+    // Repositories to check this scan, by index, with their due time
+    std::vector<std::pair<size_t, std::chrono::steady_clock::time_point>> checked;
+    for (size_t i = 0; i < all_repos.size(); ++i) {
+        const auto& p = all_repos[i];
+        if (!options.retry_skipped && skip_repos.count(p)) {
+            if (due)
+                due->started(p, scan_start);
+            continue;
+        }
+        auto wait = backoff.remaining(p);
+        if (wait.count() > 0) {
+            if (due)
+                due->defer(p, scan_start + wait);
+            std::lock_guard<std::mutex> lk(mtx);
+            auto it = repo_infos.find(p);
+            if (it != repo_infos.end()) {
+                it->second.status = RS_PENDING;
+                it->second.message = "Retry in " + std::to_string(wait.count()) + "s";
+                if (states)
+                    states->touch(p);
+            }
+            continue;
+        }
+        auto due_at = due ? due->due_at(p, scan_start) : scan_start;
+        if (due_at > horizon)
+            continue;
+        checked.emplace_back(i, due_at);
+    }
+    // Remote URLs not remembered yet, all of them on a first scan, are read
+    // by as many threads as the probe stage has instead of one at a time
+    std::vector<fs::path> unknown;
+    {
+        std::lock_guard<std::mutex> lk(state->urls_mtx);
+        for (const auto& [i, due_at] : checked) {
+            const auto& p = all_repos[i];
+            if (!missing.count(p) && !repo_urls.count(p))
+                unknown.push_back(p);
+        }
+    }
+    if (!unknown.empty()) {
+        std::vector<std::string> urls =
+            read_remote_urls(unknown, options.remote, concurrency, pool);
+        std::lock_guard<std::mutex> lk(state->urls_mtx);
+        for (size_t k = 0; k < unknown.size(); ++k) {
+            if (!urls[k].empty())
+                repo_urls.emplace(unknown[k], std::move(urls[k]));
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lk(state->urls_mtx);
+        for (const auto& [i, due_at] : checked) {
+            const auto& p = all_repos[i];
+            std::string host;
+            auto clone = missing.find(p);
+            if (clone != missing.end()) {
+                host = git::url_host(clone->second->url);
+            } else {
+                auto it = repo_urls.find(p);
+                if (it != repo_urls.end()) {
+                    host = git::url_host(it->second);
+                    remote_heads.add(it->second);
                 }
-                fs::path repo_hook = ro.post_pull_hook.value_or(post_pull_hook);
-                if (ro.exclude.value_or(false)) {
-                    std::lock_guard<std::mutex> lk(mtx);
-                    RepoInfo& info = repo_infos[p];
-                    if (info.path.empty())
-                        info.path = p;
-                    info.status = RS_SKIPPED;
-                    info.message = "Excluded";
-                    continue;
+            }
+            if (due_at > scan_start)
+                hosts.park(host, i, due_at);
+            else
+                hosts.add(host, i);
+        }
+    }
+
+    using Outcome = procutil::HostScheduler::Outcome;
+    using procutil::ScanStage;
+    using scanner_detail::RepoJob;
+    using scanner_detail::StageResult;
+    // Jobs publish progress and transitional states to their slot; the
+    // shared map is only written as they start and end.
+    RepoStateTable local_states;
+    RepoStateTable& live_states = states ? *states : local_states;
+    scanner_detail::ScanContext ctx{repo_infos, skip_repos, mtx, live_states, running, action,
+                                    action_mtx, options.include_private, options.remote,
+                                    options.log_dir, options.hash_check, options.silent,
+                                    options.cli_mode, options.dry_run, options.skip_unavailable,
+                                    options.skip_accessible_errors, options.updated_since,
+                                    options.show_pull_author, options.mutant_mode, commit_info};
+
+    // A repository in flight. It holds a slot of its host's window until
+    // its fetch is done; checkout and hook no longer count against the host.
+    struct Item {
+        std::unique_ptr<RepoJob> job;
+        size_t index = 0;
+        std::string host;
+        const ManifestEntry* clone = nullptr;
+        double cpu_limit = 0.0;
+    };
+    procutil::BoundedQueue<Item> fetch_q(2 * workers[1]);
+    procutil::BoundedQueue<Item> checkout_q(2 * workers[2]);
+    procutil::BoundedQueue<Item> hook_q(2 * workers[3]);
+    procutil::BoundedQueue<Item>* queues[] = {nullptr, &fetch_q, &checkout_q, &hook_q};
+    // Workers still serving each stage, and for each queue the workers that
+    // may still feed it: those of every earlier stage.
+    std::array<std::atomic<size_t>, procutil::PipelineStats::stage_count> live;
+    std::array<std::atomic<size_t>, procutil::PipelineStats::stage_count> feeders;
+    size_t earlier = 0;
+    for (size_t i = 0; i < live.size(); ++i) {
+        live[i] = workers[i];
+        feeders[i] = earlier;
+        earlier += workers[i];
+        if (queues[i] && workers[i] > 0)
+            stats[static_cast<ScanStage>(i)].capacity = queues[i]->capacity();
+    }
+
+    auto set_message = [&](const fs::path& p, RepoStatus status, const std::string& msg) {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            auto it = repo_infos.find(p);
+            if (it == repo_infos.end())
+                return;
+            it->second.status = status;
+            it->second.message = msg;
+        }
+        live_states.touch(p);
+    };
+    // A repository whose fetch failed transiently is parked with its
+    // backoff time and tried once more in the same scan when that is soon
+    // enough; workers go on with other repositories meanwhile. A timeout
+    // already used up its whole limit, so unless --dont-skip-timeouts is
+    // given it waits for a later scan instead.
+    constexpr std::chrono::seconds scan_retry_horizon{10};
+    std::vector<unsigned char> retried(all_repos.size(), 0);
+    // Release the host slot, adapting the host's window and the
+    // repository's backoff to how the remote answered. Returns true when
+    // the repository was parked for a retry; its job then ends here.
+    auto settle = [&](Item& item) -> bool {
+        const fs::path& p = item.job->path;
+        const git::FetchResult* fetched = item.job->session ? item.job->session->last_fetch()
+                                                            : nullptr;
+        Outcome outcome = Outcome::Neutral;
+        std::optional<std::chrono::steady_clock::time_point> retry_at;
+        if (!fetched || fetched->remote.empty() || fetched->kind == git::FetchError::Cancelled) {
+            outcome = Outcome::Neutral; // the remote was never asked
+        } else if (fetched->ok) {
+            backoff.success(p);
+            outcome = Outcome::Success;
+        } else {
+            if (git::is_transient(fetched->kind)) {
+                auto until = backoff.failure(p, fetched->retry_after);
+                if (logger_initialized())
+                    log_debug(p.string() + " " + git::fetch_error_name(fetched->kind) +
+                              ", retry in " +
+                              std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+                                                 until - std::chrono::steady_clock::now())
+                                                 .count()) +
+                              "s");
+                bool retry_now = fetched->kind != git::FetchError::Timeout || !options.skip_timeout;
+                if (retry_now && !retried[item.index] && running &&
+                    until - std::chrono::steady_clock::now() <= scan_retry_horizon) {
+                    retried[item.index] = 1;
+                    retry_at = until;
                 }
-                bool co = ro.check_only.value_or(check_only);
-                double cl = ro.cpu_limit.value_or(cpu_percent_limit);
-                size_t dl = ro.download_limit.value_or(down_limit);
-                size_t ul = ro.upload_limit.value_or(up_limit);
-                size_t disk = ro.disk_limit.value_or(disk_limit);
-                bool fp = ro.force_pull.value_or(force_pull);
-                std::chrono::seconds pt = ro.pull_timeout.value_or(pull_timeout);
-                std::optional<std::string> repo_target = ro.pull_ref;
-                if (!repo_target && pull_ref)
-                    repo_target = pull_ref;
-                process_repo(p, repo_infos, skip_repos, mtx, running, action, action_mtx,
-                             include_private, remote, log_dir, co, hash_check, dl, ul, disk, silent,
-                             cli_mode, dry_run, fp, skip_timeout, skip_unavailable,
-                             skip_accessible_errors, repo_hook, repo_target, updated_since,
-                             show_pull_author, pt, mutant_mode);
-                if (mem_limit > 0 && procutil::get_memory_usage_mb() > mem_limit) {
-                    log_error("Memory limit exceeded");
-                    running = false;
-                    break;
+            }
+            if (congests_host(fetched->kind))
+                outcome = Outcome::Congested;
+        }
+        if (retry_at) {
+            auto wait = std::chrono::ceil<std::chrono::seconds>(
+                *retry_at - std::chrono::steady_clock::now());
+            set_message(p, RS_PENDING, "Retry in " + std::to_string(wait.count()) + "s");
+            item.job->claim.release();
+            hosts.retry(item.host, item.index, outcome, *retry_at);
+        } else {
+            hosts.finish(item.host, outcome);
+        }
+        if (outcome == Outcome::Congested && logger_initialized())
+            log_debug("Host " + (item.host.empty() ? std::string("local") : item.host) +
+                      " congested, window " + std::to_string(hosts.window(item.host)));
+        return retry_at.has_value();
+    };
+    auto forward = [&](ScanStage stage, Item item) {
+        procutil::BoundedQueue<Item>& q = *queues[static_cast<size_t>(stage)];
+        const fs::path p = item.job->path;
+        const std::string host = item.host;
+        if (item.job->claim)
+            item.job->claim->set_message(std::string("Waiting for ") +
+                                         procutil::PipelineStats::name(stage));
+        // A closed queue means the stage is gone after an error
+        if (!q.push(std::move(item))) {
+            if (stage == ScanStage::Fetch)
+                hosts.finish(host, Outcome::Neutral);
+            if (logger_initialized())
+                log_warning(p.string() + " dropped, " + procutil::PipelineStats::name(stage) +
+                            " stage stopped");
+        }
+        stats[stage].queued = q.size();
+    };
+    // Publish the job's result and learn from it when to check again
+    auto finish = [&](RepoJob& job) {
+        scanner_detail::finish_repo(ctx, job);
+        // Only repositories that received objects can have new packs or
+        // loose objects to consolidate
+        const git::FetchResult* fetched = job.session ? job.session->last_fetch() : nullptr;
+        if (options.maintenance.enabled && fetched && fetched->ok && !fetched->fetch_skipped &&
+            fetched->received_objects > 0) {
+            std::lock_guard<std::mutex> lk(state->maintenance_mtx);
+            state->maintenance_due.insert(job.path);
+        }
+        if (!due)
+            return;
+        auto upstream = procutil::DueScheduler::Upstream::Unknown;
+        switch (job.info.status) {
+        case RS_PULL_OK:
+        case RS_PKGLOCK_FIXED:
+        case RS_REMOTE_AHEAD:
+            upstream = procutil::DueScheduler::Upstream::Changed;
+            break;
+        case RS_UP_TO_DATE:
+            upstream = procutil::DueScheduler::Upstream::Unchanged;
+            break;
+        default:
+            break;
+        }
+        due->checked(job.path, upstream, std::chrono::steady_clock::now());
+    };
+    auto timed = [&](ScanStage stage, const std::function<void()>& work) {
+        procutil::StageStats& st = stats[stage];
+        ++st.busy;
+        auto start = procutil::PipelineStats::now_ms();
+        work();
+        st.busy_ms += procutil::PipelineStats::now_ms() - start;
+        --st.busy;
+    };
+    auto throttle = [&](double cl) {
+        if (options.mem_limit > 0 && procutil::get_memory_usage_mb() > options.mem_limit) {
+            if (running.exchange(false))
+                log_error("Memory limit exceeded");
+            return;
+        }
+        if (cl > 0.0) {
+            double cpu = procutil::get_cpu_percent();
+            if (cpu > cl) {
+                double over = cpu / cl - 1.0;
+                std::this_thread::sleep_for(
+                    std::chrono::milliseconds(static_cast<int>(over * 100)));
+            }
+        }
+    };
+
+    // Probe: resolve the repository's settings and check it locally and
+    // against the remote. Returns true when the job moves on to the fetch.
+    // Out of budget: leave the repo pending for the next window instead of
+    // starting another fetch.
+    auto over_budget = [&](const fs::path& p) {
+        if (!budget || !budget->exhausted())
+            return false;
+        if (!budget_logged.exchange(true) && logger_initialized())
+            log_info("Traffic budget reached, deferring remaining repositories");
+        set_message(p, RS_PENDING, "Deferred: traffic budget reached");
+        return true;
+    };
+    auto probe = [&](const fs::path& p, Item& item) -> bool {
+        if (due)
+            due->started(p, std::chrono::steady_clock::now());
+        RepoOptions ro;
+        auto it_ro = options.repo_settings.find(p);
+        if (it_ro != options.repo_settings.end())
+            ro = it_ro->second;
+        item.cpu_limit = ro.cpu_limit.value_or(options.cpu_percent_limit);
+        if (ro.exclude.value_or(false)) {
+            set_message(p, RS_SKIPPED, "Excluded");
+            hosts.finish(item.host, Outcome::Neutral);
+            return false;
+        }
+        if (over_budget(p)) {
+            hosts.finish(item.host, Outcome::Neutral);
+            return false;
+        }
+        item.job = std::make_unique<RepoJob>();
+        RepoJob& job = *item.job;
+        job.path = p;
+        job.check_only = ro.check_only.value_or(options.check_only);
+        job.force_pull = ro.force_pull.value_or(options.force_pull);
+        job.down_limit = ro.download_limit.value_or(0);
+        job.up_limit = ro.upload_limit.value_or(0);
+        job.disk_limit = ro.disk_limit.value_or(0);
+        job.post_pull_hook = ro.post_pull_hook.value_or(options.post_pull_hook);
+        job.pull_timeout = ro.pull_timeout.value_or(options.pull_timeout);
+        job.pull_ref = ro.pull_ref;
+        if (!job.pull_ref && options.pull_ref)
+            job.pull_ref = options.pull_ref;
+        git::FetchParams& repo_fetch = job.fetch_defaults;
+        repo_fetch = options.fetch_defaults;
+        repo_fetch.remote_heads = &remote_heads;
+        if (limiter.active())
+            repo_fetch.shared_limiter = &limiter;
+        repo_fetch.tags = ro.fetch_tags.value_or(options.fetch_defaults.tags);
+        repo_fetch.single_branch = ro.single_branch.value_or(options.fetch_defaults.single_branch);
+        repo_fetch.prune = ro.prune.value_or(options.fetch_defaults.prune);
+        if (ro.fetch_depth)
+            repo_fetch.depth = static_cast<int>(*ro.fetch_depth);
+        if (ro.max_runtime)
+            repo_fetch.deadline = std::chrono::steady_clock::now() + *ro.max_runtime;
+        auto clone = missing.find(p);
+        if (clone != missing.end()) {
+            if (job.check_only || options.dry_run) {
+                set_message(p, RS_SKIPPED, "Missing, not cloned");
+                hosts.finish(item.host, Outcome::Neutral);
+                return false;
+            }
+            item.clone = clone->second;
+            job.claim = live_states.claim(p);
+            return true;
+        }
+        StageResult result = scanner_detail::probe_repo(ctx, job);
+        // A remote that was repointed since its URL was remembered is
+        // grouped under its new host from the next scan on
+        if (job.session) {
+            std::string url = job.session->remote_url(options.remote).value_or("");
+            std::lock_guard<std::mutex> lk(state->urls_mtx);
+            if (!url.empty() && repo_urls[p] != url) {
+                if (logger_initialized())
+                    log_debug(p.string() + " remote URL changed to " + url);
+                repo_urls[p] = url;
+            }
+        }
+        if (result == StageResult::Next)
+            return true;
+        if (!settle(item) && result == StageResult::Finish)
+            finish(job);
+        return false;
+    };
+    // Fetch: download from the remote, or clone a missing manifest entry.
+    // Returns true when the work tree needs updating.
+    auto fetch = [&](Item& item) -> bool {
+        RepoJob& job = *item.job;
+        // Fetches that ran while this one waited may have used up the budget
+        if (over_budget(job.path)) {
+            job.claim.release();
+            hosts.finish(item.host, Outcome::Neutral);
+            return false;
+        }
+        if (item.clone) {
+            job.claim.release(); // the clone takes the slot itself
+            git::FetchParams clone_params = job.fetch_defaults;
+            clone_params.use_credentials = options.include_private;
+            clone_params.down_limit_kbps = job.down_limit;
+            clone_params.up_limit_kbps = job.up_limit;
+            clone_params.disk_limit_kbps = job.disk_limit;
+            clone_params.timeout = job.pull_timeout;
+            clone_params.running = &running;
+            git::FetchResult cloned;
+            clone_manifest_repo(*item.clone, repo_infos, mtx, action, action_mtx, clone_params,
+                                options.silent, options.cli_mode, &live_states, &cloned);
+            Outcome outcome = Outcome::Neutral;
+            if (cloned.ok) {
+                backoff.success(job.path);
+                outcome = Outcome::Success;
+            } else if (cloned.kind != git::FetchError::Cancelled) {
+                backoff.failure(job.path, cloned.retry_after);
+                if (congests_host(cloned.kind))
+                    outcome = Outcome::Congested;
+            }
+            if (due)
+                due->checked(job.path, procutil::DueScheduler::Upstream::Unknown,
+                             std::chrono::steady_clock::now());
+            hosts.finish(item.host, outcome);
+            return false;
+        }
+        StageResult result = running ? scanner_detail::fetch_repo(ctx, job) : StageResult::Drop;
+        if (settle(item))
+            return false;
+        if (result == StageResult::Finish)
+            finish(job);
+        return result == StageResult::Next;
+    };
+    auto checkout = [&](Item& item) -> bool {
+        RepoJob& job = *item.job;
+        StageResult result = running ? scanner_detail::checkout_repo(ctx, job) : StageResult::Drop;
+        if (result == StageResult::Finish)
+            finish(job);
+        return result == StageResult::Next;
+    };
+    auto hook = [&](Item& item) {
+        if (running)
+            scanner_detail::hook_repo(ctx, *item.job);
+        finish(*item.job);
+    };
+
+    auto run_stage = [&](ScanStage stage, Item& item) -> bool {
+        switch (stage) {
+        case ScanStage::Fetch:
+            return fetch(item);
+        case ScanStage::Checkout:
+            return checkout(item);
+        case ScanStage::Hook:
+            hook(item);
+            return false;
+        default:
+            return false;
+        }
+    };
+    // Hand @a item to stage @a s. Stages without workers of their own run
+    // right here, on the thread of the stage before them.
+    auto advance = [&](size_t s, Item item) {
+        for (; s < workers.size(); ++s) {
+            auto stage = static_cast<ScanStage>(s);
+            if (workers[s] > 0) {
+                forward(stage, std::move(item));
+                return;
+            }
+            bool next = false;
+            timed(stage, [&]() { next = run_stage(stage, item); });
+            if (!next)
+                return;
+        }
+    };
+
+    // Each worker serves one stage. The last worker to leave a stage closes
+    // its input, so nothing waits on a stage that is gone, and a queue is
+    // closed once no earlier stage can feed it, so its stage drains and
+    // stops.
+    auto stage_worker = [&](ScanStage stage) {
+        const size_t s = static_cast<size_t>(stage);
+        try {
+            if (stage == ScanStage::Probe) {
+                size_t idx = 0;
+                std::string host;
+                while (hosts.next(idx, host, running)) {
+                    Item item;
+                    item.index = idx;
+                    item.host = host;
+                    bool next = false;
+                    timed(stage, [&]() { next = probe(all_repos[idx], item); });
+                    double cl = item.cpu_limit;
+                    if (next)
+                        advance(s + 1, std::move(item));
+                    throttle(cl);
                 }
-                if (cl > 0.0) {
-                    double cpu = procutil::get_cpu_percent();
-                    if (cpu > cl) {
-                        double over = cpu / cl - 1.0;
-                        std::this_thread::sleep_for(
-                            std::chrono::milliseconds(static_cast<int>(over * 100)));
-                    }
+            } else {
+                Item item;
+                while (queues[s]->pop(item)) {
+                    stats[stage].queued = queues[s]->size();
+                    bool next = false;
+                    timed(stage, [&]() { next = run_stage(stage, item); });
+                    double cl = item.cpu_limit;
+                    if (next)
+                        advance(s + 1, std::move(item));
+                    item = Item();
+                    throttle(cl);
                 }
             }
         } catch (const std::exception& e) {
@@ -129,22 +723,77 @@ void scan_repos(const std::vector<fs::path>& all_repos, std::map<fs::path, RepoI
             log_error("Worker thread unknown exception");
             running = false;
         }
+        if (--live[s] == 0 && queues[s])
+            queues[s]->close();
+        for (size_t k = s + 1; k < feeders.size(); ++k) {
+            if (--feeders[k] == 0)
+                queues[k]->close();
+        }
     };
 
-    std::vector<th_compat::jthread> threads;
-    threads.reserve(concurrency);
-    const size_t max_threads = concurrency;
-    for (size_t i = 0; i < max_threads; ++i) {
-        if (threads.size() >= max_threads)
-            break;
-        threads.emplace_back(worker);
+    std::vector<ScanStage> roles;
+    for (size_t s = 0; s < workers.size(); ++s)
+        roles.insert(roles.end(), workers[s], static_cast<ScanStage>(s));
+    // Pack maintenance left running by the previous scan keeps a pool
+    // thread until it notices this scan and stops
+    const bool pool_maintenance = pool && !local_state && !options.last_scan &&
+                                  options.maintenance.enabled && !options.dry_run;
+    if (pool) {
+        // The event loop's pool keeps its threads between scans. Every stage
+        // worker needs a thread of its own, besides the caller's and the
+        // maintenance task's, until the stages have drained; a config reload
+        // cannot shrink it below that.
+        procutil::WorkerPool::Reservation hold =
+            pool->reserve(roles.size() + 1 + (pool_maintenance ? 1 : 0));
+        std::vector<std::future<void>> done;
+        done.reserve(roles.size());
+        for (ScanStage stage : roles)
+            done.push_back(pool->submit([&stage_worker, stage]() { stage_worker(stage); }));
+        for (auto& d : done)
+            d.wait();
+    } else {
+        std::vector<th_compat::jthread> threads;
+        threads.reserve(roles.size());
+        for (ScanStage stage : roles)
+            threads.emplace_back([&stage_worker, stage]() { stage_worker(stage); });
+        for (auto& t : threads) {
+            if (t.joinable())
+                t.join();
+        }
+    }
+    stats.end_scan();
+
+    {
+        // Repositories that left the list are neither maintained nor timed
+        std::set<fs::path> live(all_repos.begin(), all_repos.end());
+        std::lock_guard<std::mutex> lk(state->maintenance_mtx);
+        for (auto it = state->maintenance_due.begin(); it != state->maintenance_due.end();)
+            it = live.count(*it) ? std::next(it) : state->maintenance_due.erase(it);
+        for (auto it = state->maintained.begin(); it != state->maintained.end();)
+            it = live.count(it->first) ? std::next(it) : state->maintained.erase(it);
+    }
+    // libgit2 stays initialised between scans. What the scan left behind is
+    // trimmed instead: caches keyed by repository shrink to the current
+    // list, ref listings of this cycle are dropped, and freed heap goes
+    // back to the OS.
+    size_t trim_before = debugMemory ? procutil::read_memory_usage_kb() : 0;
+    commit_cache.retain(all_repos);
+    if (due)
+        due->retain(all_repos);
+    remote_heads.begin_cycle();
+    {
+        std::set<fs::path> live(all_repos.begin(), all_repos.end());
+        for (auto it = repo_urls.begin(); it != repo_urls.end();)
+            it = live.count(it->first) ? std::next(it) : repo_urls.erase(it);
     }
-    for (auto& t : threads) {
-        if (t.joinable())
-            t.join();
+    procutil::release_free_memory();
+    if (debugMemory) {
+        size_t trim_after = procutil::read_memory_usage_kb();
+        log_debug("Cache trim rss_before=" + std::to_string(trim_before / 1024) +
+                  "MB rss_after=" + std::to_string(trim_after / 1024) +
+                  "MB commit_cache=" + std::to_string(commit_cache.size()) +
+                  " repo_urls=" + std::to_string(repo_urls.size()));
     }
-    threads.clear();
-    threads.shrink_to_fit();
     if (debugMemory || dumpState) {
         size_t mem_after = procutil::get_memory_usage_mb();
         size_t virt_after = procutil::get_virtual_memory_kb();
@@ -172,4 +821,30 @@ void scan_repos(const std::vector<fs::path>& all_repos, std::map<fs::path, RepoI
     }
     if (logger_initialized())
         log_debug("Scan complete");
+
+    // Pack maintenance runs after the scan as a task of its own on the
+    // pool and gives way to the next scan. Without a pool, when the state
+    // ends with this scan or when no scan follows, it runs here.
+    if (options.maintenance.enabled && !options.dry_run) {
+        if (pool_maintenance) {
+            // A run still finishing its last repository keeps the rest
+            bool idle = !state->maintenance.valid() ||
+                        state->maintenance.wait_for(std::chrono::seconds(0)) ==
+                            std::future_status::ready;
+            if (idle)
+                state->maintenance = pool->submit([state, policy = options.maintenance, &repo_infos,
+                                                   &mtx, states, &scanning_flag, &running]() {
+                    maintain_due_packs(*state, policy, repo_infos, mtx, states, scanning_flag,
+                                       running);
+                });
+        } else {
+            maintain_due_packs(*state, options.maintenance, repo_infos, mtx, &live_states,
+                               scanning_flag, running);
+        }
+    }
+}
+
+ScanState::~ScanState() {
+    if (maintenance.valid())
+        maintenance.wait();
 }
@@ -0,0 +1,103 @@
+#include "string_pool.hpp"
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+using Pool = std::unordered_map<std::string_view, std::unique_ptr<InternedString::Entry>>;
+
+// Never destroyed, so handles in other static objects can still release
+// their strings at exit
+std::shared_mutex& pool_mutex() {
+    static auto* mtx = new std::shared_mutex;
+    return *mtx;
+}
+
+// Keys view the string of their entry; entries are allocated on their own
+// so handles stay valid while the map rehashes
+Pool& pool() {
+    static auto* strings = new Pool;
+    return *strings;
+}
+
+// New references are only taken under the pool lock, so an entry whose
+// count is seen at zero under the exclusive lock can be erased safely
+InternedString::Entry* intern(const std::string& s) {
+    {
+        std::shared_lock<std::shared_mutex> lk(pool_mutex());
+        auto it = pool().find(s);
+        if (it != pool().end()) {
+            it->second->refs.fetch_add(1, std::memory_order_relaxed);
+            return it->second.get();
+        }
+    }
+    std::unique_lock<std::shared_mutex> lk(pool_mutex());
+    auto it = pool().find(s);
+    if (it == pool().end()) {
+        auto entry = std::make_unique<InternedString::Entry>();
+        entry->str = s;
+        std::string_view key = entry->str;
+        it = pool().emplace(key, std::move(entry)).first;
+    }
+    it->second->refs.fetch_add(1, std::memory_order_relaxed);
+    return it->second.get();
+}
+} // namespace
+
+const std::string InternedString::empty_;
+
+InternedString::InternedString(const std::string& s) : entry_(s.empty() ? nullptr : intern(s)) {}
+
+InternedString::InternedString(const char* s) : InternedString(std::string(s ? s : "")) {}
+
+InternedString::InternedString(const InternedString& other) noexcept : entry_(other.entry_) {
+    if (entry_)
+        entry_->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+InternedString::InternedString(InternedString&& other) noexcept
+    : entry_(std::exchange(other.entry_, nullptr)) {}
+
+InternedString& InternedString::operator=(const InternedString& other) noexcept {
+    if (entry_ != other.entry_) {
+        if (other.entry_)
+            other.entry_->refs.fetch_add(1, std::memory_order_relaxed);
+        release();
+        entry_ = other.entry_;
+    }
+    return *this;
+}
+
+InternedString& InternedString::operator=(InternedString&& other) noexcept {
+    if (this != &other) {
+        release();
+        entry_ = std::exchange(other.entry_, nullptr);
+    }
+    return *this;
+}
+
+InternedString::~InternedString() { release(); }
+
+void InternedString::release() noexcept {
+    if (!entry_)
+        return;
+    Entry* e = std::exchange(entry_, nullptr);
+    // Dropping a reference that is not the last needs no lock
+    size_t n = e->refs.load(std::memory_order_relaxed);
+    while (n > 1) {
+        if (e->refs.compare_exchange_weak(n, n - 1, std::memory_order_acq_rel))
+            return;
+    }
+    std::unique_lock<std::shared_mutex> lk(pool_mutex());
+    if (e->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        pool().erase(pool().find(e->str));
+}
+
+size_t InternedString::pool_size() {
+    std::shared_lock<std::shared_mutex> lk(pool_mutex());
+    return pool().size();
+}
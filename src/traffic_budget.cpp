@@ -0,0 +1,78 @@
+#include "traffic_budget.hpp"
+
+namespace procutil {
+
+TrafficBudget::TrafficBudget(size_t cycle_limit_bytes, size_t daily_limit_bytes)
+    : cycle_limit_(cycle_limit_bytes), daily_limit_(daily_limit_bytes) {}
+
+bool TrafficBudget::active() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return cycle_limit_ > 0 || daily_limit_ > 0;
+}
+
+void TrafficBudget::set_limits(size_t cycle_limit_bytes, size_t daily_limit_bytes) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    cycle_limit_ = cycle_limit_bytes;
+    daily_limit_ = daily_limit_bytes;
+}
+
+size_t TrafficBudget::cycle_limit() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return cycle_limit_;
+}
+
+size_t TrafficBudget::daily_limit() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return daily_limit_;
+}
+
+/**
+ * @brief Reset the daily counter when the local date changed.
+ *
+ * @param now Current time. Caller holds mtx_.
+ */
+void TrafficBudget::roll_day(std::time_t now) {
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &now);
+#else
+    localtime_r(&now, &tm);
+#endif
+    int key = tm.tm_year * 1000 + tm.tm_yday;
+    if (key != day_key_) {
+        day_key_ = key;
+        day_used_ = 0;
+    }
+}
+
+void TrafficBudget::begin_cycle() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    cycle_used_ = 0;
+}
+
+void TrafficBudget::add(size_t bytes) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    roll_day(std::time(nullptr));
+    cycle_used_ += bytes;
+    day_used_ += bytes;
+}
+
+bool TrafficBudget::exhausted() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    roll_day(std::time(nullptr));
+    return (cycle_limit_ > 0 && cycle_used_ >= cycle_limit_) ||
+           (daily_limit_ > 0 && day_used_ >= daily_limit_);
+}
+
+size_t TrafficBudget::cycle_used() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return cycle_used_;
+}
+
+size_t TrafficBudget::day_used() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    roll_day(std::time(nullptr));
+    return day_used_;
+}
+
+} // namespace procutil
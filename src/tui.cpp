@@ -8,6 +8,8 @@
 #include "git_utils.hpp"
 #include "resource_utils.hpp"
 #include "system_utils.hpp"
+#include "traffic_budget.hpp"
+#include "scan_pipeline.hpp"
 #include "version.hpp"
 
 #ifdef _WIN32
@@ -150,10 +152,13 @@ std::string render_header(const std::vector<fs::path>& all_repos,
  * @param show_affinity  Include CPU affinity mask.
  * @param track_vmem     Include virtual memory usage.
  * @param c              ANSI color palette (unused but reserved for future styling).
+ * @param budget         Traffic budget to report, or nullptr when none is set.
+ * @param pipeline       Scan stage counters, shown while a scan runs.
  * @return Formatted statistics string.
  */
 std::string render_stats(bool track_cpu, bool track_mem, bool track_threads, bool track_net,
-                         bool show_affinity, bool track_vmem, [[maybe_unused]] const TuiColors& c) {
+                         bool show_affinity, bool track_vmem, [[maybe_unused]] const TuiColors& c,
+                         procutil::TrafficBudget* budget, procutil::PipelineStats* pipeline) {
     std::ostringstream out;
     if (track_cpu || track_mem || track_threads || show_affinity || track_vmem) {
         // Layout: CPU, memory, optional virtual memory, thread count and core affinity
@@ -187,6 +192,36 @@ std::string render_stats(bool track_cpu, bool track_mem, bool track_threads, boo
         out << "Net: D " << format_bytes(usage.download_bytes) << "  U "
             << format_bytes(usage.upload_bytes) << "\n";
     }
+    if (budget && budget->active()) {
+        // Bytes fetched against the per-cycle and per-day budgets
+        out << "Traffic: cycle " << format_bytes(budget->cycle_used());
+        if (budget->cycle_limit() > 0)
+            out << "/" << format_bytes(budget->cycle_limit());
+        out << "  day " << format_bytes(budget->day_used());
+        if (budget->daily_limit() > 0)
+            out << "/" << format_bytes(budget->daily_limit());
+        if (budget->exhausted())
+            out << "  (exhausted)";
+        out << "\n";
+    }
+    if (pipeline && pipeline->active()) {
+        // Per stage: busy/total workers, utilisation so far, queued/capacity
+        out << "Stages:";
+        for (size_t i = 0; i < procutil::PipelineStats::stage_count; ++i) {
+            auto stage = static_cast<procutil::ScanStage>(i);
+            procutil::StageStats& st = (*pipeline)[stage];
+            out << "  " << procutil::PipelineStats::name(stage) << " " << st.busy;
+            if (st.workers == 0) {
+                out << " inline"; // runs on the previous stage's workers
+                continue;
+            }
+            out << "/" << st.workers << " "
+                << static_cast<int>(pipeline->utilisation(stage) * 100) << "%";
+            if (stage != procutil::ScanStage::Probe)
+                out << " q" << st.queued << "/" << st.capacity;
+        }
+        out << "\n";
+    }
     return out.str();
 }
 
@@ -307,6 +342,9 @@ std::string render_repo_entry(const fs::path& p, const RepoInfo& ri, bool show_s
         out << " - " << ri.message;
     if (ri.auth_failed)
         out << c.red << " [AUTH]" << c.reset; // Highlight authentication problems
+    if (ri.pack_count > 0 || ri.loose_objects > 0)
+        out << c.gray << " [" << ri.pack_count << " packs, ~" << ri.loose_objects << " loose]"
+            << c.reset;
     if (ri.status == RS_PULLING)
         out << " (" << ri.progress << "%)";
     out << "\n";
@@ -321,7 +359,8 @@ void draw_tui(const std::vector<fs::path>& all_repos,
               bool session_dates_only, bool no_colors, const std::string& custom_color,
               const TuiTheme& theme, const std::string& status_msg, int runtime_sec,
               bool show_datetime_line, bool show_header, bool show_repo_count, bool censor_names,
-              char censor_char) {
+              char censor_char, procutil::TrafficBudget* budget,
+              procutil::PipelineStats* pipeline) {
     // Determine which ANSI color codes to use based on options
     TuiColors colors = make_tui_colors(no_colors, custom_color, theme);
     std::ostringstream out;
@@ -329,7 +368,7 @@ void draw_tui(const std::vector<fs::path>& all_repos,
                          show_version, show_repo_count, status_msg, runtime_sec, show_datetime_line,
                          colors);
     out << render_stats(track_cpu, track_mem, track_threads, track_net, show_affinity, track_vmem,
-                        colors);
+                        colors, budget, pipeline);
     if (show_header) {
         // Draw table header with a fixed-width status column
         out << "--------------------------------------------------------------";
@@ -339,17 +378,10 @@ void draw_tui(const std::vector<fs::path>& all_repos,
         out << "--------------------------------------------------------------";
         out << "-------------------\n"; // Bottom border
     }
+    const RepoInfo pending{.message = "Pending..."};
     for (const auto& p : all_repos) {
-        RepoInfo ri;
         auto it = repo_infos.find(p);
-        if (it != repo_infos.end())
-            ri = it->second;
-        else {
-            ri.status = RS_PENDING;
-            ri.message = "Pending...";
-            ri.path = p;
-            ri.auth_failed = false;
-        }
+        const RepoInfo& ri = it != repo_infos.end() ? it->second : pending;
         out << render_repo_entry(p, ri, show_skipped, show_notgit, show_commit_date,
                                  show_commit_author, session_dates_only, censor_names, censor_char,
                                  colors);
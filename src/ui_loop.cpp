@@ -21,13 +21,16 @@
 #include <sstream>
 #include <cctype>
 #include <memory>
+#include <future>
+#include <numeric>
+#include <unordered_set>
 
 #include "scanner.hpp"
-#include "thread_compat.hpp"
 #include "arg_parser.hpp"
 #include "git_utils.hpp"
 #include "tui.hpp"
 #include "repo.hpp"
+#include "repo_state.hpp"
 #include "logger.hpp"
 #include "time_utils.hpp"
 #include "resource_utils.hpp"
@@ -35,12 +38,16 @@
 #include "version.hpp"
 #include "config_utils.hpp"
 #include "debug_utils.hpp"
+#include "due_scheduler.hpp"
 #include "parse_utils.hpp"
 #include "options.hpp"
 #include "help_text.hpp"
 #include "lock_utils.hpp"
 #include "file_watch.hpp"
 #include "linux_daemon.hpp"
+#include "traffic_budget.hpp"
+#include "mirror_cache.hpp"
+#include "worker_pool.hpp"
 #ifndef _WIN32
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -144,13 +151,10 @@ void draw_cli(const std::vector<fs::path>& all_repos,
     if (runtime_sec >= 0)
         std::cout << " - Runtime " << format_duration_short(std::chrono::seconds(runtime_sec));
     std::cout << "\n";
+    const RepoInfo pending{.message = "Pending..."};
     for (const auto& p : all_repos) {
-        RepoInfo ri;
         auto it = repo_infos.find(p);
-        if (it != repo_infos.end())
-            ri = it->second;
-        else
-            ri = RepoInfo{p, RS_PENDING, "Pending...", "", "", "", "", 0, "", 0, false, false};
+        const RepoInfo& ri = it != repo_infos.end() ? it->second : pending;
         if ((ri.status == RS_SKIPPED && !show_skipped) || (ri.status == RS_NOT_GIT && !show_notgit))
             continue;
         std::string name = p.filename().string();
@@ -213,6 +217,17 @@ static void setup_logging(const Options& opts) {
         init_syslog(opts.logging.syslog_facility);
 }
 
+// Append the paths of @a extra that @a repos lacks, keeping their order.
+// Membership is hashed, so merging a rescan stays linear with 100k+ repos.
+template <typename Paths>
+static void append_missing(std::vector<fs::path>& repos, const Paths& extra) {
+    std::unordered_set<fs::path, PathHash> known(repos.begin(), repos.end());
+    for (const auto& p : extra) {
+        if (known.insert(p).second)
+            repos.push_back(p);
+    }
+}
+
 // Build repository list and populate info table
 static void prepare_repos(const Options& opts, std::vector<fs::path>& all_repos,
                           std::map<fs::path, RepoInfo>& repo_infos) {
@@ -229,8 +244,124 @@ static void prepare_repos(const Options& opts, std::vector<fs::path>& all_repos,
                       [](const fs::path& a, const fs::path& b) { return path_less(b, a); });
     }
     for (const auto& p : all_repos)
-        repo_infos[p] =
-            RepoInfo{p, RS_PENDING, "Pending...", "", "", "", "", 0, "", 0, false, false};
+        repo_infos[p] = RepoInfo{.message = "Pending..."};
+}
+
+// Re-read the clone manifest and add its repositories to the list; they are
+// cloned by the next scan if missing. An unreadable manifest keeps the
+// previous entries. Returns the repositories it added.
+static std::vector<fs::path> merge_manifest(const Options& opts,
+                                            std::vector<ManifestEntry>& manifest,
+                                            std::vector<fs::path>& all_repos,
+                                            std::map<fs::path, RepoInfo>& repo_infos) {
+    if (opts.manifest.empty()) {
+        manifest.clear();
+        return {};
+    }
+    std::vector<ManifestEntry> loaded;
+    std::string err;
+    if (!load_manifest(opts.manifest.string(), opts.root, loaded, err)) {
+        if (logger_initialized())
+            log_error("Failed to load manifest: " + err);
+        else if (!opts.silent)
+            std::cerr << "Failed to load manifest: " << err << std::endl;
+        return {};
+    }
+    manifest = std::move(loaded);
+    std::vector<fs::path> paths;
+    paths.reserve(manifest.size());
+    for (const auto& entry : manifest)
+        paths.push_back(entry.path);
+    size_t before = all_repos.size();
+    append_missing(all_repos, paths);
+    if (all_repos.size() == before)
+        return {};
+    std::vector<fs::path> added(all_repos.begin() + before, all_repos.end());
+    for (const auto& p : added)
+        repo_infos[p] = RepoInfo{.message = "Pending..."};
+    if (opts.sort_mode == Options::ALPHA)
+        std::sort(all_repos.begin(), all_repos.end(), path_less);
+    else if (opts.sort_mode == Options::REVERSE)
+        std::sort(all_repos.begin(), all_repos.end(),
+                  [](const fs::path& a, const fs::path& b) { return path_less(b, a); });
+    return added;
+}
+
+// Fetch settings shared by every repository in a scan
+static git::FetchParams fetch_defaults_for(const Options& opts, procutil::TrafficBudget* budget,
+                                           git::MirrorCache* mirror) {
+    git::FetchParams params;
+    params.ls_remote_probe = opts.ls_remote;
+    params.tags = opts.fetch_tags;
+    params.single_branch = opts.single_branch;
+    params.prune = opts.prune;
+    params.depth = static_cast<int>(opts.fetch_depth);
+    if (budget->active())
+        params.traffic_budget = budget;
+    params.mirror = mirror;
+    return params;
+}
+
+static procutil::StageLimits stage_limits_for(const Options& opts) {
+    return {opts.limits.fetch_concurrency, opts.limits.checkout_concurrency,
+            opts.limits.hook_concurrency};
+}
+
+// Scan settings taken from the options; the caller attaches the shared state
+static ScanOptions scan_options_for(const Options& opts, size_t concurrency,
+                                    procutil::TrafficBudget* budget, git::MirrorCache* mirror) {
+    ScanOptions scan;
+    scan.include_private = opts.include_private;
+    scan.remote = opts.remote_name;
+    scan.log_dir = opts.logging.log_dir;
+    scan.check_only = opts.check_only;
+    scan.hash_check = opts.hash_check;
+    scan.concurrency = concurrency;
+    scan.cpu_percent_limit = opts.limits.cpu_percent_limit;
+    scan.mem_limit = opts.limits.mem_limit;
+    scan.down_limit = opts.limits.download_limit;
+    scan.up_limit = opts.limits.upload_limit;
+    scan.disk_limit = opts.limits.disk_limit;
+    scan.silent = opts.silent;
+    scan.cli_mode = opts.cli;
+    scan.dry_run = opts.dry_run;
+    scan.force_pull = opts.force_pull;
+    scan.skip_timeout = opts.limits.skip_timeout;
+    scan.skip_unavailable = opts.skip_unavailable;
+    scan.skip_accessible_errors = opts.skip_accessible_errors;
+    scan.post_pull_hook = opts.post_pull_hook;
+    scan.pull_ref = opts.pull_ref;
+    scan.updated_since = opts.updated_since;
+    scan.show_pull_author = opts.show_pull_author;
+    scan.pull_timeout = opts.limits.pull_timeout;
+    scan.retry_skipped = opts.retry_skipped;
+    scan.reset_skipped = opts.reset_skipped;
+    scan.repo_settings = opts.repo_settings;
+    scan.mutant_mode = opts.mutant_mode;
+    scan.fetch_defaults = fetch_defaults_for(opts, budget, mirror);
+    scan.need_commit_info = opts.cli || opts.show_commit_date || opts.show_commit_author ||
+                            opts.show_pull_author || opts.sort_mode == Options::UPDATED ||
+                            opts.updated_since.count() > 0;
+    scan.maintenance = {opts.pack_maintenance, opts.max_packs, opts.max_loose_objects};
+    scan.stages = stage_limits_for(opts);
+    scan.last_scan = opts.single_run;
+    return scan;
+}
+
+// One thread coordinates each scan, every stage worker has its own and pack
+// maintenance runs on one more between scans
+static size_t pool_size_for(const Options& opts, size_t concurrency) {
+    auto workers = stage_limits_for(opts).workers(concurrency);
+    size_t threads = std::accumulate(workers.begin(), workers.end(), size_t{1});
+    if (opts.pack_maintenance && !opts.dry_run)
+        ++threads;
+    return threads;
+}
+
+static std::unique_ptr<git::MirrorCache> make_mirror_cache(const Options& opts) {
+    if (opts.mirror_cache.empty())
+        return nullptr;
+    return std::make_unique<git::MirrorCache>(opts.mirror_cache, opts.mirror_alternates);
 }
 
 // Render either the TUI or CLI output
@@ -238,7 +369,8 @@ static void update_ui(const Options& opts, const std::vector<fs::path>& all_repo
                       const std::map<fs::path, RepoInfo>& repo_infos, int interval, int sec_left,
                       bool scanning, const std::string& act,
                       std::chrono::milliseconds& cli_countdown_ms, const std::string& message,
-                      int runtime_sec) {
+                      int runtime_sec, procutil::TrafficBudget* budget,
+                      procutil::PipelineStats* pipeline) {
     (void)cli_countdown_ms;
     if (!opts.silent && !opts.cli) {
         bool show_affinity = opts.limits.cpu_core_mask != 0;
@@ -248,14 +380,19 @@ static void update_ui(const Options& opts, const std::vector<fs::path>& all_repo
                  opts.show_commit_date, opts.show_commit_author, opts.session_dates_only,
                  opts.no_colors, opts.custom_color, opts.theme, message, runtime_sec,
                  opts.show_datetime_line, opts.show_header, opts.show_repo_count, opts.censor_names,
-                 opts.censor_char);
+                 opts.censor_char, budget, pipeline);
     }
 }
 int run_event_loop(Options opts) {
+    // libgit2 is initialised once by main() for the whole process; caches
+    // are trimmed after each scan instead of restarting the library.
     debugMemory = opts.debug_memory;
     dumpState = opts.dump_state;
     dumpThreshold = opts.dump_threshold;
     git::set_proxy(opts.proxy_url);
+    git::set_server_timeouts(opts.limits.pull_timeout);
+    git::set_status_cache(opts.status_cache);
+    git::apply_libgit2_options(opts.libgit2);
 #ifndef _WIN32
     if (opts.service.reattach) {
         int fd = procutil::connect_status_socket(opts.service.attach_name);
@@ -340,7 +477,9 @@ int run_event_loop(Options opts) {
         }
     }
     prepare_repos(opts, all_repos, repo_infos);
-    size_t valid_count = 0;
+    std::vector<ManifestEntry> manifest;
+    merge_manifest(opts, manifest, all_repos, repo_infos);
+    size_t valid_count = manifest.size(); // missing manifest repositories are cloned
     for (const auto& p : all_repos) {
         if (fs::is_directory(p) && git::is_git_repo(p)) {
             ++valid_count;
@@ -354,7 +493,8 @@ int run_event_loop(Options opts) {
                       << std::endl;
         std::this_thread::sleep_for(std::chrono::seconds(interval));
         prepare_repos(opts, all_repos, repo_infos);
-        valid_count = 0;
+        merge_manifest(opts, manifest, all_repos, repo_infos);
+        valid_count = manifest.size();
         for (const auto& p : all_repos) {
             if (fs::is_directory(p) && git::is_git_repo(p))
                 ++valid_count;
@@ -380,6 +520,9 @@ int run_event_loop(Options opts) {
         std::cout << std::endl;
     }
     std::set<fs::path> skip_repos;
+    procutil::TrafficBudget traffic_budget(opts.limits.cycle_traffic_limit,
+                                           opts.limits.total_traffic_limit);
+    std::unique_ptr<git::MirrorCache> mirror_cache = make_mirror_cache(opts);
     std::mutex mtx;
     std::atomic<bool> scanning(false);
     std::atomic<bool> running(true);
@@ -390,7 +533,7 @@ int run_event_loop(Options opts) {
 #ifndef _WIN32
     std::signal(SIGTERM, handle_signal);
 #endif
-    th_compat::jthread scan_thread;
+    std::future<void> scan_done;
     std::chrono::steady_clock::time_point scan_start;
     std::chrono::milliseconds countdown_ms(0);
     std::chrono::milliseconds cli_countdown_ms(0);
@@ -438,6 +581,22 @@ int run_event_loop(Options opts) {
     size_t concurrency = opts.limits.concurrency;
     if (opts.limits.max_threads > 0 && concurrency > opts.limits.max_threads)
         concurrency = opts.limits.max_threads;
+    // The threads are reused by every cycle
+    procutil::WorkerPool pool(pool_size_for(opts, concurrency));
+    procutil::PipelineStats pipeline_stats;
+    RepoStateTable repo_states;
+    // Host windows, retry timers and remote URLs learned by earlier scans
+    ScanState scan_state;
+    // Copy of repo_infos the display renders from; each frame copies only
+    // the entries that changed
+    RepoView repo_view;
+    // With --adaptive-interval every repository has its own due time and a
+    // scan starts as soon as the earliest one arrives
+    procutil::DueScheduler due_sched(opts.min_interval, opts.max_interval);
+    auto adaptive = [&]() { return opts.adaptive_interval && !opts.single_run; };
+    // Scheduled scans are short, so the cycle traffic budget refills once
+    // per poll interval rather than with every scan
+    auto budget_cycle_start = start_time;
 #ifndef _WIN32
     int status_fd = -1;
     std::vector<int> status_clients;
@@ -460,9 +619,6 @@ int run_event_loop(Options opts) {
                 for (auto& s : args)
                     argv.push_back(s.data());
                 Options new_opts = parse_options(static_cast<int>(argv.size()), argv.data());
-                if (new_opts.limits.pull_timeout.count() > 0)
-                    git::set_libgit_timeout(
-                        static_cast<unsigned int>(new_opts.limits.pull_timeout.count()));
                 {
                     std::lock_guard<std::mutex> lk(mtx);
                     opts = new_opts;
@@ -473,23 +629,33 @@ int run_event_loop(Options opts) {
                     first_validated.clear();
                     first_cycle = true;
                 }
+                repo_states.touch_all();
                 interval = opts.interval;
                 concurrency = opts.limits.concurrency;
                 if (opts.limits.max_threads > 0 && concurrency > opts.limits.max_threads)
                     concurrency = opts.limits.max_threads;
+                pool.resize(pool_size_for(opts, concurrency));
                 rescan_countdown_ms =
                     opts.rescan_new ? opts.rescan_interval : std::chrono::milliseconds(0);
                 setup_environment(opts);
+                git::set_server_timeouts(opts.limits.pull_timeout);
+                git::set_status_cache(opts.status_cache);
+                git::apply_libgit2_options(opts.libgit2);
+                mirror_cache = make_mirror_cache(opts);
+                traffic_budget.set_limits(opts.limits.cycle_traffic_limit,
+                                          opts.limits.total_traffic_limit);
+                due_sched.set_bounds(opts.min_interval, opts.max_interval);
             } catch (const std::exception& e) {
                 log_error(std::string("Failed to reload config: ") + e.what());
             }
         }
+        if (adaptive() && now - budget_cycle_start >= std::chrono::seconds(interval)) {
+            traffic_budget.begin_cycle();
+            budget_cycle_start = now;
+        }
         if (scanning && poll_timed_out(opts, scan_start, now)) {
             log_error("Polling exceeded timeout; terminating worker");
             running = false;
-#if defined(__cpp_lib_jthread)
-            scan_thread.request_stop();
-#endif
             break;
         }
         if (now - last_loop > std::chrono::minutes(10)) {
@@ -516,10 +682,8 @@ int run_event_loop(Options opts) {
             }
         }
 #endif
-        if (!scanning && scan_thread.joinable()) {
-            scan_thread.join();
-            git_libgit2_shutdown();
-            git_libgit2_init();
+        if (!scanning && scan_done.valid()) {
+            scan_done.get();
             if (first_cycle) {
                 if (opts.keep_first_valid) {
                     for (const auto& [p, info] : repo_infos) {
@@ -550,19 +714,24 @@ int run_event_loop(Options opts) {
             }
             if (opts.single_run)
                 running = false;
+            if (adaptive()) {
+                auto wait = std::clamp<std::chrono::steady_clock::duration>(
+                    due_sched.next_due(all_repos, now) - now, std::chrono::seconds(0),
+                    due_sched.max_interval());
+                countdown_ms = std::chrono::duration_cast<std::chrono::milliseconds>(wait);
+            }
         }
         if (running && countdown_ms <= std::chrono::milliseconds(0) && !scanning) {
+            // Entries written here are marked one by one, so the display
+            // copies only those instead of the whole map
+            std::vector<fs::path> touched;
             if (opts.rescan_new && rescan_countdown_ms <= std::chrono::milliseconds(0)) {
                 std::vector<fs::path> roots{opts.root};
                 roots.insert(roots.end(), opts.include_dirs.begin(), opts.include_dirs.end());
                 auto new_repos =
                     build_repo_list(roots, opts.recursive_scan, opts.ignore_dirs, opts.max_depth);
-                if (opts.keep_first_valid) {
-                    for (const auto& p : first_validated) {
-                        if (std::find(new_repos.begin(), new_repos.end(), p) == new_repos.end())
-                            new_repos.push_back(p);
-                    }
-                }
+                if (opts.keep_first_valid)
+                    append_missing(new_repos, first_validated);
                 if (opts.sort_mode == Options::ALPHA)
                     std::sort(new_repos.begin(), new_repos.end(), path_less);
                 else if (opts.sort_mode == Options::REVERSE)
@@ -571,16 +740,13 @@ int run_event_loop(Options opts) {
                 {
                     std::lock_guard<std::mutex> lk(mtx);
                     for (const auto& p : new_repos) {
-                        if (!repo_infos.count(p))
-                            repo_infos[p] =
-                                RepoInfo{p,  RS_PENDING, "Pending...", "", "",    "",
-                                         "", 0,          "",           0,  false, false};
+                        if (!repo_infos.count(p)) {
+                            repo_infos[p] = RepoInfo{.message = "Pending..."};
+                            touched.push_back(p);
+                        }
                     }
                 }
-                for (const auto& p : new_repos) {
-                    if (std::find(all_repos.begin(), all_repos.end(), p) == all_repos.end())
-                        all_repos.push_back(p);
-                }
+                append_missing(all_repos, new_repos);
                 if (opts.sort_mode == Options::ALPHA)
                     std::sort(all_repos.begin(), all_repos.end(), path_less);
                 else if (opts.sort_mode == Options::REVERSE)
@@ -588,6 +754,11 @@ int run_event_loop(Options opts) {
                               [](const fs::path& a, const fs::path& b) { return path_less(b, a); });
                 rescan_countdown_ms = opts.rescan_interval;
             }
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                auto added = merge_manifest(opts, manifest, all_repos, repo_infos);
+                touched.insert(touched.end(), added.begin(), added.end());
+            }
             {
                 std::lock_guard<std::mutex> lk(mtx);
                 for (auto& [p, info] : repo_infos) {
@@ -596,29 +767,35 @@ int run_event_loop(Options opts) {
                             std::cerr << "Manually clearing stale busy state for " << p << "\n";
                         info.status = RS_PENDING;
                         info.message = "Pending...";
+                        touched.push_back(p);
                     }
                 }
             }
+            for (const auto& p : touched)
+                repo_states.touch(p);
             scanning = true;
             scan_start = std::chrono::steady_clock::now();
-            scan_thread = th_compat::jthread(
-                scan_repos, std::cref(all_repos), std::ref(repo_infos), std::ref(skip_repos),
-                std::ref(mtx), std::ref(scanning), std::ref(running), std::ref(current_action),
-                std::ref(action_mtx), opts.include_private, opts.remote_name,
-                std::cref(opts.logging.log_dir), opts.check_only, opts.hash_check, concurrency,
-                opts.limits.cpu_percent_limit, opts.limits.mem_limit, opts.limits.download_limit,
-                opts.limits.upload_limit, opts.limits.disk_limit, opts.silent, opts.cli,
-                opts.dry_run, opts.force_pull, opts.limits.skip_timeout, opts.skip_unavailable,
-                opts.skip_accessible_errors, opts.post_pull_hook, opts.pull_ref, opts.updated_since,
-                opts.show_pull_author, opts.limits.pull_timeout, opts.retry_skipped,
-                opts.reset_skipped, opts.repo_settings, opts.mutant_mode);
+            ScanOptions scan =
+                scan_options_for(opts, concurrency, &traffic_budget, mirror_cache.get());
+            scan.manifest = manifest;
+            scan.pool = &pool;
+            scan.pipeline_stats = &pipeline_stats;
+            scan.states = &repo_states;
+            scan.due = adaptive() ? &due_sched : nullptr;
+            scan.state = &scan_state;
+            scan_done = pool.submit([&, scan = std::move(scan)] {
+                scan_repos(all_repos, repo_infos, skip_repos, mtx, scanning, running,
+                           current_action, action_mtx, scan);
+            });
             countdown_ms = std::chrono::seconds(interval);
         }
 #ifndef _WIN32
         std::string status_msg;
 #endif
         {
-            std::lock_guard<std::mutex> lk(mtx);
+            // Render from a snapshot so workers publishing results never
+            // wait for the terminal
+            repo_view.refresh(repo_states, repo_infos, mtx);
             int sec_left =
                 (int)std::chrono::duration_cast<std::chrono::seconds>(countdown_ms).count();
             if (sec_left < 0)
@@ -631,8 +808,9 @@ int run_event_loop(Options opts) {
 #ifndef _WIN32
             status_msg = act + "\n";
 #endif
-            update_ui(opts, all_repos, repo_infos, interval, sec_left, scanning, act,
-                      cli_countdown_ms, user_message, opts.show_runtime ? runtime_sec : -1);
+            update_ui(opts, all_repos, repo_view.infos(), interval, sec_left, scanning, act,
+                      cli_countdown_ms, user_message, opts.show_runtime ? runtime_sec : -1,
+                      &traffic_budget, &pipeline_stats);
         }
 #if defined(_WIN32)
         if (opts.enable_hotkeys && !opts.cli && _kbhit()) {
@@ -745,11 +923,8 @@ int run_event_loop(Options opts) {
         }
     }
     running = false;
-    if (scan_thread.joinable()) {
-        scan_thread.join();
-        git_libgit2_shutdown();
-        git_libgit2_init();
-    }
+    if (scan_done.valid())
+        scan_done.wait();
     if (logger_initialized())
         log_info("Program exiting");
     shutdown_logger();
@@ -0,0 +1,155 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace procutil {
+
+namespace {
+// Pool and worker the calling thread belongs to, if any
+thread_local const void* tls_pool = nullptr;
+thread_local void* tls_worker = nullptr;
+} // namespace
+
+WorkerPool::WorkerPool(size_t threads) { resize(threads); }
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& w : workers_) {
+        if (w->thread.joinable())
+            w->thread.join();
+    }
+    for (auto& w : retired_) {
+        if (w->thread.joinable())
+            w->thread.join();
+    }
+}
+
+void WorkerPool::resize(size_t threads) {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        requested_ = std::max<size_t>(threads, 1);
+    }
+    apply_size();
+}
+
+WorkerPool::Reservation WorkerPool::reserve(size_t threads) {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        floors_.insert(threads);
+    }
+    apply_size();
+    return Reservation(this, threads);
+}
+
+void WorkerPool::unreserve(size_t threads) {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        floors_.erase(floors_.find(threads));
+    }
+    apply_size();
+}
+
+void WorkerPool::apply_size() {
+    std::vector<std::unique_ptr<Worker>> exited;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        size_t threads = floors_.empty() ? requested_ : std::max(requested_, *floors_.rbegin());
+        while (workers_.size() < threads) {
+            workers_.push_back(std::make_unique<Worker>());
+            Worker* w = workers_.back().get();
+            w->thread = std::thread([this, w]() { run(w); });
+        }
+        while (workers_.size() > threads) {
+            std::unique_ptr<Worker> w = std::move(workers_.back());
+            workers_.pop_back();
+            w->retire = true;
+            for (auto& task : w->tasks)
+                workers_[next_++ % workers_.size()]->tasks.push_back(std::move(task));
+            w->tasks.clear();
+            retired_.push_back(std::move(w));
+        }
+        // Workers removed earlier are joined once they have returned
+        for (auto it = retired_.begin(); it != retired_.end();) {
+            if ((*it)->exited) {
+                exited.push_back(std::move(*it));
+                it = retired_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    cv_.notify_all();
+    for (auto& w : exited)
+        w->thread.join();
+}
+
+size_t WorkerPool::size() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return workers_.size();
+}
+
+std::future<void> WorkerPool::submit(std::function<void()> task) {
+    auto job = std::make_shared<std::packaged_task<void()>>(std::move(task));
+    std::future<void> done = job->get_future();
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        Worker* target = nullptr;
+        if (tls_pool == this)
+            target = static_cast<Worker*>(tls_worker);
+        if (!target || target->retire)
+            target = workers_[next_++ % workers_.size()].get();
+        target->tasks.emplace_back([job]() { (*job)(); });
+        ++queued_;
+    }
+    cv_.notify_one();
+    return done;
+}
+
+bool WorkerPool::take(Worker* self, std::function<void()>& task) {
+    if (!self->tasks.empty()) {
+        task = std::move(self->tasks.back());
+        self->tasks.pop_back();
+        return true;
+    }
+    // Steal the oldest task of the next busy worker
+    auto it = std::find_if(workers_.begin(), workers_.end(),
+                           [self](const auto& w) { return w.get() == self; });
+    size_t start = it == workers_.end() ? 0 : static_cast<size_t>(it - workers_.begin());
+    for (size_t i = 1; i <= workers_.size(); ++i) {
+        Worker* victim = workers_[(start + i) % workers_.size()].get();
+        if (victim != self && !victim->tasks.empty()) {
+            task = std::move(victim->tasks.front());
+            victim->tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::run(Worker* self) {
+    tls_pool = this;
+    tls_worker = self;
+    std::unique_lock<std::mutex> lk(mtx_);
+    for (;;) {
+        cv_.wait(lk, [&]() { return self->retire || stop_ || queued_ > 0; });
+        if (self->retire || (stop_ && queued_ == 0))
+            break;
+        std::function<void()> task;
+        if (!take(self, task))
+            continue;
+        --queued_;
+        lk.unlock();
+        task(); // exceptions end up in the task's future
+        lk.lock();
+    }
+    tls_pool = nullptr;
+    tls_worker = nullptr;
+    self->exited = true;
+}
+
+} // namespace procutil
@@ -234,3 +234,51 @@ TEST_CASE("JSON type mismatch is reported") {
     REQUIRE(err.find("interval") != std::string::npos);
     FS_REMOVE(cfg);
 }
+
+TEST_CASE("YAML manifest loading") {
+    fs::path cfg = fs::temp_directory_path() / "manifest.yaml";
+    {
+        std::ofstream ofs(cfg);
+        ofs << "repositories:\n"
+               "  - url: https://github.com/org/tool.git\n"
+               "  - url: git@github.com:org/lib.git\n"
+               "    path: vendor/lib\n"
+               "    branch: stable\n"
+               "    depth: 1\n";
+    }
+    std::vector<ManifestEntry> entries;
+    std::string err;
+    REQUIRE(load_manifest(cfg.string(), "/srv/repos", entries, err));
+    REQUIRE(entries.size() == 2);
+    REQUIRE(entries[0].path == fs::path("/srv/repos") / "tool");
+    REQUIRE(entries[0].branch.empty());
+    REQUIRE(entries[0].depth == 0);
+    REQUIRE(entries[1].url == "git@github.com:org/lib.git");
+    REQUIRE(entries[1].path == fs::path("/srv/repos") / "vendor/lib");
+    REQUIRE(entries[1].branch == "stable");
+    REQUIRE(entries[1].depth == 1);
+    FS_REMOVE(cfg);
+}
+
+TEST_CASE("JSON manifest errors are reported") {
+    fs::path cfg = fs::temp_directory_path() / "manifest.json";
+    {
+        std::ofstream ofs(cfg);
+        ofs << "{\n  \"repositories\": [\n    {\"url\": \"https://github.com/org/a\", "
+               "\"path\": \"/abs/a\"},\n    {\"path\": \"b\"}\n  ]\n}";
+    }
+    std::vector<ManifestEntry> entries;
+    std::string err;
+    REQUIRE_FALSE(load_manifest(cfg.string(), "/srv/repos", entries, err));
+    REQUIRE(err.find("url") != std::string::npos);
+    {
+        std::ofstream ofs(cfg);
+        ofs << "{\n  \"repositories\": [\n    {\"url\": \"https://github.com/org/a\", "
+               "\"path\": \"/abs/a\", \"depth\": 2}\n  ]\n}";
+    }
+    REQUIRE(load_manifest(cfg.string(), "/srv/repos", entries, err));
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].path == fs::path("/abs/a"));
+    REQUIRE(entries[0].depth == 2);
+    FS_REMOVE(cfg);
+}
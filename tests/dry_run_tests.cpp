@@ -43,10 +43,11 @@ TEST_CASE("scan_repos honors dry run") {
     std::string action;
     std::mutex action_mtx;
 
-    scan_repos(repos, infos, skip, mtx, scanning, running, action, action_mtx, false, "origin",
-               fs::path(), false, true, 1, 0, 0, 0, 0, 0, false, false, true, false, false, false,
-               false, fs::path(), std::nullopt, std::chrono::seconds(0), false,
-               std::chrono::seconds(0), false, false, {}, false);
+    ScanOptions scan;
+    scan.dry_run = true;
+    scan.skip_timeout = false;
+    scan.skip_unavailable = false;
+    scan_repos(repos, infos, skip, mtx, scanning, running, action, action_mtx, scan);
 
     REQUIRE(infos[repo].status != RS_PULL_OK);
     std::string local_hash = git::get_local_hash(repo).value_or("");
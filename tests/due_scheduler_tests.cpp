@@ -0,0 +1,64 @@
+#include "test_common.hpp"
+#include "due_scheduler.hpp"
+
+using procutil::DueScheduler;
+using Upstream = DueScheduler::Upstream;
+
+TEST_CASE("due scheduler spreads first checks over the minimum interval") {
+    DueScheduler due(std::chrono::seconds(60), std::chrono::seconds(600));
+    auto now = DueScheduler::clock::now();
+    std::vector<fs::path> repos;
+    for (int i = 0; i < 100; ++i)
+        repos.push_back("repo" + std::to_string(i));
+    size_t first_half = 0;
+    for (const auto& p : repos) {
+        auto at = due.due_at(p, now);
+        REQUIRE(at >= now);
+        REQUIRE(at < now + std::chrono::seconds(60));
+        if (at < now + std::chrono::seconds(30))
+            ++first_half;
+    }
+    REQUIRE(first_half > 0);
+    REQUIRE(first_half < repos.size());
+    REQUIRE(due.next_due(repos, now) < now + std::chrono::seconds(60));
+    // Asking again does not move a repository
+    REQUIRE(due.due_at(repos[0], now + std::chrono::seconds(5)) == due.due_at(repos[0], now));
+}
+
+TEST_CASE("due scheduler learns intervals from upstream changes") {
+    DueScheduler due(std::chrono::seconds(10), std::chrono::seconds(100));
+    auto now = DueScheduler::clock::now();
+    fs::path quiet = "quiet";
+    fs::path busy = "busy";
+    REQUIRE(due.interval(quiet) == std::chrono::seconds(10));
+    for (int i = 0; i < 20; ++i) {
+        due.checked(quiet, Upstream::Unchanged, now);
+        due.checked(busy, Upstream::Changed, now);
+    }
+    REQUIRE(due.interval(quiet) == std::chrono::seconds(100));
+    REQUIRE(due.interval(busy) == std::chrono::seconds(10));
+    // The next check is about one interval away
+    REQUIRE(due.due_at(quiet, now) >= now + std::chrono::seconds(90));
+    REQUIRE(due.due_at(quiet, now) <= now + std::chrono::seconds(110));
+    // Failures teach nothing
+    due.checked(quiet, Upstream::Unknown, now);
+    REQUIRE(due.interval(quiet) == std::chrono::seconds(100));
+    due.checked(quiet, Upstream::Changed, now);
+    REQUIRE(due.interval(quiet) == std::chrono::seconds(50));
+    due.set_bounds(std::chrono::seconds(5), std::chrono::seconds(20));
+    REQUIRE(due.interval(quiet) == std::chrono::seconds(20));
+}
+
+TEST_CASE("due scheduler postpones started and deferred repositories") {
+    DueScheduler due(std::chrono::seconds(30), std::chrono::seconds(300));
+    auto now = DueScheduler::clock::now();
+    due.started("a", now);
+    REQUIRE(due.due_at("a", now) == now + std::chrono::seconds(30));
+    due.defer("a", now + std::chrono::seconds(100));
+    REQUIRE(due.due_at("a", now) == now + std::chrono::seconds(100));
+    // Deferring never brings a check forward
+    due.defer("a", now + std::chrono::seconds(1));
+    REQUIRE(due.due_at("a", now) == now + std::chrono::seconds(100));
+    due.retain({"b"});
+    REQUIRE(due.due_at("a", now) < now + std::chrono::seconds(30));
+}
@@ -0,0 +1,259 @@
+#include <chrono>
+#include <string>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "test_common.hpp"
+
+// Create a bare remote holding one commit on master and a local clone of it.
+static void make_remote(const std::string& name, fs::path& repo, fs::path& remote) {
+    auto suffix = std::to_string(static_cast<unsigned long long>(
+        std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+    remote = fs::temp_directory_path() / (name + "_remote_" + suffix + ".git");
+    repo = fs::temp_directory_path() / (name + "_local_" + suffix);
+    FS_REMOVE_ALL(remote);
+    FS_REMOVE_ALL(repo);
+    REQUIRE(std::system(("git init --bare " + remote.string() + REDIR).c_str()) == 0);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + repo.string() + REDIR).c_str()) ==
+            0);
+    (void)std::system(
+        (std::string("git -C ") + repo.string() + " config user.email you@example.com").c_str());
+    (void)std::system((std::string("git -C ") + repo.string() + " config user.name tester").c_str());
+    std::ofstream(repo / "file.txt") << "hello";
+    (void)std::system((std::string("git -C ") + repo.string() + " add file.txt").c_str());
+    (void)std::system((std::string("git -C ") + repo.string() + " commit -m init" REDIR).c_str());
+    REQUIRE(std::system(
+                (std::string("git -C ") + repo.string() + " push origin master" + REDIR).c_str()) ==
+            0);
+}
+
+// Point @a count extra branches and tags of the bare remote at its master tip.
+static void add_refs(const fs::path& remote, int count, const std::string& prefix) {
+    git_repository* raw = nullptr;
+    REQUIRE(git_repository_open(&raw, remote.string().c_str()) == 0);
+    git::repo_ptr bare(raw);
+    git_oid tip;
+    REQUIRE(git_reference_name_to_id(&tip, bare.get(), "refs/heads/master") == 0);
+    for (int i = 0; i < count; ++i) {
+        for (const char* ns : {"refs/heads/", "refs/tags/"}) {
+            std::string name = ns + prefix + std::to_string(i);
+            git_reference* ref = nullptr;
+            REQUIRE(git_reference_create(&ref, bare.get(), name.c_str(), &tip, 1, nullptr) == 0);
+            git_reference_free(ref);
+        }
+    }
+}
+
+static bool has_ref(const fs::path& repo, const std::string& name) {
+    git_repository* raw = nullptr;
+    if (git_repository_open(&raw, repo.string().c_str()) != 0)
+        return false;
+    git::repo_ptr r(raw);
+    git_oid oid;
+    return git_reference_name_to_id(&oid, r.get(), name.c_str()) == 0;
+}
+
+TEST_CASE("single-branch fetch leaves other refs untouched") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo, remote;
+    make_remote("narrow_fetch", repo, remote);
+    add_refs(remote, 3, "extra-");
+
+    git::FetchParams narrow;
+    narrow.single_branch = true;
+    narrow.tags = TagPolicy::None;
+    {
+        git::RepoSession session(repo);
+        const git::FetchResult& res = session.fetch("origin", "master", narrow);
+        REQUIRE(res.ok);
+        REQUIRE(res.refspecs.size() == 1);
+        REQUIRE(res.remote_hash == git::get_local_hash(repo).value_or(""));
+        // A full fetch is not satisfied by the narrow result
+        const git::FetchResult& full = session.fetch("origin", "master");
+        REQUIRE(full.refspecs.empty());
+    }
+    REQUIRE(has_ref(repo, "refs/remotes/origin/extra-0"));
+    REQUIRE(has_ref(repo, "refs/tags/extra-0"));
+
+    add_refs(remote, 3, "later-");
+    {
+        git::RepoSession session(repo);
+        REQUIRE(session.fetch("origin", "master", narrow).ok);
+    }
+    REQUIRE_FALSE(has_ref(repo, "refs/remotes/origin/later-0"));
+    REQUIRE_FALSE(has_ref(repo, "refs/tags/later-0"));
+
+    std::string log;
+    {
+        git::RepoSession session(repo);
+        const std::string target = "later-1";
+        REQUIRE(git::try_pull(session, "origin", log, narrow, false, &target) == 0);
+    }
+    REQUIRE(has_ref(repo, "refs/tags/later-1"));
+    REQUIRE_FALSE(has_ref(repo, "refs/tags/later-2"));
+
+    FS_REMOVE_ALL(repo);
+    FS_REMOVE_ALL(remote);
+}
+
+TEST_CASE("prune removes deleted remote branches") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo, remote;
+    make_remote("prune_fetch", repo, remote);
+    add_refs(remote, 1, "gone-");
+    {
+        git::RepoSession session(repo);
+        REQUIRE(session.fetch("origin", "master").ok);
+    }
+    REQUIRE(has_ref(repo, "refs/remotes/origin/gone-0"));
+    REQUIRE(std::system(
+                (std::string("git -C ") + remote.string() + " branch -D gone-0" + REDIR).c_str()) ==
+            0);
+
+    git::FetchParams params;
+    params.prune = true;
+    {
+        git::RepoSession session(repo);
+        REQUIRE(session.fetch("origin", "master", params).ok);
+    }
+    REQUIRE_FALSE(has_ref(repo, "refs/remotes/origin/gone-0"));
+
+    FS_REMOVE_ALL(repo);
+    FS_REMOVE_ALL(remote);
+}
+
+#if !defined(_WIN32) &&                                                                           \
+    (LIBGIT2_VER_MAJOR > 1 || (LIBGIT2_VER_MAJOR == 1 && LIBGIT2_VER_MINOR >= 7))
+// Serve the repositories under @a base over git://. Shallow fetches need a
+// smart transport; libgit2's local transport refuses them.
+struct GitDaemon {
+    fs::path pid_file;
+    int port = 0;
+
+    explicit GitDaemon(const fs::path& base) {
+        port = 20000 + static_cast<int>(getpid() % 20000);
+        pid_file = base / "daemon.pid";
+        std::string cmd = "git daemon --reuseaddr --export-all --detach --listen=127.0.0.1"
+                          " --port=" +
+                          std::to_string(port) + " --base-path=" + base.string() +
+                          " --pid-file=" + pid_file.string() + REDIR;
+        if (std::system(cmd.c_str()) != 0)
+            port = 0;
+    }
+    ~GitDaemon() {
+        std::ifstream in(pid_file);
+        pid_t pid = 0;
+        if (in >> pid && pid > 0)
+            kill(pid, SIGTERM);
+    }
+    std::string url(const std::string& name) const {
+        return "git://127.0.0.1:" + std::to_string(port) + "/" + name;
+    }
+    // Wait until @a name can be listed, up to five seconds
+    bool ready(const std::string& name) const {
+        for (int i = 0; port != 0 && i < 50; ++i) {
+            if (std::system(("git ls-remote " + url(name) + REDIR).c_str()) == 0)
+                return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        return false;
+    }
+};
+
+TEST_CASE("shallow pull of a rewritten upstream stays shallow") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path src, remote;
+    make_remote("shallow", src, remote);
+    GitDaemon daemon(remote.parent_path());
+    std::string name = remote.filename().string();
+    if (!daemon.ready(name)) {
+        WARN("git daemon not available; skipping");
+        FS_REMOVE_ALL(src);
+        FS_REMOVE_ALL(remote);
+        return;
+    }
+    fs::path repo = src.string() + "_shallow";
+    FS_REMOVE_ALL(repo);
+    REQUIRE(std::system(("git clone --depth 1 " + daemon.url(name) + " " + repo.string() + REDIR)
+                            .c_str()) == 0);
+    REQUIRE(fs::exists(repo / ".git" / "shallow"));
+
+    // Replace the upstream history with an unrelated, longer one
+    (void)std::system(("git -C " + src.string() + " checkout --orphan rewrite" REDIR).c_str());
+    for (int i = 0; i < 40; ++i)
+        (void)std::system(("git -C " + src.string() + " commit --allow-empty -m r" +
+                           std::to_string(i) + REDIR)
+                              .c_str());
+    REQUIRE(std::system(
+                ("git -C " + src.string() + " push -f origin rewrite:master" REDIR).c_str()) == 0);
+    std::string tip = git::get_local_hash(src).value_or("");
+
+    git::RepoSession session(repo);
+    git::FetchParams params;
+    params.depth = 1;
+    std::string log;
+    REQUIRE(git::try_pull(session, "origin", log, params) == 0);
+    REQUIRE(log == "Reset to remote");
+    REQUIRE(git::get_local_hash(repo).value_or("") == tip);
+    // Deepening stopped at its cap instead of fetching the whole history
+    git_repository* raw = nullptr;
+    REQUIRE(git_repository_open(&raw, repo.string().c_str()) == 0);
+    git::repo_ptr r(raw);
+    REQUIRE(git_repository_is_shallow(r.get()) == 1);
+    git_revwalk* raw_walk = nullptr;
+    REQUIRE(git_revwalk_new(&raw_walk, r.get()) == 0);
+    git::revwalk_ptr walk(raw_walk);
+    git_oid oid;
+    REQUIRE(git_oid_fromstr(&oid, tip.c_str()) == 0);
+    REQUIRE(git_revwalk_push(walk.get(), &oid) == 0);
+    int commits = 0;
+    while (git_revwalk_next(&oid, walk.get()) == 0)
+        ++commits;
+    REQUIRE(commits < 40);
+
+    FS_REMOVE_ALL(repo);
+    FS_REMOVE_ALL(src);
+    FS_REMOVE_ALL(remote);
+}
+#endif
+
+TEST_CASE("fetch policy ref update cost", "[!benchmark]") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo, remote;
+    make_remote("fetch_bench", repo, remote);
+    add_refs(remote, 2000, "ref-");
+
+    git::FetchParams narrow;
+    narrow.single_branch = true;
+    narrow.tags = TagPolicy::None;
+    {
+        git::RepoSession warm(repo);
+        REQUIRE(warm.fetch("origin", "master").ok);
+    }
+
+    BENCHMARK("default refspecs, all tags") {
+        git::RepoSession session(repo);
+        return session.fetch("origin", "master").ok;
+    };
+    BENCHMARK("single branch, no tags") {
+        git::RepoSession session(repo);
+        return session.fetch("origin", "master", narrow).ok;
+    };
+
+    FS_REMOVE_ALL(repo);
+    FS_REMOVE_ALL(remote);
+}
@@ -4,6 +4,7 @@
 #include "test_common.hpp"
 #include "options.hpp"
 #include "mutant_mode.hpp"
+#include "remote_head_cache.hpp"
 
 static std::string run_cmd(const std::string& cmd) {
     std::array<char, 128> buffer{};
@@ -98,6 +99,313 @@ TEST_CASE("get_remote_commit_time handles authentication options") {
     FS_REMOVE_ALL(remote);
 }
 
+TEST_CASE("RepoSession fetches a remote once per session") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo, remote;
+    std::string hash;
+    std::time_t ctime;
+    setup_repo(repo, remote, hash, ctime);
+
+    fs::path other = repo.string() + "_other";
+    FS_REMOVE_ALL(other);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + other.string() + REDIR).c_str()) == 0);
+    (void)std::system((std::string("git -C ") + other.string() + " config user.email you@example.com").c_str());
+    (void)std::system((std::string("git -C ") + other.string() + " config user.name tester").c_str());
+
+    git::RepoSession session(repo);
+    REQUIRE(session.last_fetch() == nullptr);
+    const git::FetchResult& first = session.fetch("origin", "master");
+    REQUIRE(first.ok);
+    REQUIRE(first.remote_hash == hash);
+    REQUIRE(first.remote_commit_time == ctime);
+
+    std::ofstream(other / "file.txt") << "update";
+    (void)std::system((std::string("git -C ") + other.string() + " commit -am update" REDIR).c_str());
+    REQUIRE(std::system((std::string("git -C ") + other.string() + " push origin master" + REDIR).c_str()) == 0);
+
+    const git::FetchResult& second = session.fetch("origin", "master");
+    REQUIRE(&second == &first);
+    REQUIRE(second.remote_hash == hash);
+
+    std::string log;
+    REQUIRE(git::try_pull(session, "origin", log, git::FetchParams{}) == 0);
+    REQUIRE(log == "Already up to date");
+
+    git::RepoSession fresh(repo);
+    REQUIRE(git::try_pull(fresh, "origin", log, git::FetchParams{}) == 0);
+    REQUIRE(log == "Fast-forwarded");
+    REQUIRE(fresh.last_fetch()->remote_hash != hash);
+
+    FS_REMOVE_ALL(other);
+    FS_REMOVE_ALL(repo);
+    FS_REMOVE_ALL(remote);
+}
+
+TEST_CASE("ls-remote probe skips unchanged fetches") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo, remote;
+    std::string hash;
+    std::time_t ctime;
+    setup_repo(repo, remote, hash, ctime);
+
+    git::FetchParams params;
+    params.ls_remote_probe = true;
+    {
+        git::RepoSession session(repo);
+        const git::FetchResult& res = session.fetch("origin", "master", params);
+        REQUIRE(res.ok);
+        REQUIRE(res.fetch_skipped);
+        REQUIRE(res.remote_hash == hash);
+        REQUIRE(res.remote_commit_time == ctime);
+    }
+
+    fs::path other = repo.string() + "_other";
+    FS_REMOVE_ALL(other);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + other.string() + REDIR).c_str()) == 0);
+    (void)std::system((std::string("git -C ") + other.string() + " config user.email you@example.com").c_str());
+    (void)std::system((std::string("git -C ") + other.string() + " config user.name tester").c_str());
+    std::ofstream(other / "file.txt") << "update";
+    (void)std::system((std::string("git -C ") + other.string() + " commit -am update" REDIR).c_str());
+    REQUIRE(std::system((std::string("git -C ") + other.string() + " push origin master" + REDIR).c_str()) == 0);
+    std::string new_hash = git::get_local_hash(other).value_or("");
+
+    {
+        git::RepoSession session(repo);
+        const git::FetchResult& res = session.fetch("origin", "master", params);
+        REQUIRE(res.ok);
+        REQUIRE_FALSE(res.fetch_skipped);
+        REQUIRE(res.remote_hash == new_hash);
+    }
+
+    FS_REMOVE_ALL(other);
+    FS_REMOVE_ALL(repo);
+    FS_REMOVE_ALL(remote);
+}
+
+TEST_CASE("remote heads are listed once per URL per cycle") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo, remote;
+    std::string hash;
+    std::time_t ctime;
+    setup_repo(repo, remote, hash, ctime);
+    fs::path dup = repo.string() + "_dup";
+    fs::path other = repo.string() + "_other";
+    FS_REMOVE_ALL(dup);
+    FS_REMOVE_ALL(other);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + dup.string() + REDIR).c_str()) == 0);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + other.string() + REDIR).c_str()) == 0);
+
+    git::RemoteHeadCache heads;
+    heads.begin_cycle();
+    heads.add(remote.string());
+    heads.add(remote.string());
+    REQUIRE(heads.shared(remote.string()));
+    git::FetchParams params;
+    params.remote_heads = &heads;
+    {
+        git::RepoSession session(repo);
+        const git::FetchResult& res = session.fetch("origin", "master", params);
+        REQUIRE(res.ok);
+        REQUIRE(res.fetch_skipped);
+        REQUIRE(res.remote_hash == hash);
+    }
+
+    (void)std::system((std::string("git -C ") + other.string() + " config user.email you@example.com").c_str());
+    (void)std::system((std::string("git -C ") + other.string() + " config user.name tester").c_str());
+    std::ofstream(other / "file.txt") << "update";
+    (void)std::system((std::string("git -C ") + other.string() + " commit -am update" REDIR).c_str());
+    REQUIRE(std::system((std::string("git -C ") + other.string() + " push origin master" + REDIR).c_str()) == 0);
+    std::string new_hash = git::get_local_hash(other).value_or("");
+
+    // The duplicate clone reuses the listing made for the first one
+    {
+        git::RepoSession session(dup);
+        const git::FetchResult& res = session.fetch("origin", "master", params);
+        REQUIRE(res.ok);
+        REQUIRE(res.fetch_skipped);
+        REQUIRE(res.remote_hash == hash);
+    }
+    REQUIRE(heads.size() == 1);
+
+    heads.begin_cycle();
+    heads.add(remote.string());
+    heads.add(remote.string());
+    {
+        git::RepoSession session(dup);
+        const git::FetchResult& res = session.fetch("origin", "master", params);
+        REQUIRE(res.ok);
+        REQUIRE_FALSE(res.fetch_skipped);
+        REQUIRE(res.remote_hash == new_hash);
+    }
+
+    FS_REMOVE_ALL(other);
+    FS_REMOVE_ALL(dup);
+    FS_REMOVE_ALL(repo);
+    FS_REMOVE_ALL(remote);
+}
+
+TEST_CASE("try_pull checks out only changed files") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo, remote;
+    std::string hash;
+    std::time_t ctime;
+    setup_repo(repo, remote, hash, ctime);
+
+    fs::path other = repo.string() + "_other";
+    FS_REMOVE_ALL(other);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + other.string() + REDIR).c_str()) == 0);
+    (void)std::system((std::string("git -C ") + other.string() + " config user.email you@example.com").c_str());
+    (void)std::system((std::string("git -C ") + other.string() + " config user.name tester").c_str());
+    std::ofstream(other / "file.txt") << "update";
+    std::ofstream(other / "new.txt") << "new";
+    (void)std::system((std::string("git -C ") + other.string() + " add new.txt").c_str());
+    (void)std::system((std::string("git -C ") + other.string() + " commit -am update" REDIR).c_str());
+    REQUIRE(std::system((std::string("git -C ") + other.string() + " push origin master" + REDIR).c_str()) == 0);
+    std::string new_hash = git::get_local_hash(other).value_or("");
+
+    git::RepoSession session(repo);
+    std::string log;
+    size_t files = 0;
+    REQUIRE(git::try_pull(session, "origin", log, git::FetchParams{}, false, nullptr, &files) == 0);
+    REQUIRE(log == "Fast-forwarded");
+    REQUIRE(files == 2);
+    REQUIRE(git::get_local_hash(repo).value_or("") == new_hash);
+    REQUIRE(git::get_current_branch(repo).value_or("") == "master");
+    std::ifstream in(repo / "new.txt");
+    std::string content;
+    std::getline(in, content);
+    REQUIRE(content == "new");
+    REQUIRE_FALSE(git::has_uncommitted_changes(repo));
+
+    FS_REMOVE_ALL(other);
+    FS_REMOVE_ALL(repo);
+    FS_REMOVE_ALL(remote);
+}
+
+TEST_CASE("fetch aborts at its deadline or when cancelled") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo, remote;
+    std::string hash;
+    std::time_t ctime;
+    setup_repo(repo, remote, hash, ctime);
+
+    fs::path other = repo.string() + "_other";
+    FS_REMOVE_ALL(other);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + other.string() + REDIR).c_str()) == 0);
+    (void)std::system((std::string("git -C ") + other.string() + " config user.email you@example.com").c_str());
+    (void)std::system((std::string("git -C ") + other.string() + " config user.name tester").c_str());
+    std::ofstream(other / "file.txt") << "update";
+    (void)std::system((std::string("git -C ") + other.string() + " commit -am update" REDIR).c_str());
+    REQUIRE(std::system((std::string("git -C ") + other.string() + " push origin master" + REDIR).c_str()) == 0);
+
+    git::FetchParams expired;
+    expired.deadline = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+    {
+        git::RepoSession session(repo);
+        std::string log;
+        REQUIRE(git::try_pull(session, "origin", log, expired, false) == git::TRY_PULL_TIMEOUT);
+        REQUIRE(session.last_fetch()->timed_out);
+        REQUIRE(git::get_local_hash(repo).value_or("") == hash);
+    }
+
+    std::atomic<bool> running{false};
+    git::FetchParams stopped;
+    stopped.running = &running;
+    {
+        git::RepoSession session(repo);
+        const git::FetchResult& res = session.fetch("origin", "master", stopped);
+        REQUIRE_FALSE(res.ok);
+        REQUIRE(res.cancelled);
+    }
+
+    // Limits on one fetch do not leak into the next
+    git::FetchParams generous;
+    generous.timeout = std::chrono::seconds(60);
+    {
+        git::RepoSession session(repo);
+        std::string log;
+        REQUIRE(git::try_pull(session, "origin", log, generous, false) == 0);
+    }
+
+    FS_REMOVE_ALL(other);
+    FS_REMOVE_ALL(repo);
+    FS_REMOVE_ALL(remote);
+}
+
+#if !defined(_WIN32) &&                                                                           \
+    (LIBGIT2_VER_MAJOR > 1 || (LIBGIT2_VER_MAJOR == 1 && LIBGIT2_VER_MINOR >= 7))
+TEST_CASE("remote that stops responding times out") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo, remote;
+    std::string hash;
+    std::time_t ctime;
+    setup_repo(repo, remote, hash, ctime);
+
+    // The kernel completes the handshake from the backlog; nothing ever answers
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    REQUIRE(fd >= 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    REQUIRE(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    REQUIRE(listen(fd, 8) == 0);
+    socklen_t len = sizeof(addr);
+    REQUIRE(getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0);
+    std::string url = "git://127.0.0.1:" + std::to_string(ntohs(addr.sin_port)) + "/stalled.git";
+    REQUIRE(std::system(("git -C " + repo.string() + " remote set-url origin " + url).c_str()) ==
+            0);
+
+    git::set_server_timeouts(std::chrono::seconds(1));
+    git::FetchParams params;
+    params.timeout = std::chrono::seconds(2);
+    auto start = std::chrono::steady_clock::now();
+    {
+        git::RepoSession session(repo);
+        git::RemoteHeads heads = session.list_remote("origin", params);
+        REQUIRE_FALSE(heads.ok);
+        REQUIRE(heads.kind == git::FetchError::Timeout);
+        REQUIRE_FALSE(session.remote_accessible("origin", params));
+        const git::FetchResult& res = session.fetch("origin", "master", params);
+        REQUIRE_FALSE(res.ok);
+        REQUIRE(res.timed_out);
+    }
+    git::FetchResult cloned = git::clone_repo(repo.string() + "_clone", url, params);
+    REQUIRE_FALSE(cloned.ok);
+    REQUIRE(cloned.timed_out);
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(30));
+    git::set_server_timeouts(std::chrono::seconds(0));
+
+    close(fd);
+    FS_REMOVE_ALL(repo.string() + "_clone");
+    FS_REMOVE_ALL(repo);
+    FS_REMOVE_ALL(remote);
+}
+#endif
+
 TEST_CASE("remote queries fail fast on fetch error") {
     if (!have_git()) {
         WARN("git not available; skipping");
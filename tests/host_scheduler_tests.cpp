@@ -0,0 +1,158 @@
+#include "test_common.hpp"
+#include "host_scheduler.hpp"
+
+using Outcome = procutil::HostScheduler::Outcome;
+
+TEST_CASE("host scheduler interleaves hosts") {
+    procutil::HostScheduler sched;
+    sched.begin_scan(8);
+    sched.add("github.com", 0);
+    sched.add("github.com", 1);
+    sched.add("github.com", 2);
+    sched.add("gitea.lan", 3);
+    sched.add("gitea.lan", 4);
+    std::atomic<bool> running{true};
+    std::vector<std::string> picked;
+    size_t idx = 0;
+    std::string host;
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(sched.next(idx, host, running));
+        picked.push_back(host);
+    }
+    REQUIRE(picked == std::vector<std::string>{"github.com", "gitea.lan", "github.com",
+                                               "gitea.lan"});
+    // Both hosts are at their initial window of two
+    sched.finish("github.com", Outcome::Success);
+    REQUIRE(sched.next(idx, host, running));
+    REQUIRE(idx == 2);
+}
+
+TEST_CASE("host scheduler grows additively and halves on congestion") {
+    procutil::HostScheduler sched;
+    sched.begin_scan(16);
+    REQUIRE(sched.window("h") == 2.0);
+    for (int i = 0; i < 20; ++i)
+        sched.finish("h", Outcome::Success);
+    double grown = sched.window("h");
+    REQUIRE(grown > 6.0);
+    REQUIRE(grown < 7.0);
+    sched.finish("h", Outcome::Congested);
+    REQUIRE(sched.window("h") == grown / 2.0);
+    for (int i = 0; i < 10; ++i)
+        sched.finish("h", Outcome::Congested);
+    REQUIRE(sched.window("h") == 1.0);
+    sched.finish("h", Outcome::Neutral);
+    REQUIRE(sched.window("h") == 1.0);
+    for (int i = 0; i < 1000; ++i)
+        sched.finish("h", Outcome::Success);
+    REQUIRE(sched.window("h") == 16.0);
+    // A smaller concurrency on the next scan clamps the learned window
+    sched.begin_scan(4);
+    REQUIRE(sched.window("h") == 4.0);
+}
+
+TEST_CASE("host scheduler stops when no jobs remain") {
+    procutil::HostScheduler sched;
+    sched.begin_scan(2);
+    std::atomic<bool> running{true};
+    size_t idx = 0;
+    std::string host;
+    REQUIRE_FALSE(sched.next(idx, host, running));
+    sched.add("", 7);
+    running = false;
+    REQUIRE_FALSE(sched.next(idx, host, running));
+}
+
+TEST_CASE("host scheduler queues parked jobs once due") {
+    using clock = procutil::HostScheduler::clock;
+    procutil::HostScheduler sched;
+    sched.begin_scan(4);
+    sched.add("flaky", 0);
+    sched.add("fine", 1);
+    std::atomic<bool> running{true};
+    size_t idx = 0;
+    std::string host;
+    REQUIRE(sched.next(idx, host, running));
+    REQUIRE(idx == 0);
+    auto due = clock::now() + std::chrono::milliseconds(200);
+    sched.retry("flaky", 0, Outcome::Congested, due);
+    REQUIRE(sched.parked() == 1);
+    // Other work goes first, without waiting for the parked job
+    REQUIRE(sched.next(idx, host, running));
+    REQUIRE(idx == 1);
+    sched.finish("fine", Outcome::Success);
+    REQUIRE(sched.next(idx, host, running));
+    REQUIRE(idx == 0);
+    REQUIRE(clock::now() >= due);
+    REQUIRE(sched.parked() == 0);
+    sched.finish("flaky", Outcome::Success);
+    REQUIRE_FALSE(sched.next(idx, host, running));
+}
+
+TEST_CASE("host scheduler waits for jobs that may still be parked") {
+    procutil::HostScheduler sched;
+    sched.begin_scan(2);
+    sched.add("h", 3);
+    std::atomic<bool> running{true};
+    size_t idx = 0;
+    std::string host;
+    REQUIRE(sched.next(idx, host, running));
+    std::atomic<bool> done{false};
+    std::thread other([&]() {
+        size_t i = 0;
+        std::string h;
+        bool got = sched.next(i, h, running);
+        done = true;
+        if (got)
+            sched.finish(h, Outcome::Success);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE_FALSE(done);
+    sched.retry("h", 3, Outcome::Neutral, procutil::HostScheduler::clock::now());
+    other.join();
+    REQUIRE(done);
+    REQUIRE_FALSE(sched.next(idx, host, running));
+}
+
+TEST_CASE("host scheduler ends a scan at its horizon") {
+    using clock = procutil::HostScheduler::clock;
+    procutil::HostScheduler sched;
+    auto start = clock::now();
+    sched.begin_scan(2, start + std::chrono::milliseconds(300));
+    sched.add("h", 0);
+    sched.park("h", 1, start + std::chrono::milliseconds(100));
+    sched.park("h", 2, start + std::chrono::hours(1));
+    std::atomic<bool> running{true};
+    size_t idx = 0;
+    std::string host;
+    REQUIRE(sched.next(idx, host, running));
+    REQUIRE(idx == 0);
+    sched.finish(host, Outcome::Success);
+    REQUIRE(sched.next(idx, host, running));
+    REQUIRE(idx == 1);
+    REQUIRE(clock::now() >= start + std::chrono::milliseconds(100));
+    sched.finish(host, Outcome::Success);
+    // The remaining job is due after the horizon
+    REQUIRE_FALSE(sched.next(idx, host, running));
+    REQUIRE(clock::now() < start + std::chrono::minutes(1));
+}
+
+TEST_CASE("host scheduler serves due jobs past the horizon while one is in flight") {
+    using clock = procutil::HostScheduler::clock;
+    procutil::HostScheduler sched;
+    auto start = clock::now();
+    sched.begin_scan(2, start);
+    sched.add("slow", 0);
+    sched.park("fast", 1, start + std::chrono::milliseconds(50));
+    std::atomic<bool> running{true};
+    size_t idx = 0;
+    std::string host;
+    REQUIRE(sched.next(idx, host, running));
+    REQUIRE(idx == 0);
+    // Job 0 still holds its slot, so job 1 is not dropped
+    REQUIRE(sched.next(idx, host, running));
+    REQUIRE(idx == 1);
+    sched.finish("fast", Outcome::Success);
+    sched.finish("slow", Outcome::Success);
+    REQUIRE_FALSE(sched.next(idx, host, running));
+}
@@ -0,0 +1,95 @@
+#include <chrono>
+#include <string>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "test_common.hpp"
+
+static Options profile_options(const fs::path& root, const char* profile) {
+    std::string root_s = root.string();
+    const char* argv[] = {"prog", root_s.c_str(), "--git-profile", profile};
+    return parse_options(4, const_cast<char**>(argv));
+}
+
+TEST_CASE("apply_libgit2_options sets and restores libgit2 settings") {
+    git::GitInitGuard guard;
+    size_t original = 0;
+    REQUIRE(git_libgit2_opts(GIT_OPT_GET_MWINDOW_SIZE, &original) == 0);
+
+    Options lean = profile_options(fs::temp_directory_path(), "lean");
+    git::apply_libgit2_options(lean.libgit2);
+    size_t window = 0;
+    REQUIRE(git_libgit2_opts(GIT_OPT_GET_MWINDOW_SIZE, &window) == 0);
+    REQUIRE(window == 32ull * 1024 * 1024);
+
+    // A reload without the setting reverts to libgit2's own value
+    git::apply_libgit2_options(Libgit2Options{});
+    REQUIRE(git_libgit2_opts(GIT_OPT_GET_MWINDOW_SIZE, &window) == 0);
+    REQUIRE(window == original);
+}
+
+TEST_CASE("libgit2 tuning profiles", "[!benchmark]") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    auto suffix = std::to_string(static_cast<unsigned long long>(
+        std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+    fs::path root = fs::temp_directory_path() / ("tuning_bench_" + suffix);
+    fs::path remote = root / "remote.git";
+    fs::path seed = root / "seed";
+    FS_REMOVE_ALL(root);
+    fs::create_directories(root);
+    REQUIRE(std::system(("git init --bare " + remote.string() + REDIR).c_str()) == 0);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + seed.string() + REDIR).c_str()) ==
+            0);
+    (void)std::system(
+        (std::string("git -C ") + seed.string() + " config user.email you@example.com").c_str());
+    (void)std::system((std::string("git -C ") + seed.string() + " config user.name tester").c_str());
+    for (int i = 0; i < 20; ++i) {
+        std::ofstream(seed / ("file" + std::to_string(i) + ".txt")) << "content " << i;
+        (void)std::system((std::string("git -C ") + seed.string() + " add ." REDIR).c_str());
+        (void)std::system(
+            (std::string("git -C ") + seed.string() + " commit -m c" + std::to_string(i) + REDIR)
+                .c_str());
+    }
+    REQUIRE(std::system(
+                (std::string("git -C ") + seed.string() + " push origin master" + REDIR).c_str()) ==
+            0);
+    std::vector<fs::path> repos;
+    for (int i = 0; i < 50; ++i) {
+        fs::path clone = root / ("repo" + std::to_string(i));
+        REQUIRE(std::system(("git clone " + remote.string() + " " + clone.string() + REDIR)
+                                .c_str()) == 0);
+        repos.push_back(clone);
+    }
+
+    // One scan cycle's worth of libgit2 work per repository
+    auto cycle = [&]() {
+        size_t ok = 0;
+        for (const auto& p : repos) {
+            git::RepoSession session(p);
+            if (session.fetch("origin", "master").ok && session.local_hash() &&
+                !session.has_uncommitted_changes())
+                ++ok;
+        }
+        return ok;
+    };
+
+    for (const char* profile : {"default", "lean", "fast"}) {
+        git::apply_libgit2_options(profile_options(root, profile).libgit2);
+        // Memory left over from the previous profile is returned first, so
+        // each profile is measured by what one cycle of its own adds
+        procutil::release_free_memory();
+        size_t rss_before = procutil::read_memory_usage_kb();
+        (void)cycle();
+        size_t rss_after = procutil::read_memory_usage_kb();
+        long long delta = static_cast<long long>(rss_after) - static_cast<long long>(rss_before);
+        WARN("libgit2 profile " << profile << ": rss_before=" << rss_before
+                                << "KB rss_after=" << rss_after << "KB delta=" << delta << "KB");
+        BENCHMARK(std::string("scan cycle, ") + profile + " profile") { return cycle(); };
+    }
+    git::apply_libgit2_options(Libgit2Options{});
+
+    FS_REMOVE_ALL(root);
+}
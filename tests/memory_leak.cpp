@@ -44,10 +44,12 @@ TEST_CASE("scan_repos memory stability") {
     for (int i = 0; i < 100; ++i) {
         scanning = true;
         running = true;
-        scan_repos(repos, infos, skip, mtx, scanning, running, action, action_mtx, false, "origin",
-                   fs::path(), true, true, 1, 0, 0, 0, 0, 0, false, false, false, false, false,
-                   false, true, fs::path(), std::nullopt, std::chrono::seconds(0), false,
-                   std::chrono::seconds(0), false, false, {}, false);
+        ScanOptions scan;
+        scan.check_only = true;
+        scan.skip_timeout = false;
+        scan.skip_unavailable = false;
+        scan.skip_accessible_errors = true;
+        scan_repos(repos, infos, skip, mtx, scanning, running, action, action_mtx, scan);
         size_t mem = procutil::get_memory_usage_mb();
         if (i == 0)
             baseline = mem;
@@ -0,0 +1,106 @@
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include "test_common.hpp"
+#include "mirror_cache.hpp"
+
+static std::string run_cmd(const std::string& cmd) {
+    std::array<char, 128> buffer{};
+    std::string result;
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (!pipe)
+        return result;
+    while (fgets(buffer.data(), static_cast<int>(buffer.size()), pipe))
+        result += buffer.data();
+    pclose(pipe);
+    if (!result.empty() && result.back() == '\n')
+        result.pop_back();
+    return result;
+}
+
+static void commit_and_push(const fs::path& seed, const std::string& msg) {
+    std::ofstream(seed / (msg + ".txt")) << msg;
+    (void)std::system((std::string("git -C ") + seed.string() + " add ." REDIR).c_str());
+    (void)std::system(
+        (std::string("git -C ") + seed.string() + " commit -m " + msg + REDIR).c_str());
+    REQUIRE(std::system(
+                (std::string("git -C ") + seed.string() + " push origin master" + REDIR).c_str()) ==
+            0);
+}
+
+TEST_CASE("MirrorCache names mirrors per URL") {
+    git::MirrorCache cache("/cache");
+    fs::path a = cache.path_for("https://github.com/org/tool.git");
+    REQUIRE(a == cache.path_for("https://github.com/org/tool.git"));
+    REQUIRE(a.parent_path() == fs::path("/cache"));
+    REQUIRE(a.filename().string().rfind("github.com_tool-", 0) == 0);
+    REQUIRE(a.extension() == ".git");
+    REQUIRE(a != cache.path_for("https://gitlab.com/org/tool.git"));
+    REQUIRE(a != cache.path_for("git@github.com:org/tool.git"));
+}
+
+TEST_CASE("MirrorCache fetches each URL once per cycle") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    auto suffix = std::to_string(static_cast<unsigned long long>(
+        std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+    fs::path root = fs::temp_directory_path() / ("mirror_cache_" + suffix);
+    fs::path remote = root / "remote.git";
+    fs::path seed = root / "seed";
+    fs::path clone = root / "clone";
+    FS_REMOVE_ALL(root);
+    fs::create_directories(root);
+    REQUIRE(std::system(("git init --bare " + remote.string() + REDIR).c_str()) == 0);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + seed.string() + REDIR).c_str()) ==
+            0);
+    (void)std::system(
+        (std::string("git -C ") + seed.string() + " config user.email you@example.com").c_str());
+    (void)std::system((std::string("git -C ") + seed.string() + " config user.name tester").c_str());
+    commit_and_push(seed, "first");
+    REQUIRE(std::system(("git clone " + remote.string() + " " + clone.string() + REDIR).c_str()) ==
+            0);
+
+    git::MirrorCache cache(root / "mirrors", true);
+    std::string url = remote.string();
+    fs::path mirror = cache.path_for(url);
+    auto mirror_head = [&]() {
+        return run_cmd("git --git-dir=" + mirror.string() + " rev-parse refs/heads/master");
+    };
+    REQUIRE(cache.refresh(url, {}).ok);
+    std::string first = run_cmd("git -C " + seed.string() + " rev-parse HEAD");
+    REQUIRE(mirror_head() == first);
+
+    // A second caller in the same cycle shares the first fetch
+    commit_and_push(seed, "second");
+    std::string second = run_cmd("git -C " + seed.string() + " rev-parse HEAD");
+    REQUIRE(cache.refresh(url, {}).ok);
+    REQUIRE(mirror_head() == first);
+
+    cache.begin_cycle();
+    REQUIRE(cache.refresh(url, {}).ok);
+    REQUIRE(mirror_head() == second);
+
+    // The clone never fetched the second commit but can read it via the mirror
+    git_repository* raw = nullptr;
+    REQUIRE(git_repository_open(&raw, clone.string().c_str()) == 0);
+    git::repo_ptr repo(raw);
+    git_oid oid;
+    REQUIRE(git_oid_fromstr(&oid, second.c_str()) == 0);
+    git_commit* commit = nullptr;
+    REQUIRE(git_commit_lookup(&commit, repo.get(), &oid) != 0);
+    REQUIRE(cache.link_alternate(repo.get(), url));
+    REQUIRE(git_commit_lookup(&commit, repo.get(), &oid) == 0);
+    git_commit_free(commit);
+    REQUIRE(cache.link_alternate(repo.get(), url));
+    std::ifstream alternates(clone / ".git" / "objects" / "info" / "alternates");
+    std::string line;
+    int lines = 0;
+    while (std::getline(alternates, line))
+        ++lines;
+    REQUIRE(lines == 1);
+
+    FS_REMOVE_ALL(root);
+}
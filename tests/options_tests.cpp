@@ -85,6 +85,120 @@ TEST_CASE("parse_options dry run flag") {
     REQUIRE(opts.dry_run);
 }
 
+TEST_CASE("parse_options ls-remote flag") {
+    const char* argv[] = {"prog", "path", "--ls-remote"};
+    Options opts = parse_options(3, const_cast<char**>(argv));
+    REQUIRE(opts.ls_remote);
+    const char* argv2[] = {"prog", "path"};
+    Options defaults = parse_options(2, const_cast<char**>(argv2));
+    REQUIRE_FALSE(defaults.ls_remote);
+}
+
+TEST_CASE("parse_options fetch policy flags") {
+    const char* argv[] = {"prog", "path", "--fetch-tags", "none", "--single-branch", "--prune"};
+    Options opts = parse_options(6, const_cast<char**>(argv));
+    REQUIRE(opts.fetch_tags == TagPolicy::None);
+    REQUIRE(opts.single_branch);
+    REQUIRE(opts.prune);
+    const char* argv2[] = {"prog", "path"};
+    Options defaults = parse_options(2, const_cast<char**>(argv2));
+    REQUIRE(defaults.fetch_tags == TagPolicy::All);
+    REQUIRE_FALSE(defaults.single_branch);
+    REQUIRE_FALSE(defaults.prune);
+    const char* bad[] = {"prog", "path", "--fetch-tags", "some"};
+    REQUIRE_THROWS_AS(parse_options(4, const_cast<char**>(bad)), std::runtime_error);
+}
+
+TEST_CASE("parse_options fetch depth") {
+    const char* argv[] = {"prog", "path", "--fetch-depth", "50"};
+    Options opts = parse_options(4, const_cast<char**>(argv));
+    REQUIRE(opts.fetch_depth == 50u);
+    const char* bad[] = {"prog", "path", "--fetch-depth", "-1"};
+    REQUIRE_THROWS_AS(parse_options(4, const_cast<char**>(bad)), std::runtime_error);
+}
+
+TEST_CASE("parse_options pack maintenance") {
+    const char* argv[] = {"prog", "path", "--pack-maintenance", "--max-packs", "10",
+                          "--max-loose-objects", "500"};
+    Options opts = parse_options(7, const_cast<char**>(argv));
+    REQUIRE(opts.pack_maintenance);
+    REQUIRE(opts.max_packs == 10);
+    REQUIRE(opts.max_loose_objects == 500);
+    const char* argv2[] = {"prog", "path"};
+    Options defaults = parse_options(2, const_cast<char**>(argv2));
+    REQUIRE_FALSE(defaults.pack_maintenance);
+    REQUIRE(defaults.max_packs == 50);
+    REQUIRE(defaults.max_loose_objects == 6700);
+    const char* bad[] = {"prog", "path", "--max-packs", "many"};
+    REQUIRE_THROWS_AS(parse_options(4, const_cast<char**>(bad)), std::runtime_error);
+}
+
+TEST_CASE("parse_options manifest") {
+    const char* argv[] = {"prog", "path", "--manifest", "repos.yaml"};
+    Options opts = parse_options(4, const_cast<char**>(argv));
+    REQUIRE(opts.manifest == fs::path("repos.yaml"));
+    const char* def[] = {"prog", "path"};
+    REQUIRE(parse_options(2, const_cast<char**>(def)).manifest.empty());
+}
+
+TEST_CASE("parse_options mirror cache") {
+    const char* argv[] = {"prog", "path", "--mirror-cache", "/var/cache/mirrors",
+                          "--mirror-alternates"};
+    Options opts = parse_options(5, const_cast<char**>(argv));
+    REQUIRE(opts.mirror_cache == fs::path("/var/cache/mirrors"));
+    REQUIRE(opts.mirror_alternates);
+    const char* def[] = {"prog", "path"};
+    Options defaults = parse_options(2, const_cast<char**>(def));
+    REQUIRE(defaults.mirror_cache.empty());
+    REQUIRE_FALSE(defaults.mirror_alternates);
+}
+
+TEST_CASE("parse_options libgit2 profiles") {
+    const char* argv[] = {"prog", "path", "--git-profile", "lean", "--git-cache-size", "64MB"};
+    Options opts = parse_options(6, const_cast<char**>(argv));
+    REQUIRE(opts.libgit2.profile == "lean");
+    REQUIRE(opts.libgit2.cache_size == 64ull * 1024 * 1024);
+    REQUIRE(opts.libgit2.mmap_limit == 256ull * 1024 * 1024);
+    REQUIRE(opts.libgit2.open_packs == 128u);
+    REQUIRE_FALSE(opts.libgit2.strict_hash_verification.has_value());
+    const char* argv2[] = {"prog", "path", "--git-profile", "fast", "--git-fsync"};
+    Options fast = parse_options(5, const_cast<char**>(argv2));
+    REQUIRE(fast.libgit2.strict_object_creation == false);
+    REQUIRE(fast.libgit2.strict_hash_verification == false);
+    REQUIRE(fast.libgit2.fsync_gitdir == true);
+    const char* argv3[] = {"prog", "path"};
+    Options defaults = parse_options(2, const_cast<char**>(argv3));
+    REQUIRE(defaults.libgit2.profile == "default");
+    REQUIRE_FALSE(defaults.libgit2.cache_size.has_value());
+    REQUIRE_FALSE(defaults.libgit2.mmap_window.has_value());
+    const char* bad[] = {"prog", "path", "--git-profile", "turbo"};
+    REQUIRE_THROWS_AS(parse_options(4, const_cast<char**>(bad)), std::runtime_error);
+}
+
+TEST_CASE("parse_options traffic budgets") {
+    const char* argv[] = {"prog", "path", "--total-traffic-limit", "2GB",
+                          "--cycle-traffic-limit", "100MB"};
+    Options opts = parse_options(6, const_cast<char**>(argv));
+    REQUIRE(opts.limits.total_traffic_limit == 2ull * 1024 * 1024 * 1024);
+    REQUIRE(opts.limits.cycle_traffic_limit == 100ull * 1024 * 1024);
+}
+
+TEST_CASE("parse_options stage concurrency") {
+    const char* argv[] = {"prog", "path", "--fetch-concurrency", "8", "--checkout-concurrency",
+                          "2", "--hook-concurrency", "1"};
+    Options opts = parse_options(8, const_cast<char**>(argv));
+    REQUIRE(opts.limits.fetch_concurrency == 8);
+    REQUIRE(opts.limits.checkout_concurrency == 2);
+    REQUIRE(opts.limits.hook_concurrency == 1);
+    const char* def[] = {"prog", "path"};
+    Options defaults = parse_options(2, const_cast<char**>(def));
+    REQUIRE(defaults.limits.fetch_concurrency == 0);
+    REQUIRE(defaults.limits.checkout_concurrency == 0);
+    REQUIRE(defaults.limits.hook_concurrency == 0);
+    const char* bad[] = {"prog", "path", "--fetch-concurrency", "x"};
+    REQUIRE_THROWS(parse_options(4, const_cast<char**>(bad)));
+}
+
 TEST_CASE("parse_options daemon control flags") {
     const char* argv[] = {"prog", "path", "--start-daemon", "--stop-daemon", "--restart-daemon"};
     Options opts = parse_options(5, const_cast<char**>(argv));
@@ -145,6 +259,27 @@ TEST_CASE("parse_options per-repo pull ref override") {
     fs::remove(cfg, ec);
 }
 
+TEST_CASE("parse_options per-repo fetch policy override") {
+    fs::path cfg = fs::temp_directory_path() / "fetch_policy_override.json";
+    nlohmann::json j;
+    j["repositories"]["repo1"]["fetch-tags"] = "auto";
+    j["repositories"]["repo1"]["single-branch"] = true;
+    j["repositories"]["repo1"]["prune"] = false;
+    j["repositories"]["repo1"]["fetch-depth"] = "10";
+    std::ofstream(cfg) << j.dump();
+    const std::string cfg_str = cfg.string();
+    const char* argv[] = {"prog", "repo1", "--config-json", cfg_str.c_str()};
+    Options opts = parse_options(4, const_cast<char**>(argv));
+    auto it = opts.repo_settings.find(fs::path("repo1"));
+    REQUIRE(it != opts.repo_settings.end());
+    REQUIRE(it->second.fetch_tags == TagPolicy::Auto);
+    REQUIRE(it->second.single_branch == true);
+    REQUIRE(it->second.prune == false);
+    REQUIRE(it->second.fetch_depth == 10u);
+    std::error_code ec;
+    fs::remove(cfg, ec);
+}
+
 TEST_CASE("parse_options install daemon name override") {
     const char* argv[] = {"prog", "path", "--install-daemon", "dname"};
     Options opts = parse_options(4, const_cast<char**>(argv));
@@ -249,6 +384,23 @@ TEST_CASE("parse_options interval units") {
     REQUIRE(opts.interval == 120);
 }
 
+TEST_CASE("parse_options adaptive interval bounds") {
+    const char* argv[] = {"prog", "path", "--interval", "1m", "--adaptive-interval"};
+    Options opts = parse_options(5, const_cast<char**>(argv));
+    REQUIRE(opts.adaptive_interval);
+    REQUIRE(opts.min_interval == std::chrono::minutes(1));
+    REQUIRE(opts.max_interval == std::chrono::minutes(10));
+
+    const char* argv2[] = {"prog", "path", "--min-interval", "10s", "--max-interval", "2h"};
+    Options opts2 = parse_options(6, const_cast<char**>(argv2));
+    REQUIRE_FALSE(opts2.adaptive_interval);
+    REQUIRE(opts2.min_interval == std::chrono::seconds(10));
+    REQUIRE(opts2.max_interval == std::chrono::hours(2));
+
+    const char* argv3[] = {"prog", "path", "--min-interval", "1h", "--max-interval", "1m"};
+    REQUIRE_THROWS_AS(parse_options(6, const_cast<char**>(argv3)), std::runtime_error);
+}
+
 TEST_CASE("parse_options kill-all option") {
     const char* argv[] = {"prog", "path", "--kill-all"};
     Options opts = parse_options(3, const_cast<char**>(argv));
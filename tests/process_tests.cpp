@@ -9,6 +9,7 @@
 static int g_monitor_count = 0;
 
 TEST_CASE("run_event_loop runtime limit") {
+    git::GitInitGuard guard; // main() holds this in the application
     fs::path dir = fs::temp_directory_path() / "runtime_limit_test";
     fs::create_directories(dir);
     // create a minimal git repo so event loop does not exit immediately
@@ -0,0 +1,125 @@
+#include "test_common.hpp"
+#include "repo_state.hpp"
+
+TEST_CASE("RepoStateTable claims each repository once") {
+    RepoStateTable table;
+    fs::path a = "/tmp/repo_state_a";
+    RepoClaim first = table.claim(a);
+    REQUIRE(first);
+    REQUIRE_FALSE(table.claim(a));
+    REQUIRE(table.claim("/tmp/repo_state_b"));
+    REQUIRE(table.size() == 2);
+    first.release();
+    RepoClaim again = table.claim(a);
+    REQUIRE(again);
+    REQUIRE(again.get() == table.find(a));
+    REQUIRE(table.find("/tmp/repo_state_c") == nullptr);
+}
+
+TEST_CASE("RepoStateTable overlays claimed slots only") {
+    RepoStateTable table;
+    fs::path a = "/tmp/repo_state_a";
+    fs::path b = "/tmp/repo_state_b";
+    std::map<fs::path, RepoInfo> infos;
+    infos[a] = RepoInfo{.message = "Pending..."};
+    infos[b] = RepoInfo{.message = "Up to date", .status = RS_UP_TO_DATE};
+    table.slot(b);
+    {
+        RepoClaim claim = table.claim(a);
+        claim->set_status(RS_PULLING, "Pulling...");
+        claim->set_progress(42);
+        std::map<fs::path, RepoInfo> view = infos;
+        table.overlay(view);
+        REQUIRE(view[a].status == RS_PULLING);
+        REQUIRE(view[a].message == "Pulling...");
+        REQUIRE(view[a].progress == 42);
+        REQUIRE(view[b].status == RS_UP_TO_DATE);
+    }
+    std::map<fs::path, RepoInfo> view = infos;
+    table.overlay(view);
+    REQUIRE(view[a].status == RS_PENDING);
+    REQUIRE(view[a].progress == 0);
+}
+
+TEST_CASE("RepoStateTable takes updates from many threads") {
+    RepoStateTable table;
+    std::map<fs::path, RepoInfo> infos;
+    std::vector<fs::path> paths;
+    for (int i = 0; i < 8; ++i) {
+        paths.push_back(fs::path("/tmp/repo_state_" + std::to_string(i)));
+        infos[paths.back()];
+    }
+    std::atomic<bool> done{false};
+    std::atomic<int> max_seen{0};
+    std::thread reader([&]() {
+        while (!done) {
+            std::map<fs::path, RepoInfo> view = infos;
+            table.overlay(view);
+            for (const auto& [p, info] : view)
+                max_seen = std::max(max_seen.load(), info.progress);
+        }
+    });
+    std::vector<std::thread> workers;
+    for (const auto& p : paths) {
+        workers.emplace_back([&table, p]() {
+            RepoClaim claim = table.claim(p);
+            for (int pct = 0; pct <= 100; ++pct) {
+                claim->set_progress(pct);
+                if (pct % 25 == 0)
+                    claim->set_message(std::to_string(pct) + "%");
+            }
+        });
+    }
+    for (auto& t : workers)
+        t.join();
+    done = true;
+    reader.join();
+    REQUIRE(max_seen <= 100);
+    REQUIRE(table.size() == paths.size());
+    for (const auto& p : paths)
+        REQUIRE_FALSE(table.find(p)->claimed());
+}
+
+TEST_CASE("RepoView copies only touched and claimed entries") {
+    RepoStateTable table;
+    std::mutex mtx;
+    fs::path a = "/tmp/repo_state_a";
+    fs::path b = "/tmp/repo_state_b";
+    std::map<fs::path, RepoInfo> infos;
+    infos[a] = RepoInfo{.message = "Pending..."};
+    infos[b] = RepoInfo{.message = "Pending..."};
+    table.slot(a);
+    table.slot(b);
+    RepoView view;
+    view.refresh(table, infos, mtx);
+    REQUIRE(view.infos().size() == 2);
+
+    // An untouched write stays out of the view until its slot is touched
+    infos[a].message = "Up to date";
+    view.refresh(table, infos, mtx);
+    REQUIRE(view.infos().at(a).message == "Pending...");
+    table.touch(a);
+    view.refresh(table, infos, mtx);
+    REQUIRE(view.infos().at(a).message == "Up to date");
+
+    {
+        RepoClaim claim = table.claim(b);
+        claim->set_status(RS_PULLING, "Pulling...");
+        claim->set_progress(42);
+        view.refresh(table, infos, mtx);
+        REQUIRE(view.infos().at(b).status == RS_PULLING);
+        REQUIRE(view.infos().at(b).progress == 42);
+        infos[b] = RepoInfo{.message = "Pulled", .status = RS_PULL_OK};
+    }
+    view.refresh(table, infos, mtx);
+    REQUIRE(view.infos().at(b).status == RS_PULL_OK);
+    REQUIRE(view.infos().at(b).message == "Pulled");
+
+    // Bulk edits, removals included, copy the whole map
+    infos.erase(a);
+    infos[b].message = "Pending...";
+    table.touch_all();
+    view.refresh(table, infos, mtx);
+    REQUIRE(view.infos().count(a) == 0);
+    REQUIRE(view.infos().at(b).message == "Pending...");
+}
@@ -1,4 +1,7 @@
 #include "test_common.hpp"
+#include "due_scheduler.hpp"
+#include "traffic_budget.hpp"
+#include "worker_pool.hpp"
 #include <chrono>
 #include <vector>
 
@@ -12,6 +15,20 @@ TEST_CASE("get_local_hash surfaces error for missing repo") {
     REQUIRE(!err.empty());
 }
 
+TEST_CASE("one-shot lookups report why a directory is not a repository") {
+    git::GitInitGuard guard;
+    fs::path dir = fs::temp_directory_path() / "not_a_repo_dir";
+    FS_REMOVE_ALL(dir);
+    fs::create_directory(dir);
+    std::string err;
+    REQUIRE_FALSE(git::get_local_hash(dir, &err));
+    REQUIRE(err.find("repository") != std::string::npos);
+    err.clear();
+    REQUIRE_FALSE(git::get_current_branch(dir, &err));
+    REQUIRE(err.find("repository") != std::string::npos);
+    FS_REMOVE_ALL(dir);
+}
+
 TEST_CASE("get_remote_hash surfaces error for missing remote") {
     git::GitInitGuard guard;
     fs::path repo = fs::temp_directory_path() / "missing_remote_repo";
@@ -57,11 +74,237 @@ TEST_CASE("Git utils local repo") {
     FS_REMOVE_ALL(repo);
 }
 
+TEST_CASE("RepoSession reuses one repository handle") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo = fs::temp_directory_path() / "repo_session_test_repo";
+    FS_REMOVE_ALL(repo);
+    fs::create_directory(repo);
+    REQUIRE(std::system(("git init " + repo.string() + REDIR).c_str()) == 0);
+    (void)std::system((std::string("git -C ") + repo.string() + " config user.email you@example.com").c_str());
+    (void)std::system((std::string("git -C ") + repo.string() + " config user.name tester").c_str());
+    std::ofstream(repo / "file.txt") << "hello";
+    (void)std::system((std::string("git -C ") + repo.string() + " add file.txt").c_str());
+    (void)std::system((std::string("git -C ") + repo.string() + " commit -m init" + REDIR).c_str());
+
+    git::RepoSession session(repo);
+    git_repository* handle = session.repo();
+    REQUIRE(handle != nullptr);
+    REQUIRE(session.local_hash().value_or("") == git::get_local_hash(repo).value_or(""));
+    REQUIRE(session.current_branch().value_or("") == git::get_current_branch(repo).value_or(""));
+    REQUIRE(session.last_commit_author() == "tester");
+    REQUIRE(session.last_commit_time() == git::get_last_commit_time(repo));
+    REQUIRE_FALSE(session.has_uncommitted_changes());
+    std::ofstream(repo / "file.txt") << "changed";
+    REQUIRE(session.has_uncommitted_changes());
+    REQUIRE(session.repo() == handle);
+
+    git::RepoSession missing(fs::temp_directory_path() / "repo_session_missing");
+    std::string err;
+    REQUIRE_FALSE(missing.local_hash(&err));
+    REQUIRE(!err.empty());
+    FS_REMOVE_ALL(repo);
+}
+
+TEST_CASE("CommitInfoCache refreshes when HEAD moves") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo = fs::temp_directory_path() / "commit_info_cache_repo";
+    FS_REMOVE_ALL(repo);
+    fs::create_directory(repo);
+    REQUIRE(std::system(("git init " + repo.string() + REDIR).c_str()) == 0);
+    (void)std::system((std::string("git -C ") + repo.string() + " config user.email you@example.com").c_str());
+    (void)std::system((std::string("git -C ") + repo.string() + " config user.name tester").c_str());
+    std::ofstream(repo / "file.txt") << "hello";
+    (void)std::system((std::string("git -C ") + repo.string() + " add file.txt").c_str());
+    (void)std::system((std::string("git -C ") + repo.string() + " commit -m init" + REDIR).c_str());
+
+    git::CommitInfoCache cache;
+    git::RepoSession first(repo);
+    git::CommitInfo a = cache.get(first);
+    REQUIRE(a.oid == first.local_hash().value_or(""));
+    REQUIRE(a.author == "tester");
+    REQUIRE(a.time == git::get_last_commit_time(repo));
+    REQUIRE(cache.size() == 1);
+    git::RepoSession again(repo);
+    REQUIRE(cache.get(again).oid == a.oid);
+    REQUIRE(cache.size() == 1);
+
+    std::ofstream(repo / "file.txt") << "changed";
+    (void)std::system((std::string("git -C ") + repo.string() +
+                       " -c user.name=other commit -am second" + REDIR)
+                          .c_str());
+    git::RepoSession moved(repo);
+    git::CommitInfo b = cache.get(moved);
+    REQUIRE(b.oid != a.oid);
+    REQUIRE(b.author == "other");
+    REQUIRE(cache.size() == 1);
+    cache.retain({repo});
+    REQUIRE(cache.size() == 1);
+    cache.retain({});
+    REQUIRE(cache.size() == 0);
+    FS_REMOVE_ALL(repo);
+}
+
+TEST_CASE("maintain_packs indexes accumulated packs") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo = fs::temp_directory_path() / "pack_maintenance_repo";
+    FS_REMOVE_ALL(repo);
+    fs::create_directory(repo);
+    REQUIRE(std::system(("git init " + repo.string() + REDIR).c_str()) == 0);
+    (void)std::system((std::string("git -C ") + repo.string() + " config user.email you@example.com").c_str());
+    (void)std::system((std::string("git -C ") + repo.string() + " config user.name tester").c_str());
+    // Each incremental repack leaves one more pack, like a fetch does
+    for (int i = 0; i < 3; ++i) {
+        std::ofstream(repo / "file.txt") << "rev " << i;
+        (void)std::system((std::string("git -C ") + repo.string() + " add file.txt").c_str());
+        (void)std::system((std::string("git -C ") + repo.string() + " commit -m c" +
+                           std::to_string(i) + REDIR)
+                              .c_str());
+        (void)std::system((std::string("git -C ") + repo.string() + " repack -q" + REDIR).c_str());
+    }
+
+    git::RepoSession session(repo);
+    git::PackStats stats = session.pack_stats();
+    REQUIRE(stats.packs == 3);
+    REQUIRE(stats.unindexed_packs == 3);
+    git::PackMaintenance policy{true, 5, 0};
+    REQUIRE_FALSE(session.maintain_packs(policy, stats));
+    policy.max_packs = 2;
+    std::string err;
+    REQUIRE(session.maintain_packs(policy, stats, &err));
+    REQUIRE(err.empty());
+    REQUIRE(fs::exists(repo / ".git" / "objects" / "pack" / "multi-pack-index"));
+    REQUIRE(stats.packs == 3);
+    REQUIRE(stats.unindexed_packs == 0);
+    REQUIRE(session.local_hash().value_or("").size() == 40);
+    FS_REMOVE_ALL(repo);
+}
+
+TEST_CASE("dirty check covers staged and untracked changes") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path repo = fs::temp_directory_path() / "dirty_probe_repo";
+    FS_REMOVE_ALL(repo);
+    fs::create_directory(repo);
+    REQUIRE(std::system(("git init " + repo.string() + REDIR).c_str()) == 0);
+    (void)std::system((std::string("git -C ") + repo.string() + " config user.email you@example.com").c_str());
+    (void)std::system((std::string("git -C ") + repo.string() + " config user.name tester").c_str());
+    std::ofstream(repo / "file.txt") << "hello";
+    (void)std::system((std::string("git -C ") + repo.string() + " add file.txt").c_str());
+    (void)std::system((std::string("git -C ") + repo.string() + " commit -m init" + REDIR).c_str());
+
+    REQUIRE_FALSE(git::has_uncommitted_changes(repo));
+    fs::create_directories(repo / "untracked" / "nested");
+    std::ofstream(repo / "untracked" / "nested" / "a.txt") << "a";
+    REQUIRE(git::has_uncommitted_changes(repo));
+    FS_REMOVE_ALL(repo / "untracked");
+    REQUIRE_FALSE(git::has_uncommitted_changes(repo));
+    // A new directory holding only ignored files is clean, as in git status
+    std::ofstream(repo / ".git" / "info" / "exclude", std::ios::app) << "*.log\n";
+    fs::create_directories(repo / "logs" / "old");
+    std::ofstream(repo / "logs" / "run.log") << "log";
+    std::ofstream(repo / "logs" / "old" / "run.log") << "log";
+    REQUIRE_FALSE(git::has_uncommitted_changes(repo));
+    FS_REMOVE_ALL(repo / "logs");
+
+    std::ofstream(repo / "file.txt") << "staged";
+    (void)std::system((std::string("git -C ") + repo.string() + " add file.txt").c_str());
+    REQUIRE(git::has_uncommitted_changes(repo));
+    (void)std::system((std::string("git -C ") + repo.string() + " reset --hard" + REDIR).c_str());
+
+    git::set_status_cache(true);
+    std::ofstream(repo / "file.txt") << "hello"; // same content, new mtime
+    REQUIRE_FALSE(git::has_uncommitted_changes(repo));
+    REQUIRE_FALSE(git::has_uncommitted_changes(repo));
+    git::set_status_cache(false);
+    FS_REMOVE_ALL(repo);
+}
+
 TEST_CASE("Git utils GitHub url detection") {
     REQUIRE(git::is_github_url("https://github.com/user/repo.git"));
     REQUIRE_FALSE(git::is_github_url("https://gitlab.com/user/repo.git"));
 }
 
+TEST_CASE("Git utils url host extraction") {
+    REQUIRE(git::url_host("https://GitHub.com/user/repo.git") == "github.com");
+    REQUIRE(git::url_host("https://user:pw@gitlab.internal:8443/g/r.git") == "gitlab.internal");
+    REQUIRE(git::url_host("ssh://git@gitea.lan:2222/r.git") == "gitea.lan");
+    REQUIRE(git::url_host("git@github.com:user/repo.git") == "github.com");
+    REQUIRE(git::url_host("https://[::1]:3000/r.git") == "::1");
+    REQUIRE(git::url_host("/srv/git/repo.git").empty());
+    REQUIRE(git::url_host("file:///srv/git/repo.git").empty());
+    REQUIRE(git::url_host("C:\\repos\\r.git").empty());
+    REQUIRE(git::url_host("../sibling:odd").empty());
+}
+
+TEST_CASE("Git utils remote URL normalisation") {
+    REQUIRE(git::normalize_remote_url("HTTPS://GitHub.com/User/Repo.git/") ==
+            "https://github.com/User/Repo");
+    REQUIRE(git::normalize_remote_url("https://github.com/User/Repo") ==
+            git::normalize_remote_url("https://GITHUB.COM/User/Repo.git"));
+    REQUIRE(git::normalize_remote_url("git@GitHub.com:User/Repo.git") == "git@github.com:User/Repo");
+    REQUIRE(git::normalize_remote_url("ssh://Deploy@Gitea.lan:2222/r.git") ==
+            "ssh://Deploy@gitea.lan:2222/r");
+    REQUIRE(git::normalize_remote_url("/srv/Git/Repo.git") == "/srv/Git/Repo");
+}
+
+TEST_CASE("Git utils fetch error classification") {
+    using git::FetchError;
+    int status = 0;
+    REQUIRE(git::classify_fetch_error(-1, GIT_ERROR_HTTP, "unexpected http status code: 429",
+                                      &status) == FetchError::RateLimit);
+    REQUIRE(status == 429);
+    REQUIRE(git::classify_fetch_error(-1, GIT_ERROR_HTTP, "unexpected http status code: 503",
+                                      &status) == FetchError::Server);
+    REQUIRE(status == 503);
+    REQUIRE(git::classify_fetch_error(-1, GIT_ERROR_HTTP, "unexpected http status code: 404") ==
+            FetchError::NotFound);
+    REQUIRE(git::classify_fetch_error(GIT_EAUTH, GIT_ERROR_HTTP, "too many redirects") ==
+            FetchError::Auth);
+    REQUIRE(git::classify_fetch_error(GIT_ECERTIFICATE, GIT_ERROR_SSL, "bad cert") ==
+            FetchError::Tls);
+    REQUIRE(git::classify_fetch_error(-1, GIT_ERROR_NET,
+                                      "failed to resolve address for nohost: Name or service "
+                                      "not known") == FetchError::Dns);
+    REQUIRE(git::classify_fetch_error(-1, GIT_ERROR_NET, "read timed out") ==
+            FetchError::Timeout);
+    REQUIRE(git::classify_fetch_error(-1, GIT_ERROR_OS, "connection reset by peer") ==
+            FetchError::Network);
+    REQUIRE(git::classify_fetch_error(-1, GIT_ERROR_ODB, "object missing") == FetchError::Other);
+    REQUIRE(git::classify_fetch_error(-1, GIT_ERROR_SSL, "SSL read timed out") ==
+            FetchError::Timeout);
+    REQUIRE(git::classify_fetch_error(-1, GIT_ERROR_INVALID, "invalid author in signature") ==
+            FetchError::Other);
+    REQUIRE(git::classify_fetch_error(-1, GIT_ERROR_CALLBACK, "authentication required") ==
+            FetchError::Auth);
+    REQUIRE(git::is_transient(FetchError::RateLimit));
+    REQUIRE_FALSE(git::is_transient(FetchError::Auth));
+}
+
+TEST_CASE("Git utils retry hints") {
+    REQUIRE(git::parse_retry_hint("Retry-After: 120") == std::chrono::seconds(120));
+    REQUIRE(git::parse_retry_hint("remote: rate limited, try again in 5 minutes") ==
+            std::chrono::seconds(300));
+    REQUIRE(git::parse_retry_hint("retry in 2h") == std::chrono::seconds(7200));
+    REQUIRE(git::parse_retry_hint("retry after 30s") == std::chrono::seconds(30));
+    REQUIRE(git::parse_retry_hint("unexpected http status code: 429") ==
+            std::chrono::seconds(0));
+}
+
 static void create_seed_remote(fs::path& remote, fs::path& seed, const std::string& content) {
     auto suffix = std::to_string(
         static_cast<unsigned long long>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
@@ -104,6 +347,43 @@ TEST_CASE("clone_repo clones a local repository") {
     FS_REMOVE_ALL(remote);
 }
 
+TEST_CASE("clone_manifest_repo clones the requested branch") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path remote;
+    fs::path seed;
+    create_seed_remote(remote, seed, "hello world\n");
+    (void)std::system((std::string("git -C ") + seed.string() + " checkout -b stable" REDIR).c_str());
+    REQUIRE(std::system((std::string("git -C ") + seed.string() + " push origin stable" + REDIR)
+                            .c_str()) == 0);
+
+    fs::path dest = fs::temp_directory_path() / "clone_manifest_test" / "nested" / "repo";
+    FS_REMOVE_ALL(dest.parent_path().parent_path());
+    ManifestEntry entry{remote.string(), dest, "stable", 0};
+    std::map<fs::path, RepoInfo> infos;
+    std::mutex mtx;
+    std::mutex action_mtx;
+    std::string action;
+    REQUIRE(clone_manifest_repo(entry, infos, mtx, action, action_mtx, git::FetchParams{}, true,
+                                false));
+    REQUIRE(git::is_git_repo(dest));
+    REQUIRE(infos[dest].status == RS_PULL_OK);
+    REQUIRE(infos[dest].branch == "stable");
+
+    ManifestEntry bad{(fs::temp_directory_path() / "no_such_remote.git").string(),
+                      dest.parent_path() / "bad", "", 0};
+    REQUIRE_FALSE(clone_manifest_repo(bad, infos, mtx, action, action_mtx, git::FetchParams{},
+                                      true, false));
+    REQUIRE(infos[bad.path].status == RS_ERROR);
+
+    FS_REMOVE_ALL(dest.parent_path().parent_path());
+    FS_REMOVE_ALL(seed);
+    FS_REMOVE_ALL(remote);
+}
+
 TEST_CASE("clone_repo reports progress and respects limits") {
     if (!have_git()) {
         WARN("git not available; skipping");
@@ -136,6 +416,49 @@ TEST_CASE("clone_repo reports progress and respects limits") {
     FS_REMOVE_ALL(remote);
 }
 
+TEST_CASE("clone_repo charges the traffic budget and classifies failures") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path remote;
+    fs::path seed;
+    create_seed_remote(remote, seed, std::string(256 * 1024, 'b'));
+
+    fs::path dest = fs::temp_directory_path() / "clone_repo_budget";
+    FS_REMOVE_ALL(dest);
+    procutil::TrafficBudget budget(0, 0);
+    git::FetchParams params;
+    params.traffic_budget = &budget;
+    git::FetchResult cloned = git::clone_repo(dest, remote.string(), params);
+    REQUIRE(cloned.ok);
+    REQUIRE(budget.cycle_used() == cloned.received_bytes);
+    if (cloned.received_bytes == 0)
+        WARN("libgit2 did not report received bytes; skipping budget assertion");
+
+    git::FetchResult missing = git::clone_repo(
+        fs::temp_directory_path() / "clone_repo_missing",
+        (fs::temp_directory_path() / "no_such_clone_remote.git").string(), params);
+    REQUIRE_FALSE(missing.ok);
+    REQUIRE(missing.kind != git::FetchError::None);
+    REQUIRE_FALSE(missing.auth_failed);
+    REQUIRE_FALSE(missing.error.empty());
+
+    std::atomic<bool> running{false};
+    params.running = &running;
+    git::FetchResult stopped =
+        git::clone_repo(fs::temp_directory_path() / "clone_repo_stopped", remote.string(), params);
+    REQUIRE_FALSE(stopped.ok);
+    REQUIRE(stopped.cancelled);
+    REQUIRE(stopped.kind == git::FetchError::Cancelled);
+
+    FS_REMOVE_ALL(dest);
+    FS_REMOVE_ALL(fs::temp_directory_path() / "clone_repo_stopped");
+    FS_REMOVE_ALL(seed);
+    FS_REMOVE_ALL(remote);
+}
+
 TEST_CASE("RepoInfo defaults") {
     RepoInfo ri;
     REQUIRE(ri.status == RS_PENDING);
@@ -300,7 +623,7 @@ TEST_CASE("scan_repos respects concurrency limit") {
 
     std::map<fs::path, RepoInfo> infos;
     for (const auto& p : repos)
-        infos[p] = RepoInfo{p, RS_PENDING, "", "", "", "", "", 0, "", 0, false, false};
+        infos[p] = RepoInfo{};
     std::set<fs::path> skip;
     std::mutex mtx;
     std::atomic<bool> scanning(true);
@@ -313,10 +636,11 @@ TEST_CASE("scan_repos respects concurrency limit") {
     std::size_t max_seen = baseline;
 
     std::thread t([&]() {
-        scan_repos(repos, infos, skip, mtx, scanning, running, act, act_mtx, false, "origin",
-                   fs::path(), true, true, concurrency, 0, 0, 0, 0, 0, true, false, false, false,
-                   true, true, false, fs::path(), std::nullopt, std::chrono::seconds(0), false,
-                   std::chrono::seconds(0), false, false, {}, false);
+        ScanOptions scan;
+        scan.check_only = true;
+        scan.concurrency = concurrency;
+        scan.silent = true;
+        scan_repos(repos, infos, skip, mtx, scanning, running, act, act_mtx, scan);
     });
     while (scanning) {
         max_seen = std::max(max_seen, read_thread_count());
@@ -330,6 +654,310 @@ TEST_CASE("scan_repos respects concurrency limit") {
         FS_REMOVE_ALL(p);
 }
 
+TEST_CASE("scan_repos pulls through separate stages") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path remote;
+    fs::path seed;
+    create_seed_remote(remote, seed, "hello\n");
+    std::vector<fs::path> repos;
+    for (int i = 0; i < 3; ++i) {
+        fs::path repo = fs::temp_directory_path() / ("stages_repo_" + std::to_string(i));
+        FS_REMOVE_ALL(repo);
+        REQUIRE(std::system(("git clone " + remote.string() + " " + repo.string() + REDIR)
+                                .c_str()) == 0);
+        repos.push_back(repo);
+    }
+    std::ofstream(seed / "file.txt") << "hello again\n";
+    (void)std::system((std::string("git -C ") + seed.string() + " commit -am update" + REDIR).c_str());
+    REQUIRE(std::system((std::string("git -C ") + seed.string() + " push origin master" + REDIR)
+                            .c_str()) == 0);
+
+    fs::path marker = fs::temp_directory_path() / "stages_hook_marker";
+    FS_REMOVE(marker);
+#if defined(_WIN32)
+    fs::path hook = fs::temp_directory_path() / "stages_hook.bat";
+    {
+        std::ofstream ofs(hook);
+        ofs << "@echo off\n";
+        ofs << "echo ran >> \"" << marker.string() << "\"\n";
+    }
+#else
+    fs::path hook = fs::temp_directory_path() / "stages_hook.sh";
+    {
+        std::ofstream ofs(hook);
+        ofs << "#!/bin/sh\n";
+        ofs << "echo ran >> \"" << marker.string() << "\"\n";
+    }
+    fs::permissions(hook, fs::perms::owner_exec | fs::perms::owner_write | fs::perms::owner_read);
+#endif
+
+    std::map<fs::path, RepoInfo> infos;
+    for (const auto& p : repos)
+        infos[p] = RepoInfo{};
+    std::set<fs::path> skip;
+    std::mutex mtx;
+    std::atomic<bool> scanning(true);
+    std::atomic<bool> running(true);
+    std::string act;
+    std::mutex act_mtx;
+    procutil::StageLimits stages;
+    stages.fetch = 2;
+    stages.checkout = 1;
+    stages.hook = 1;
+    procutil::PipelineStats stats;
+    ScanOptions scan;
+    scan.include_private = true;
+    scan.silent = true;
+    scan.post_pull_hook = hook;
+    scan.need_commit_info = false;
+    scan.stages = stages;
+    scan.pipeline_stats = &stats;
+    scan_repos(repos, infos, skip, mtx, scanning, running, act, act_mtx, scan);
+
+    for (const auto& p : repos) {
+        REQUIRE(infos[p].status == RS_PULL_OK);
+        std::ifstream in(p / "file.txt");
+        std::string line;
+        std::getline(in, line);
+        REQUIRE(line == "hello again");
+    }
+    std::ifstream hook_log(marker);
+    std::string line;
+    int hooks = 0;
+    while (std::getline(hook_log, line))
+        ++hooks;
+    REQUIRE(hooks == 3);
+    REQUIRE_FALSE(stats.active());
+    REQUIRE(stats[procutil::ScanStage::Fetch].workers == 2);
+    REQUIRE(stats[procutil::ScanStage::Fetch].queued == 0);
+
+    hook_log.close();
+    FS_REMOVE(marker);
+    FS_REMOVE(hook);
+    for (const auto& p : repos)
+        FS_REMOVE_ALL(p);
+    FS_REMOVE_ALL(seed);
+    FS_REMOVE_ALL(remote);
+}
+
+TEST_CASE("scan state follows a repointed remote") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path remote;
+    fs::path seed;
+    create_seed_remote(remote, seed, "hello\n");
+    fs::path moved = fs::temp_directory_path() / "repointed_remote.git";
+    fs::path repo = fs::temp_directory_path() / "repointed_repo";
+    FS_REMOVE_ALL(moved);
+    FS_REMOVE_ALL(repo);
+    REQUIRE(std::system(("git clone --bare " + remote.string() + " " + moved.string() + REDIR)
+                            .c_str()) == 0);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + repo.string() + REDIR).c_str()) ==
+            0);
+
+    std::vector<fs::path> repos{repo};
+    std::map<fs::path, RepoInfo> infos;
+    infos[repo] = RepoInfo{};
+    std::set<fs::path> skip;
+    std::mutex mtx;
+    std::atomic<bool> scanning(true);
+    std::atomic<bool> running(true);
+    std::string act;
+    std::mutex act_mtx;
+    ScanState state;
+    ScanOptions options;
+    options.include_private = true;
+    options.check_only = true;
+    options.silent = true;
+    options.need_commit_info = false;
+    options.state = &state;
+    auto scan = [&]() {
+        scan_repos(repos, infos, skip, mtx, scanning, running, act, act_mtx, options);
+    };
+    scan();
+    REQUIRE(state.repo_urls[repo] == remote.string());
+
+    REQUIRE(std::system(("git -C " + repo.string() + " remote set-url origin " + moved.string())
+                            .c_str()) == 0);
+    scan();
+    REQUIRE(state.repo_urls[repo] == moved.string());
+
+    FS_REMOVE_ALL(repo);
+    FS_REMOVE_ALL(moved);
+    FS_REMOVE_ALL(seed);
+    FS_REMOVE_ALL(remote);
+}
+
+TEST_CASE("pack maintenance only visits repositories that fetched") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path remote;
+    fs::path seed;
+    create_seed_remote(remote, seed, "hello\n");
+    fs::path behind = fs::temp_directory_path() / "maintain_behind_repo";
+    fs::path current = fs::temp_directory_path() / "maintain_current_repo";
+    FS_REMOVE_ALL(behind);
+    FS_REMOVE_ALL(current);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + behind.string() + REDIR)
+                            .c_str()) == 0);
+    std::ofstream(seed / "file.txt") << "hello again\n";
+    (void)std::system((std::string("git -C ") + seed.string() + " commit -am update" + REDIR).c_str());
+    REQUIRE(std::system((std::string("git -C ") + seed.string() + " push origin master" + REDIR)
+                            .c_str()) == 0);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + current.string() + REDIR)
+                            .c_str()) == 0);
+
+    std::vector<fs::path> repos{behind, current};
+    std::map<fs::path, RepoInfo> infos;
+    for (const auto& p : repos)
+        infos[p] = RepoInfo{};
+    std::set<fs::path> skip;
+    std::mutex mtx;
+    std::atomic<bool> scanning(true);
+    std::atomic<bool> running(true);
+    std::string act;
+    std::mutex act_mtx;
+    ScanState state;
+    ScanOptions scan;
+    scan.include_private = true;
+    scan.silent = true;
+    scan.need_commit_info = false;
+    scan.maintenance = {true, 0, 0}; // count only
+    scan.state = &state;
+    scan_repos(repos, infos, skip, mtx, scanning, running, act, act_mtx, scan);
+
+    REQUIRE(infos[behind].status == RS_PULL_OK);
+    REQUIRE(infos[behind].pack_count > 0);
+    REQUIRE(infos[current].pack_count == 0);
+    REQUIRE(state.maintenance_due.empty());
+    REQUIRE(state.maintained.count(behind) == 1);
+    REQUIRE(state.maintained.count(current) == 0);
+
+    FS_REMOVE_ALL(behind);
+    FS_REMOVE_ALL(current);
+    FS_REMOVE_ALL(seed);
+    FS_REMOVE_ALL(remote);
+}
+
+TEST_CASE("pack maintenance finishes before a last scan returns") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path remote;
+    fs::path seed;
+    create_seed_remote(remote, seed, "hello\n");
+    fs::path repo = fs::temp_directory_path() / "maintain_last_scan_repo";
+    FS_REMOVE_ALL(repo);
+    REQUIRE(std::system(("git clone " + remote.string() + " " + repo.string() + REDIR)
+                            .c_str()) == 0);
+    std::ofstream(seed / "file.txt") << "hello again\n";
+    (void)std::system((std::string("git -C ") + seed.string() + " commit -am update" + REDIR).c_str());
+    REQUIRE(std::system((std::string("git -C ") + seed.string() + " push origin master" + REDIR)
+                            .c_str()) == 0);
+
+    std::vector<fs::path> repos{repo};
+    std::map<fs::path, RepoInfo> infos;
+    infos[repo] = RepoInfo{};
+    std::set<fs::path> skip;
+    std::mutex mtx;
+    std::atomic<bool> scanning(true);
+    std::atomic<bool> running(true);
+    std::string act;
+    std::mutex act_mtx;
+    procutil::WorkerPool pool(2);
+    ScanState state;
+    ScanOptions scan;
+    scan.include_private = true;
+    scan.silent = true;
+    scan.need_commit_info = false;
+    scan.maintenance = {true, 0, 0}; // count only
+    scan.pool = &pool;
+    scan.state = &state;
+    scan.last_scan = true;
+    scan_repos(repos, infos, skip, mtx, scanning, running, act, act_mtx, scan);
+    // A single run stops the loop as soon as the scan returns
+    running = false;
+
+    REQUIRE(infos[repo].status == RS_PULL_OK);
+    REQUIRE(infos[repo].pack_count > 0);
+    REQUIRE(state.maintained.count(repo) == 1);
+
+    FS_REMOVE_ALL(repo);
+    FS_REMOVE_ALL(seed);
+    FS_REMOVE_ALL(remote);
+}
+
+TEST_CASE("scan_repos admits only repositories that fall due") {
+    if (!have_git()) {
+        WARN("git not available; skipping");
+        return;
+    }
+    git::GitInitGuard guard;
+    fs::path remote;
+    fs::path seed;
+    create_seed_remote(remote, seed, "hello\n");
+    fs::path due_now = fs::temp_directory_path() / "due_now_repo";
+    fs::path due_soon = fs::temp_directory_path() / "due_soon_repo";
+    fs::path due_later = fs::temp_directory_path() / "due_later_repo";
+    std::vector<fs::path> repos{due_now, due_soon, due_later};
+    std::map<fs::path, RepoInfo> infos;
+    for (const auto& p : repos) {
+        FS_REMOVE_ALL(p);
+        REQUIRE(std::system(("git clone " + remote.string() + " " + p.string() + REDIR)
+                                .c_str()) == 0);
+        infos[p] = RepoInfo{.message = "Earlier result", .status = RS_PULL_OK};
+    }
+    std::set<fs::path> skip;
+    std::mutex mtx;
+    std::atomic<bool> scanning(true);
+    std::atomic<bool> running(true);
+    std::string act;
+    std::mutex act_mtx;
+    procutil::DueScheduler due(std::chrono::seconds(1), std::chrono::seconds(10));
+    auto start = std::chrono::steady_clock::now();
+    // One second intervals: the first is overdue, the second falls due
+    // within the scan's horizon and the third an hour from now
+    due.started(due_now, start - std::chrono::seconds(2));
+    due.started(due_soon, start - std::chrono::milliseconds(500));
+    due.defer(due_later, start + std::chrono::hours(1));
+    auto soon_at = due.due_at(due_soon, start);
+    auto later_at = due.due_at(due_later, start);
+    ScanOptions scan;
+    scan.include_private = true;
+    scan.check_only = true;
+    scan.concurrency = 2;
+    scan.silent = true;
+    scan.need_commit_info = false;
+    scan.due = &due;
+    scan_repos(repos, infos, skip, mtx, scanning, running, act, act_mtx, scan);
+
+    REQUIRE(infos[due_now].status == RS_UP_TO_DATE);
+    REQUIRE(infos[due_soon].status == RS_UP_TO_DATE);
+    // The repository falling due later was parked until its due time
+    REQUIRE(std::chrono::steady_clock::now() >= soon_at);
+    // The one not due within the horizon was left alone
+    REQUIRE(infos[due_later].status == RS_PULL_OK);
+    REQUIRE(infos[due_later].message == "Earlier result");
+    REQUIRE(due.due_at(due_later, start) == later_at);
+
+    for (const auto& p : repos)
+        FS_REMOVE_ALL(p);
+    FS_REMOVE_ALL(seed);
+    FS_REMOVE_ALL(remote);
+}
+
 TEST_CASE("try_pull handles dirty repos") {
     if (!have_git()) {
         WARN("git not available; skipping");
@@ -388,7 +1016,6 @@ TEST_CASE("scan_repos resets statuses to pending") {
     std::map<fs::path, RepoInfo> infos;
     fs::path p = fs::temp_directory_path() / "pending_status_repo";
     RepoInfo ri;
-    ri.path = p;
     ri.status = RS_PULL_OK;
     ri.message = "done";
     infos[p] = ri;
@@ -399,10 +1026,10 @@ TEST_CASE("scan_repos resets statuses to pending") {
     std::string act;
     std::mutex act_mtx;
 
-    scan_repos({}, infos, skip, mtx, scanning, running, act, act_mtx, false, "origin", fs::path(),
-               true, true, 1, 0, 0, 0, 0, 0, true, false, false, false, true, true, false,
-               fs::path(), std::nullopt, std::chrono::seconds(0), false, std::chrono::seconds(0),
-               false, false, {}, false);
+    ScanOptions scan;
+    scan.check_only = true;
+    scan.silent = true;
+    scan_repos({}, infos, skip, mtx, scanning, running, act, act_mtx, scan);
 
     REQUIRE(infos[p].status == RS_PENDING);
     REQUIRE(infos[p].progress == 0);
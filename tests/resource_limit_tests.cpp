@@ -1,4 +1,6 @@
 #include "test_common.hpp"
+#include "bandwidth_limiter.hpp"
+#include "traffic_budget.hpp"
 #include <random>
 #include <string>
 
@@ -93,3 +95,78 @@ TEST_CASE("rate limits throttle git pull") {
     FS_REMOVE_ALL(repo_base);
     FS_REMOVE_ALL(repo_limited);
 }
+
+TEST_CASE("shared bandwidth limiter schedules workers in turn") {
+    using namespace std::chrono;
+    procutil::BandwidthLimiter idle(0, 0, 0);
+    REQUIRE_FALSE(idle.active());
+    auto start = procutil::BandwidthLimiter::clock::now();
+    REQUIRE(idle.charge_download(1024 * 1024) <= procutil::BandwidthLimiter::clock::now());
+
+    procutil::BandwidthLimiter limiter(100, 0, 0); // 100 KiB/s shared
+    REQUIRE(limiter.active());
+    // Two workers each report 50 KiB; the second waits for the first's share
+    auto first = limiter.charge_download(50 * 1024);
+    auto second = limiter.charge_download(50 * 1024);
+    REQUIRE(second - first >= milliseconds(450));
+    REQUIRE(second - start >= milliseconds(800));
+    REQUIRE(second - start <= milliseconds(1200));
+}
+
+TEST_CASE("shared bandwidth limiter charges counter growth once") {
+    using namespace std::chrono;
+    procutil::BandwidthLimiter limiter(0, 100, 0);
+    REQUIRE(limiter.limits_upload());
+    auto start = procutil::BandwidthLimiter::clock::now();
+    limiter.charge_upload_total(50 * 1024);
+    // A second worker observing the same counter value adds nothing
+    auto same = limiter.charge_upload_total(50 * 1024);
+    REQUIRE(same - start <= milliseconds(600));
+    auto grown = limiter.charge_upload_total(100 * 1024);
+    REQUIRE(grown - start >= milliseconds(800));
+}
+
+TEST_CASE("traffic budget defers after the cycle allowance") {
+    procutil::TrafficBudget none(0, 0);
+    REQUIRE_FALSE(none.active());
+    none.add(1024 * 1024);
+    REQUIRE_FALSE(none.exhausted());
+
+    procutil::TrafficBudget budget(1000, 0);
+    REQUIRE(budget.active());
+    budget.add(600);
+    REQUIRE_FALSE(budget.exhausted());
+    budget.add(400);
+    REQUIRE(budget.exhausted());
+    // The next scan starts with a fresh cycle allowance
+    budget.begin_cycle();
+    REQUIRE_FALSE(budget.exhausted());
+    REQUIRE(budget.cycle_used() == 0);
+    REQUIRE(budget.day_used() == 1000);
+}
+
+TEST_CASE("traffic budget takes new limits and keeps its counters") {
+    procutil::TrafficBudget budget(1000, 0);
+    budget.add(800);
+    REQUIRE_FALSE(budget.exhausted());
+    budget.set_limits(500, 2000);
+    REQUIRE(budget.cycle_limit() == 500);
+    REQUIRE(budget.daily_limit() == 2000);
+    REQUIRE(budget.exhausted());
+    REQUIRE(budget.cycle_used() == 800);
+    budget.set_limits(0, 0);
+    REQUIRE_FALSE(budget.active());
+    REQUIRE_FALSE(budget.exhausted());
+    REQUIRE(budget.day_used() == 800);
+}
+
+TEST_CASE("traffic budget daily allowance spans cycles") {
+    procutil::TrafficBudget budget(0, 1500);
+    budget.add(1000);
+    budget.begin_cycle();
+    REQUIRE_FALSE(budget.exhausted());
+    budget.add(500);
+    REQUIRE(budget.exhausted());
+    budget.begin_cycle();
+    REQUIRE(budget.exhausted());
+}
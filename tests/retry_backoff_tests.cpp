@@ -0,0 +1,36 @@
+#include "test_common.hpp"
+#include "retry_backoff.hpp"
+
+using namespace std::chrono;
+
+TEST_CASE("retry backoff doubles with jitter") {
+    procutil::RetryBackoff backoff(seconds(4), seconds(60));
+    fs::path repo = "/repos/a";
+    auto now = procutil::RetryBackoff::clock::now();
+    REQUIRE(backoff.remaining(repo, now) == seconds(0));
+    auto first = backoff.failure(repo, seconds(0), now);
+    REQUIRE(first - now >= seconds(2));
+    REQUIRE(first - now <= seconds(4));
+    auto second = backoff.failure(repo, seconds(0), now);
+    REQUIRE(second - now >= seconds(4));
+    REQUIRE(second - now <= seconds(8));
+    for (int i = 0; i < 10; ++i)
+        backoff.failure(repo, seconds(0), now);
+    REQUIRE(backoff.remaining(repo, now) <= seconds(60));
+    REQUIRE(backoff.remaining(repo, now) >= seconds(30));
+    REQUIRE(backoff.attempts(repo) == 12u);
+    REQUIRE(backoff.remaining(repo, now + seconds(61)) == seconds(0));
+    backoff.success(repo);
+    REQUIRE(backoff.attempts(repo) == 0u);
+    REQUIRE(backoff.remaining(repo, now) == seconds(0));
+}
+
+TEST_CASE("retry backoff honours server hints") {
+    procutil::RetryBackoff backoff(seconds(4), seconds(60));
+    fs::path repo = "/repos/b";
+    auto now = procutil::RetryBackoff::clock::now();
+    auto until = backoff.failure(repo, seconds(300), now);
+    REQUIRE(until - now == seconds(300));
+    REQUIRE(backoff.remaining(repo, now) == seconds(300));
+    REQUIRE(backoff.remaining("/repos/other", now) == seconds(0));
+}
@@ -0,0 +1,75 @@
+#include "test_common.hpp"
+#include "scan_pipeline.hpp"
+
+TEST_CASE("BoundedQueue holds producers back when full") {
+    procutil::BoundedQueue<int> q(2);
+    REQUIRE(q.capacity() == 2);
+    REQUIRE(q.push(1));
+    REQUIRE(q.push(2));
+    std::atomic<bool> pushed{false};
+    std::thread producer([&]() {
+        q.push(3);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE_FALSE(pushed);
+    int v = 0;
+    REQUIRE(q.pop(v));
+    REQUIRE(v == 1);
+    producer.join();
+    REQUIRE(pushed);
+    REQUIRE(q.size() == 2);
+}
+
+TEST_CASE("BoundedQueue drains after close") {
+    procutil::BoundedQueue<int> q(4);
+    REQUIRE(q.push(1));
+    q.close();
+    REQUIRE_FALSE(q.push(2));
+    int v = 0;
+    REQUIRE(q.pop(v));
+    REQUIRE(v == 1);
+    REQUIRE_FALSE(q.pop(v));
+
+    // A closed queue wakes consumers waiting on it
+    procutil::BoundedQueue<int> idle(1);
+    std::thread consumer([&]() {
+        int x = 0;
+        REQUIRE_FALSE(idle.pop(x));
+    });
+    idle.close();
+    consumer.join();
+}
+
+TEST_CASE("StageLimits keeps unset stages on the previous stage's workers") {
+    procutil::StageLimits limits;
+    auto workers = limits.workers(4);
+    REQUIRE(workers[0] == 4);
+    REQUIRE(workers[1] == 0);
+    REQUIRE(workers[2] == 0);
+    REQUIRE(workers[3] == 0);
+    limits.fetch = 8;
+    limits.checkout = 2;
+    workers = limits.workers(4);
+    REQUIRE(workers[1] == 8);
+    REQUIRE(workers[2] == 2);
+    REQUIRE(workers[3] == 0);
+}
+
+TEST_CASE("PipelineStats resets per scan") {
+    procutil::PipelineStats stats;
+    REQUIRE_FALSE(stats.active());
+    stats.begin_scan({2, 4, 1, 0});
+    REQUIRE(stats.active());
+    REQUIRE(stats[procutil::ScanStage::Fetch].workers == 4);
+    stats[procutil::ScanStage::Fetch].busy_ms = 1000000;
+    double u = stats.utilisation(procutil::ScanStage::Fetch);
+    REQUIRE(u <= 1.0);
+    REQUIRE(stats.utilisation(procutil::ScanStage::Hook) == 0.0);
+    REQUIRE(std::string(procutil::PipelineStats::name(procutil::ScanStage::Checkout)) ==
+            "checkout");
+    stats.end_scan();
+    REQUIRE_FALSE(stats.active());
+    stats.begin_scan({1, 0, 0, 0});
+    REQUIRE(stats[procutil::ScanStage::Fetch].busy_ms == 0);
+}
@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "test_common.hpp"
+
+TEST_CASE("InternedString shares equal strings") {
+    InternedString a = std::string("feature/") + "pool";
+    InternedString b("feature/pool");
+    InternedString c("main");
+    REQUIRE(a == b);
+    REQUIRE(&a.str() == &b.str());
+    REQUIRE_FALSE(a == c);
+    REQUIRE(a == "feature/pool");
+    REQUIRE(c == std::string("main"));
+    const std::string& view = b;
+    REQUIRE(view == "feature/pool");
+    size_t pooled = InternedString::pool_size();
+    InternedString d("main");
+    REQUIRE(InternedString::pool_size() == pooled);
+}
+
+TEST_CASE("InternedString leaves the pool with its last handle") {
+    size_t before = InternedString::pool_size();
+    {
+        InternedString a("author-only-here");
+        REQUIRE(InternedString::pool_size() == before + 1);
+        InternedString b = a;
+        InternedString c;
+        c = b;
+        InternedString d = std::move(a);
+        REQUIRE(d == c);
+        a = "author-only-here";
+        REQUIRE(InternedString::pool_size() == before + 1);
+    }
+    REQUIRE(InternedString::pool_size() == before);
+
+    // Handles come and go from several threads while strings enter and
+    // leave the pool
+    std::atomic<bool> intact{true};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&intact]() {
+            for (int i = 0; i < 1000; ++i) {
+                std::string value = "shared-" + std::to_string(i % 7);
+                InternedString s(value);
+                InternedString copy = s;
+                if (copy != value)
+                    intact = false;
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+    REQUIRE(intact);
+    REQUIRE(InternedString::pool_size() == before);
+}
+
+TEST_CASE("InternedString defaults to empty") {
+    InternedString s;
+    REQUIRE(s.empty());
+    REQUIRE(s.size() == 0);
+    REQUIRE(s == "");
+    REQUIRE(InternedString("") == s);
+    RepoInfo ri;
+    ri.branch = "master";
+    std::ostringstream out;
+    out << ri.branch;
+    REQUIRE(out.str() == "master");
+}
+
+namespace {
+// Repository record as it was before the path copy was dropped, branch
+// names and authors interned and the small fields packed, for comparison.
+struct LegacyRepoInfo {
+    fs::path path;
+    int status = 0;
+    std::string message;
+    std::string branch;
+    std::string commit;
+    std::string commit_date;
+    std::string commit_author;
+    std::time_t commit_time = 0;
+    std::string last_pull_log;
+    int progress = 0;
+    bool auth_failed = false;
+    bool pulled = false;
+    size_t pack_count = 0;
+    size_t loose_objects = 0;
+};
+
+template <typename Info> size_t rss_per_repo(size_t count) {
+    static const char* branches[] = {"main", "master", "develop", "release/2024-q3"};
+    procutil::release_free_memory();
+    size_t before = procutil::read_memory_usage_kb();
+    std::map<fs::path, Info> infos;
+    for (size_t i = 0; i < count; ++i) {
+        fs::path p = fs::path("/srv/repositories") / ("group-" + std::to_string(i / 100)) /
+                     ("project-" + std::to_string(i));
+        Info& info = infos[p];
+        if constexpr (requires { info.path; })
+            info.path = p;
+        info.message = "Up to date";
+        info.branch = std::string(branches[i % 4]);
+        char hash[8];
+        std::snprintf(hash, sizeof(hash), "%07zx", i);
+        info.commit = hash;
+        info.commit_date = "2024-05-01 12:34:56";
+        info.commit_author = "Contributor Number " + std::to_string(i % 20);
+    }
+    size_t after = procutil::read_memory_usage_kb();
+    return after > before ? (after - before) * 1024 / count : 0;
+}
+} // namespace
+
+TEST_CASE("repository record memory", "[!benchmark]") {
+    std::cout << "sizeof RepoInfo before=" << sizeof(LegacyRepoInfo)
+              << " after=" << sizeof(RepoInfo) << "\n";
+    for (size_t count : {size_t(10000), size_t(100000)}) {
+        size_t legacy = rss_per_repo<LegacyRepoInfo>(count);
+        size_t current = rss_per_repo<RepoInfo>(count);
+        std::cout << count << " repos: rss per repo before=" << legacy << "B after=" << current
+                  << "B\n";
+    }
+}
@@ -3,6 +3,7 @@
 #include "test_common.hpp"
 #include "tui.hpp"
 #include "ui_loop.hpp"
+#include "traffic_budget.hpp"
 // Forward declaration of draw_cli from ui_loop.cpp
 void draw_cli(const std::vector<fs::path>& all_repos,
               const std::map<fs::path, RepoInfo>& repo_infos, int seconds_left, bool scanning,
@@ -12,10 +13,10 @@ void draw_cli(const std::vector<fs::path>& all_repos,
 TEST_CASE("draw_cli shows active repo count") {
     std::vector<fs::path> repos = {"/a", "/b", "/c", "/d"};
     std::map<fs::path, RepoInfo> infos;
-    infos[repos[0]] = RepoInfo{repos[0], RS_UP_TO_DATE, "", "", "", "", "", 0, "", 0, false, false};
-    infos[repos[1]] = RepoInfo{repos[1], RS_SKIPPED, "", "", "", "", "", 0, "", 0, false, false};
-    infos[repos[2]] = RepoInfo{repos[2], RS_NOT_GIT, "", "", "", "", "", 0, "", 0, false, false};
-    infos[repos[3]] = RepoInfo{repos[3], RS_PENDING, "", "", "", "", "", 0, "", 0, false, false};
+    infos[repos[0]] = RepoInfo{.status = RS_UP_TO_DATE};
+    infos[repos[1]] = RepoInfo{.status = RS_SKIPPED};
+    infos[repos[2]] = RepoInfo{.status = RS_NOT_GIT};
+    infos[repos[3]] = RepoInfo{.status = RS_PENDING};
     std::ostringstream oss;
     auto* old = std::cout.rdbuf(oss.rdbuf());
     draw_cli(repos, infos, 10, false, "Idle", true, false, -1, true, false, false, '*');
@@ -27,19 +28,31 @@ TEST_CASE("draw_cli shows active repo count") {
 TEST_CASE("render_header reports repo count") {
     std::vector<fs::path> repos = {"/a", "/b", "/c", "/d"};
     std::map<fs::path, RepoInfo> infos;
-    infos[repos[0]] = RepoInfo{repos[0], RS_UP_TO_DATE, "", "", "", "", "", 0, "", 0, false, false};
-    infos[repos[1]] = RepoInfo{repos[1], RS_SKIPPED, "", "", "", "", "", 0, "", 0, false, false};
-    infos[repos[2]] = RepoInfo{repos[2], RS_NOT_GIT, "", "", "", "", "", 0, "", 0, false, false};
-    infos[repos[3]] = RepoInfo{repos[3], RS_PENDING, "", "", "", "", "", 0, "", 0, false, false};
+    infos[repos[0]] = RepoInfo{.status = RS_UP_TO_DATE};
+    infos[repos[1]] = RepoInfo{.status = RS_SKIPPED};
+    infos[repos[2]] = RepoInfo{.status = RS_NOT_GIT};
+    infos[repos[3]] = RepoInfo{.status = RS_PENDING};
     TuiColors colors = make_tui_colors(true, "", TuiTheme{});
     std::string out =
         render_header(repos, infos, 5, 1, false, "Idle", false, true, "", -1, false, colors);
     REQUIRE(out.find("Repos: 2/4\n") != std::string::npos);
 }
 
+TEST_CASE("render_stats shows traffic budget") {
+    TuiColors colors = make_tui_colors(true, "", TuiTheme{});
+    procutil::TrafficBudget budget(2 * 1024 * 1024, 0);
+    budget.add(1024 * 1024);
+    std::string out = render_stats(false, false, false, false, false, false, colors, &budget);
+    REQUIRE(out.find("Traffic: cycle 1 MB/2 MB  day 1 MB\n") != std::string::npos);
+    budget.add(1024 * 1024);
+    out = render_stats(false, false, false, false, false, false, colors, &budget);
+    REQUIRE(out.find("(exhausted)") != std::string::npos);
+    REQUIRE(render_stats(false, false, false, false, false, false, colors).empty());
+}
+
 TEST_CASE("render_repo_entry censors names") {
     fs::path repo = "/foo/bar";
-    RepoInfo ri{repo, RS_UP_TO_DATE, "", "", "", "", "", 0, "", 0, false, false};
+    RepoInfo ri{.status = RS_UP_TO_DATE};
     TuiColors colors = make_tui_colors(true, "", TuiTheme{});
     std::string out =
         render_repo_entry(repo, ri, true, true, false, false, false, true, '#', colors);
@@ -47,6 +60,19 @@ TEST_CASE("render_repo_entry censors names") {
     REQUIRE(out.find("###") != std::string::npos);
 }
 
+TEST_CASE("render_repo_entry shows object store counts") {
+    fs::path repo = "/foo/bar";
+    RepoInfo ri{.status = RS_UP_TO_DATE};
+    TuiColors colors = make_tui_colors(true, "", TuiTheme{});
+    std::string out =
+        render_repo_entry(repo, ri, true, true, false, false, false, false, '#', colors);
+    REQUIRE(out.find("packs") == std::string::npos);
+    ri.pack_count = 12;
+    ri.loose_objects = 512;
+    out = render_repo_entry(repo, ri, true, true, false, false, false, false, '#', colors);
+    REQUIRE(out.find("[12 packs, ~512 loose]") != std::string::npos);
+}
+
 TEST_CASE("theme file overrides colors") {
     fs::path theme_path =
         fs::path(__FILE__).parent_path() / ".." / "examples" / "themes" / "light.json";
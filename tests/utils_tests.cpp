@@ -9,6 +9,14 @@ TEST_CASE("Resource helpers") {
     std::this_thread::sleep_for(std::chrono::seconds(1));
     REQUIRE(procutil::get_thread_count() >= 1);
     REQUIRE(procutil::get_virtual_memory_kb() >= procutil::get_memory_usage_mb() * 1024);
+#if defined(__linux__) || defined(_WIN32) || defined(__APPLE__)
+    std::vector<char> block(32 * 1024 * 1024, 1);
+    REQUIRE(procutil::read_memory_usage_kb() >= block.size() / 1024);
+    block = {};
+    block.shrink_to_fit();
+    procutil::release_free_memory();
+    REQUIRE(procutil::read_memory_usage_kb() > 0);
+#endif
 }
 
 TEST_CASE("Lock file guards instances") {
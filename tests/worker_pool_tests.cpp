@@ -0,0 +1,140 @@
+#include "test_common.hpp"
+#include "worker_pool.hpp"
+
+TEST_CASE("WorkerPool runs every submitted task") {
+    procutil::WorkerPool pool(3);
+    std::atomic<int> count{0};
+    std::vector<std::future<void>> done;
+    for (int i = 0; i < 50; ++i)
+        done.push_back(pool.submit([&]() { ++count; }));
+    for (auto& d : done)
+        d.get();
+    REQUIRE(count == 50);
+}
+
+TEST_CASE("WorkerPool runs tasks submitted from a worker") {
+    procutil::WorkerPool pool(2);
+    std::atomic<int> count{0};
+    auto outer = pool.submit([&]() {
+        std::vector<std::future<void>> inner;
+        for (int i = 0; i < 10; ++i)
+            inner.push_back(pool.submit([&]() { ++count; }));
+        // The other worker steals what this one queued
+        for (auto& f : inner)
+            f.wait();
+    });
+    outer.get();
+    REQUIRE(count == 10);
+}
+
+TEST_CASE("WorkerPool reports task exceptions through the future") {
+    procutil::WorkerPool pool(1);
+    auto f = pool.submit([]() { throw std::runtime_error("boom"); });
+    REQUIRE_THROWS_AS(f.get(), std::runtime_error);
+    // The worker survives
+    bool ran = false;
+    pool.submit([&]() { ran = true; }).get();
+    REQUIRE(ran);
+}
+
+TEST_CASE("WorkerPool resizes without losing queued tasks") {
+    procutil::WorkerPool pool(4);
+    REQUIRE(pool.size() == 4);
+    std::promise<void> gate;
+    std::shared_future<void> open = gate.get_future().share();
+    std::atomic<int> count{0};
+    std::vector<std::future<void>> done;
+    for (int i = 0; i < 20; ++i) {
+        done.push_back(pool.submit([&, open]() {
+            open.wait();
+            ++count;
+        }));
+    }
+    std::thread opener([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        gate.set_value();
+    });
+    pool.resize(1);
+    opener.join();
+    REQUIRE(pool.size() == 1);
+    for (auto& d : done)
+        d.get();
+    REQUIRE(count == 20);
+    pool.resize(3);
+    REQUIRE(pool.size() == 3);
+    pool.resize(0);
+    REQUIRE(pool.size() == 1);
+}
+
+TEST_CASE("WorkerPool shrinks without waiting for running tasks") {
+    procutil::WorkerPool pool(2);
+    std::promise<void> gate;
+    std::shared_future<void> open = gate.get_future().share();
+    std::promise<void> started_a, started_b;
+    auto a = pool.submit([&, open]() {
+        started_a.set_value();
+        open.wait();
+    });
+    auto b = pool.submit([&, open]() {
+        started_b.set_value();
+        open.wait();
+    });
+    started_a.get_future().wait();
+    started_b.get_future().wait();
+    // Both workers are busy until the gate opens; the shrink must not wait
+    pool.resize(1);
+    REQUIRE(pool.size() == 1);
+    REQUIRE(a.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+    REQUIRE(b.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+    gate.set_value();
+    a.get();
+    b.get();
+    bool ran = false;
+    pool.submit([&]() { ran = true; }).get();
+    REQUIRE(ran);
+    // Joins the worker removed above, which has returned by now
+    pool.resize(2);
+    REQUIRE(pool.size() == 2);
+}
+
+TEST_CASE("WorkerPool does not shrink below a held reservation") {
+    procutil::WorkerPool pool(1);
+    auto hold = pool.reserve(3);
+    REQUIRE(pool.size() == 3);
+    pool.resize(1);
+    REQUIRE(pool.size() == 3);
+    // Three tasks that each wait for the other two need all three workers
+    std::promise<void> ready[3];
+    std::shared_future<void> all[3];
+    for (int i = 0; i < 3; ++i)
+        all[i] = ready[i].get_future().share();
+    std::vector<std::future<void>> done;
+    for (int i = 0; i < 3; ++i) {
+        done.push_back(pool.submit([&, i]() {
+            ready[i].set_value();
+            for (auto& f : all)
+                f.wait();
+        }));
+    }
+    for (auto& d : done)
+        REQUIRE(d.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    hold.release();
+    REQUIRE(pool.size() == 1);
+}
+
+TEST_CASE("WorkerPool keeps its threads across batches") {
+    procutil::WorkerPool pool(4);
+    auto batch = [&]() {
+        std::vector<std::future<void>> done;
+        for (int i = 0; i < 16; ++i)
+            done.push_back(pool.submit(
+                []() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }));
+        for (auto& d : done)
+            d.get();
+    };
+    batch();
+    std::size_t before = read_thread_count();
+    for (int i = 0; i < 5; ++i)
+        batch();
+    REQUIRE(read_thread_count() == before);
+}